@@ -11,18 +11,19 @@
 
 #include <stdint.h>
 
-#include "base/callback.h"
+#include "base/inline_once_callback.h"
 
 namespace base {
 
-// A OnceCallback specialization that takes a single int parameter. Usually this
-// is used to report a byte count or network error code.
-using CompletionOnceCallback = OnceCallback<void(int)>;
+// A once callback that takes a single int parameter. Usually this is used to
+// report a byte count or network error code. It is an InlineOnceCallback, so
+// that binding a completion to a socket doesn't allocate.
+using CompletionOnceCallback = InlineOnceCallback<void(int)>;
 
-// 64bit version of the OnceCallback specialization that takes a single int64_t
+// 64bit version of CompletionOnceCallback that takes a single int64_t
 // parameter. Usually this is used to report a file offset, size or network
 // error code.
-using Int64CompletionOnceCallback = OnceCallback<void(int64_t)>;
+using Int64CompletionOnceCallback = InlineOnceCallback<void(int64_t)>;
 
 }  // namespace base
 
@@ -0,0 +1,91 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_MPSC_QUEUE_H_
+#define BASE_CONTAINERS_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+namespace base {
+
+// An unbounded, lock-free, multi-producer single-consumer FIFO queue, based
+// on Dmitry Vyukov's intrusive MPSC node-based queue.
+//
+// Push() may be called from any thread concurrently and is wait-free: it
+// costs one atomic exchange and one store. Pop() must only be called from a
+// single consumer thread at a time.
+//
+// A producer which has been preempted in the middle of Push() makes the
+// elements pushed after it invisible to Pop() until it resumes, so Pop()
+// returning false doesn't mean that every Push() has been observed. Callers
+// which need that guarantee have to pair Push() with a wakeup which is sent
+// after Push() returns, like EventLoop::PostTask() does.
+//
+// |T| must be default constructible and movable.
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue()
+      : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+  MpscQueue(const MpscQueue& other) = delete;
+  MpscQueue& operator=(const MpscQueue& other) = delete;
+
+  // Elements which have not been popped are destroyed. There must be no
+  // concurrent Push() at this point.
+  ~MpscQueue() {
+    Node* node = tail_;
+    while (node) {
+      Node* next = node->next.load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  // Thread-safe.
+  void Push(T value) {
+    Node* node = new Node(std::move(value));
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Consumer only. Moves the oldest element into |value| and returns true, or
+  // returns false if no element is visible.
+  bool Pop(T* value) {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (!next) return false;
+
+    // |next| becomes the new stub node once its value has been moved out.
+    *value = std::move(next->value);
+    tail_ = next;
+    delete tail;
+    return true;
+  }
+
+  // Consumer only. Returns true if no element is visible to Pop().
+  bool empty() const {
+    return tail_->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T value) : value(std::move(value)) {}
+
+    std::atomic<Node*> next{nullptr};
+    T value;
+  };
+
+  // The most recently pushed node. Shared by the producers.
+  std::atomic<Node*> head_;
+  // Keeps |tail_| off the cache line the producers write to.
+  char padding_[64 - sizeof(std::atomic<Node*>)];
+  // The stub node preceding the oldest element. Owned by the consumer.
+  Node* tail_;
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_MPSC_QUEUE_H_
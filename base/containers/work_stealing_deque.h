@@ -0,0 +1,152 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_WORK_STEALING_DEQUE_H_
+#define BASE_CONTAINERS_WORK_STEALING_DEQUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace base {
+
+// A lock-free, growable work-stealing deque, after Chase and Lev, "Dynamic
+// Circular Work-Stealing Deque", with the memory orderings of Lê et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models".
+//
+// A single owner thread pushes and pops at the bottom, in LIFO order, which
+// keeps the work it has just produced hot in its cache. Any other thread may
+// steal from the top, in FIFO order. Push() and Pop() only synchronize with
+// thieves when the deque is about to run empty.
+//
+// |T| must be trivially copyable, since a thief may read an element which is
+// being overwritten; it is typically a pointer.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  static_assert(std::is_trivially_copyable<T>::value,
+                "WorkStealingDeque requires a trivially copyable type");
+
+  explicit WorkStealingDeque(size_t initial_capacity = 64)
+      : top_(0), bottom_(0) {
+    size_t capacity = 1;
+    while (capacity < initial_capacity) capacity <<= 1;
+    arrays_.emplace_back(new Array(capacity));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+  WorkStealingDeque(const WorkStealingDeque& other) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+  // Owner only.
+  void Push(T value) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    Array* array = array_.load(std::memory_order_relaxed);
+    if (bottom - top > static_cast<int64_t>(array->capacity) - 1)
+      array = Grow(array, top, bottom);
+    array->Put(bottom, value);
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Owner only. Moves the most recently pushed element into |value| and
+  // returns true, or returns false if the deque is empty.
+  bool Pop(T* value) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* array = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    *value = array->Get(bottom);
+    if (top < bottom) return true;
+
+    // This is the last element, which a thief may be taking as well.
+    bool won = top_.compare_exchange_strong(top, top + 1,
+                                            std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return won;
+  }
+
+  // Thread-safe. Moves the oldest element into |value| and returns true.
+  // Returns false if the deque is empty or if another thread took the
+  // element first.
+  bool Steal(T* value) {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) return false;
+
+    Array* array = array_.load(std::memory_order_acquire);
+    T result = array->Get(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    *value = result;
+    return true;
+  }
+
+  // Thread-safe, but only a hint unless called by the owner.
+  bool empty() const {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    return top >= bottom;
+  }
+
+ private:
+  struct Array {
+    explicit Array(size_t capacity)
+        : capacity(capacity),
+          mask(capacity - 1),
+          buffer(new std::atomic<T>[capacity]) {}
+
+    T Get(int64_t index) const {
+      return buffer[index & mask].load(std::memory_order_relaxed);
+    }
+    void Put(int64_t index, T value) {
+      buffer[index & mask].store(value, std::memory_order_relaxed);
+    }
+
+    const size_t capacity;
+    const size_t mask;
+    std::unique_ptr<std::atomic<T>[]> buffer;
+  };
+
+  // Replaces |array| with one twice as large. The old arrays are kept until
+  // the deque is destroyed, since thieves may still be reading from them.
+  Array* Grow(Array* array, int64_t top, int64_t bottom) {
+    arrays_.emplace_back(new Array(array->capacity * 2));
+    Array* grown = arrays_.back().get();
+    for (int64_t i = top; i < bottom; ++i) grown->Put(i, array->Get(i));
+    array_.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  static constexpr size_t kCacheLineSize = 64;
+
+  // Keeps |top_| and |bottom_| on separate cache lines, since thieves only
+  // write |top_|. Padding rather than alignas(), which operator new ignores
+  // before C++17.
+  std::atomic<int64_t> top_;
+  char top_padding_[kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom_;
+  char bottom_padding_[kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  std::atomic<Array*> array_;
+  // Every array this deque has used. Owner only.
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_WORK_STEALING_DEQUE_H_
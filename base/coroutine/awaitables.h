@@ -0,0 +1,163 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Awaitables for the asynchronous operations of EventLoop and the socket
+// classes, to be co_awaited from a Task. See base/coroutine/task.h.
+//
+// The socket awaitables resolve to the net error code or byte count the
+// operation completes with, whether it completes synchronously or not. The
+// awaitable and its callback live in the coroutine frame, so awaiting costs
+// no allocation beyond what the socket itself does. A coroutine must not be
+// destroyed while it awaits an operation of a socket which outlives it.
+
+#ifndef BASE_COROUTINE_AWAITABLES_H_
+#define BASE_COROUTINE_AWAITABLES_H_
+
+#include "base/coroutine/task.h"
+
+#if defined(BASE_HAS_COROUTINES)
+
+#include <coroutine>
+#include <memory>
+#include <utility>
+
+#include "absl/time/time.h"
+#include "base/completion_once_callback.h"
+#include "base/event_loop/event_loop.h"
+#include "base/event_loop/timing_wheel.h"
+#include "base/io_buffer.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/server_socket.h"
+#include "base/socket/socket_errors.h"
+#include "base/socket/stream_socket.h"
+
+namespace base {
+
+namespace internal {
+
+// Awaits an operation started by |start|, which is called with a
+// CompletionOnceCallback and returns a net error code, or ERR_IO_PENDING if
+// the callback is going to be called.
+template <typename Start>
+class CompletionAwaiter {
+ public:
+  explicit CompletionAwaiter(Start start) : start_(std::move(start)) {}
+  CompletionAwaiter(const CompletionAwaiter& other) = delete;
+  CompletionAwaiter& operator=(const CompletionAwaiter& other) = delete;
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    int rv = start_(CompletionOnceCallback([this](int result) {
+      result_ = result;
+      handle_.resume();
+    }));
+    if (rv == ERR_IO_PENDING) return true;
+    result_ = rv;
+    return false;
+  }
+  int await_resume() const noexcept { return result_; }
+
+ private:
+  Start start_;
+  std::coroutine_handle<> handle_;
+  int result_ = OK;
+};
+
+template <typename Start>
+CompletionAwaiter<Start> MakeCompletionAwaiter(Start start) {
+  return CompletionAwaiter<Start>(std::move(start));
+}
+
+class SleepAwaiter : private TimingWheel::Entry {
+ public:
+  explicit SleepAwaiter(absl::Duration delay) : delay_(delay) {}
+
+  bool await_ready() const noexcept { return delay_ <= absl::ZeroDuration(); }
+  void await_suspend(std::coroutine_handle<> handle) {
+    EventLoop* event_loop = EventLoop::Current();
+    DCHECK(event_loop) << "AsyncSleep() needs an EventLoop";
+    handle_ = handle;
+    event_loop->ScheduleTimer(this, delay_);
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  // TimingWheel::Entry methods
+  void OnExpired() override { handle_.resume(); }
+
+  absl::Duration delay_;
+  std::coroutine_handle<> handle_;
+};
+
+}  // namespace internal
+
+// Resumes the coroutine on the current EventLoop once |delay| has elapsed.
+// The timer lives in the coroutine frame.
+inline internal::SleepAwaiter AsyncSleep(absl::Duration delay) {
+  return internal::SleepAwaiter(delay);
+}
+
+// Socket::Read() and Socket::Write(), and those of UDPSocket.
+template <typename SocketType>
+auto AsyncRead(SocketType* socket, std::shared_ptr<IOBuffer> buf,
+               int buf_len) {
+  return internal::MakeCompletionAwaiter(
+      [socket, buf = std::move(buf), buf_len](CompletionOnceCallback callback) {
+        return socket->Read(buf, buf_len, std::move(callback));
+      });
+}
+
+template <typename SocketType>
+auto AsyncWrite(SocketType* socket, std::shared_ptr<IOBuffer> buf,
+                int buf_len) {
+  return internal::MakeCompletionAwaiter(
+      [socket, buf = std::move(buf), buf_len](CompletionOnceCallback callback) {
+        return socket->Write(buf, buf_len, std::move(callback));
+      });
+}
+
+// StreamSocket::Connect().
+inline auto AsyncConnect(StreamSocket* socket) {
+  return internal::MakeCompletionAwaiter(
+      [socket](CompletionOnceCallback callback) {
+        return socket->Connect(std::move(callback));
+      });
+}
+
+// ServerSocket::Accept(). |socket| receives the accepted connection.
+inline auto AsyncAccept(ServerSocket* server_socket,
+                        std::unique_ptr<StreamSocket>* socket) {
+  return internal::MakeCompletionAwaiter(
+      [server_socket, socket](CompletionOnceCallback callback) {
+        return server_socket->Accept(socket, std::move(callback));
+      });
+}
+
+// RecvFrom() and SendTo() of UDPSocket and DatagramServerSocket.
+template <typename SocketType>
+auto AsyncRecvFrom(SocketType* socket, std::shared_ptr<IOBuffer> buf,
+                   int buf_len, IPEndPoint* address) {
+  return internal::MakeCompletionAwaiter(
+      [socket, buf = std::move(buf), buf_len,
+       address](CompletionOnceCallback callback) {
+        return socket->RecvFrom(buf, buf_len, address, std::move(callback));
+      });
+}
+
+template <typename SocketType>
+auto AsyncSendTo(SocketType* socket, std::shared_ptr<IOBuffer> buf,
+                 int buf_len, const IPEndPoint& address) {
+  return internal::MakeCompletionAwaiter(
+      [socket, buf = std::move(buf), buf_len,
+       address](CompletionOnceCallback callback) {
+        return socket->SendTo(buf, buf_len, address, std::move(callback));
+      });
+}
+
+}  // namespace base
+
+#endif  // defined(BASE_HAS_COROUTINES)
+
+#endif  // BASE_COROUTINE_AWAITABLES_H_
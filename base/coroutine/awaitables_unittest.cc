@@ -0,0 +1,136 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/coroutine/awaitables.h"
+
+#if defined(BASE_HAS_COROUTINES)
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+#include "base/socket/ip_address.h"
+#include "base/socket/tcp_client_socket.h"
+#include "base/socket/tcp_server_socket.h"
+#include "base/socket/udp_server_socket.h"
+#include "base/test/socket_test_util.h"
+#include "base/time/time_util.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+Task<int> Square(int value) {
+  co_await AsyncSleep(absl::Milliseconds(1));
+  co_return value * value;
+}
+
+Task<> SumSquares(int count, int* sum) {
+  for (int i = 0; i < count; ++i) *sum += co_await Square(i);
+  EventLoop::Current()->Quit();
+}
+
+Task<> Accept(TCPServerSocket* server_socket, std::string* received) {
+  std::unique_ptr<StreamSocket> socket;
+  int rv = co_await AsyncAccept(server_socket, &socket);
+  EXPECT_EQ(OK, rv);
+
+  auto buf = std::make_shared<IOBufferWithSize>(64);
+  while ((rv = co_await AsyncRead(socket.get(), buf, buf->size())) > 0)
+    received->append(buf->data(), rv);
+  EXPECT_EQ(0, rv);
+  EventLoop::Current()->Quit();
+}
+
+// Coroutine parameters are taken by value, since the arguments may be gone
+// by the time the coroutine resumes.
+Task<> Connect(IPEndPoint address, std::string message) {
+  AddressList addresses(address);
+  TCPClientSocket socket(addresses);
+  EXPECT_EQ(OK, co_await AsyncConnect(&socket));
+
+  auto buf = std::make_shared<StringIOBuffer>(message);
+  int rv = co_await AsyncWrite(&socket, buf, message.size());
+  EXPECT_EQ(static_cast<int>(message.size()), rv);
+}
+
+// Sends the first datagram |socket| receives back to where it came from.
+Task<> Echo(UDPServerSocket* socket) {
+  auto buf = std::make_shared<IOBufferWithSize>(64);
+  IPEndPoint address;
+  int rv = co_await AsyncRecvFrom(socket, buf, buf->size(), &address);
+  EXPECT_LT(0, rv);
+  if (rv <= 0) co_return;
+  EXPECT_EQ(rv, co_await AsyncSendTo(socket, buf, rv, address));
+}
+
+Task<> Ping(UDPServerSocket* socket, IPEndPoint address,
+            std::string* received) {
+  auto request = std::make_shared<StringIOBuffer>(std::string("ping"));
+  EXPECT_EQ(4, co_await AsyncSendTo(socket, request, 4, address));
+
+  auto buf = std::make_shared<IOBufferWithSize>(64);
+  IPEndPoint from;
+  int rv = co_await AsyncRecvFrom(socket, buf, buf->size(), &from);
+  if (rv > 0) received->assign(buf->data(), rv);
+  EXPECT_EQ(address, from);
+  EventLoop::Current()->Quit();
+}
+
+}  // namespace
+
+TEST(AwaitablesTest, SleepAndAwaitTask) {
+  EventLoop event_loop;
+  int sum = 0;
+  absl::Duration start = MonotonicNow();
+  Spawn(SumSquares(4, &sum));
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(0 + 1 + 4 + 9, sum);
+  EXPECT_GE(MonotonicNow() - start, absl::Milliseconds(4));
+}
+
+TEST(AwaitablesTest, StreamSocket) {
+  EventLoop event_loop;
+  TCPServerSocket server_socket;
+  ASSERT_EQ(OK, server_socket.Listen(
+                    IPEndPoint(IPAddress::IPv4Localhost(), 0), 1));
+  IPEndPoint address;
+  ASSERT_EQ(OK, server_socket.GetLocalAddress(&address));
+
+  std::string received;
+  Spawn(Accept(&server_socket, &received));
+  Spawn(Connect(address, "hello"));
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ("hello", received);
+}
+
+TEST(AwaitablesTest, DatagramSocket) {
+  EventLoop event_loop;
+  UDPServerSocket server_socket;
+  ASSERT_EQ(OK,
+            server_socket.Listen(IPEndPoint(IPAddress::IPv4Localhost(), 0)));
+  IPEndPoint address;
+  ASSERT_EQ(OK, server_socket.GetLocalAddress(&address));
+  UDPServerSocket client_socket;
+  ASSERT_EQ(OK,
+            client_socket.Listen(IPEndPoint(IPAddress::IPv4Localhost(), 0)));
+
+  std::string received;
+  Spawn(Echo(&server_socket));
+  Spawn(Ping(&client_socket, address, &received));
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ("ping", received);
+}
+
+}  // namespace base
+
+#endif  // defined(BASE_HAS_COROUTINES)
@@ -0,0 +1,222 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Task<T> is the return type of a C++20 coroutine which runs on an EventLoop.
+// Together with the awaitables of base/coroutine/awaitables.h, it turns the
+// CompletionOnceCallback state machines of the socket classes into straight
+// line code:
+//
+//   Task<> Echo(std::unique_ptr<StreamSocket> socket) {
+//     auto buf = std::make_shared<IOBufferWithSize>(4096);
+//     for (;;) {
+//       int rv = co_await AsyncRead(socket.get(), buf, buf->size());
+//       if (rv <= 0) co_return;
+//       rv = co_await AsyncWrite(socket.get(), buf, rv);
+//       if (rv < 0) co_return;
+//     }
+//   }
+//
+//   Spawn(Echo(std::move(socket)));
+//
+// The frames of the coroutines are allocated from the FramePool of the
+// current EventLoop, so that once the pool is warm, starting a coroutine per
+// connection costs no heap allocation. A coroutine has to finish or be
+// destroyed on the thread of the event loop it was started on.
+//
+// This is only available when the translation unit is compiled as C++20 or
+// later; BASE_HAS_COROUTINES is defined to 1 in that case. The rest of the
+// library stays C++14.
+
+#ifndef BASE_COROUTINE_TASK_H_
+#define BASE_COROUTINE_TASK_H_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && \
+    defined(__has_include)
+#if __has_include(<coroutine>)
+#define BASE_HAS_COROUTINES 1
+#endif
+#endif
+
+#if defined(BASE_HAS_COROUTINES)
+
+#include <stddef.h>
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "absl/types/optional.h"
+#include "base/event_loop/event_loop.h"
+#include "base/event_loop/frame_pool.h"
+#include "base/logging.h"
+
+namespace base {
+
+template <typename T = void>
+class Task;
+
+namespace internal {
+
+class PromiseBase {
+ public:
+  // Coroutine frames come from the FramePool of the current EventLoop.
+  static void* operator new(size_t size) {
+    EventLoop* event_loop = EventLoop::Current();
+    if (event_loop) return event_loop->frame_pool()->Allocate(size);
+    return ::operator new(FramePool::GetAllocationSize(size));
+  }
+  static void operator delete(void* ptr, size_t size) {
+    EventLoop* event_loop = EventLoop::Current();
+    if (event_loop) {
+      event_loop->frame_pool()->Free(ptr, size);
+    } else {
+      ::operator delete(ptr);
+    }
+  }
+
+  // Resumes the awaiting coroutine, if any, once the body has returned.
+  class FinalAwaiter {
+   public:
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      PromiseBase& promise = handle.promise();
+      if (promise.continuation_) return promise.continuation_;
+      if (promise.detached_) handle.destroy();
+      return std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() const noexcept { std::terminate(); }
+
+  void set_continuation(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+  }
+  void set_detached() { detached_ = true; }
+
+ private:
+  std::coroutine_handle<> continuation_;
+  // Set by Spawn(). The frame then destroys itself when the body returns.
+  bool detached_ = false;
+};
+
+template <typename T>
+class Promise : public PromiseBase {
+ public:
+  Task<T> get_return_object();
+
+  template <typename U>
+  void return_value(U&& value) {
+    value_.emplace(std::forward<U>(value));
+  }
+
+  T TakeValue() {
+    DCHECK(value_.has_value());
+    return std::move(*value_);
+  }
+
+ private:
+  absl::optional<T> value_;
+};
+
+template <>
+class Promise<void> : public PromiseBase {
+ public:
+  Task<void> get_return_object();
+
+  void return_void() const noexcept {}
+  void TakeValue() const noexcept {}
+};
+
+}  // namespace internal
+
+// A lazily started coroutine which yields a |T|. It starts when it is
+// co_awaited, and resumes the awaiting coroutine when it returns, without
+// going through the event loop. A Task which is destroyed before its body has
+// returned destroys the coroutine.
+template <typename T>
+class Task {
+ public:
+  using promise_type = internal::Promise<T>;
+
+  Task() = default;
+  Task(const Task& other) = delete;
+  Task& operator=(const Task& other) = delete;
+  Task(Task&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  bool is_null() const { return !handle_; }
+
+  auto operator co_await() && noexcept {
+    class Awaiter {
+     public:
+      explicit Awaiter(std::coroutine_handle<promise_type> handle)
+          : handle_(handle) {}
+
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().set_continuation(continuation);
+        return handle_;
+      }
+      T await_resume() { return handle_.promise().TakeValue(); }
+
+     private:
+      std::coroutine_handle<promise_type> handle_;
+    };
+    DCHECK(handle_);
+    return Awaiter(handle_);
+  }
+
+ private:
+  friend class internal::Promise<T>;
+  friend void Spawn(Task<void> task);
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Starts |task| on the current thread, which runs it until its first
+// suspension. The coroutine is destroyed once its body returns.
+inline void Spawn(Task<void> task) {
+  DCHECK(!task.is_null());
+  std::coroutine_handle<internal::Promise<void>> handle =
+      std::exchange(task.handle_, nullptr);
+  handle.promise().set_detached();
+  handle.resume();
+}
+
+namespace internal {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // defined(BASE_HAS_COROUTINES)
+
+#endif  // BASE_COROUTINE_TASK_H_
@@ -0,0 +1,234 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/epoll_backend.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <limits>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+uint32_t ModeToEvents(int mode) {
+  uint32_t events = 0;
+  if (mode & EventLoop::WATCH_READ) events |= EPOLLIN;
+  if (mode & EventLoop::WATCH_WRITE) events |= EPOLLOUT;
+  return events;
+}
+
+int EventsToMode(uint32_t events) {
+  int mode = 0;
+  // Errors and hang-ups are reported to both directions, like libevent does,
+  // so that the watcher sees them from the next read or write.
+  if (events & (EPOLLIN | EPOLLPRI | EPOLLERR | EPOLLHUP)) {
+    mode |= EventLoop::WATCH_READ;
+  }
+  if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+    mode |= EventLoop::WATCH_WRITE;
+  }
+  return mode;
+}
+
+int TimeoutToMilliseconds(absl::Duration timeout) {
+  if (timeout == absl::InfiniteDuration()) return -1;
+  if (timeout <= absl::ZeroDuration()) return 0;
+  // Round up so that a timer which is due in less than a millisecond doesn't
+  // make the event loop spin.
+  int64_t microseconds = absl::ToInt64Microseconds(timeout);
+  int64_t milliseconds = (microseconds + 999) / 1000;
+  if (milliseconds > std::numeric_limits<int>::max()) {
+    return std::numeric_limits<int>::max();
+  }
+  return static_cast<int>(milliseconds);
+}
+
+}  // namespace
+
+constexpr int EpollBackend::kMaxEvents;
+
+EpollBackend::EpollBackend() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+  PCHECK(epoll_fd_ >= 0) << "epoll_create1() failed";
+}
+
+EpollBackend::~EpollBackend() {
+  if (IGNORE_EINTR(close(epoll_fd_)) < 0) DPLOG(ERROR) << "close() failed";
+}
+
+bool EpollBackend::WatchFileDescriptor(
+    int fd, bool persistent, int mode,
+    EventLoop::FdWatchController* controller) {
+  // It's illegal to use this function to listen on 2 separate fds with the
+  // same |controller|.
+  if (controller->fd_ >= 0 && controller->fd_ != fd) {
+    NOTREACHED() << "FDs don't match" << controller->fd_ << "!=" << fd;
+    return false;
+  }
+
+  if (static_cast<size_t>(fd) >= entries_.size()) entries_.resize(fd + 1);
+  Entry* entry = &entries_[fd];
+
+  int old_mode = controller->mode_;
+  bool old_persistent = controller->persistent_;
+  if (controller->fd_ < 0) {
+    controller->fd_ = fd;
+    controller->prev_ = nullptr;
+    controller->next_ = entry->head;
+    if (entry->head) entry->head->prev_ = controller;
+    entry->head = controller;
+  }
+  controller->mode_ |= mode;
+  controller->persistent_ |= persistent;
+
+  // Nothing to do if the controller was already watching every direction of
+  // |mode|. Otherwise the file descriptor has to be re-armed even if some
+  // other controller is watching the same direction, since the readiness may
+  // already have been reported.
+  if ((mode & ~old_mode) == 0) return true;
+
+  if (!UpdateRegistration(fd, entry, GetInterestedEvents(*entry))) {
+    int saved_errno = errno;
+    if (old_mode == 0) {
+      Unwatch(controller);
+    } else {
+      controller->mode_ = old_mode;
+      controller->persistent_ = old_persistent;
+    }
+    errno = saved_errno;
+    return false;
+  }
+  return true;
+}
+
+bool EpollBackend::StopWatchingFileDescriptor(
+    EventLoop::FdWatchController* controller) {
+  if (controller->fd_ >= 0) Unwatch(controller);
+  return true;
+}
+
+bool EpollBackend::Poll(absl::Duration timeout) {
+  ApplyPendingChanges();
+
+  int count = epoll_wait(epoll_fd_, events_, kMaxEvents,
+                         TimeoutToMilliseconds(timeout));
+  if (count < 0) {
+    if (errno != EINTR) DPLOG(ERROR) << "epoll_wait() failed";
+    return false;
+  }
+
+  bool processed_io_events = false;
+  for (int i = 0; i < count; ++i) {
+    processed_io_events |=
+        Dispatch(events_[i].data.fd, EventsToMode(events_[i].events));
+  }
+  return processed_io_events;
+}
+
+// static
+uint32_t EpollBackend::GetInterestedEvents(const Entry& entry) {
+  int mode = 0;
+  for (EventLoop::FdWatchController* controller = entry.head; controller;
+       controller = controller->next_) {
+    mode |= controller->mode_;
+  }
+  return ModeToEvents(mode);
+}
+
+bool EpollBackend::UpdateRegistration(int fd, Entry* entry, uint32_t events) {
+  epoll_event event = {};
+  event.events = events | EPOLLET;
+  event.data.fd = fd;
+
+  // |registered_events| may be stale if |fd| has been closed and reused, in
+  // which case the kernel has already dropped the registration.
+  int op = entry->registered_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  int rv = epoll_ctl(epoll_fd_, op, fd, &event);
+  if (rv < 0 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+    rv = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+  } else if (rv < 0 && op == EPOLL_CTL_ADD && errno == EEXIST) {
+    rv = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+  }
+  if (rv < 0) {
+    DPLOG(ERROR) << "epoll_ctl failed(fd=" << fd << ")";
+    entry->registered_events = 0;
+    return false;
+  }
+
+  entry->registered_events = events;
+  return true;
+}
+
+void EpollBackend::Unwatch(EventLoop::FdWatchController* controller) {
+  int fd = controller->fd_;
+  Entry* entry = &entries_[fd];
+
+  if (controller->prev_) {
+    controller->prev_->next_ = controller->next_;
+  } else {
+    DCHECK_EQ(entry->head, controller);
+    entry->head = controller->next_;
+  }
+  if (controller->next_) controller->next_->prev_ = controller->prev_;
+  controller->prev_ = nullptr;
+  controller->next_ = nullptr;
+  controller->fd_ = -1;
+  controller->mode_ = 0;
+  controller->persistent_ = false;
+
+  if (!entry->pending) {
+    entry->pending = true;
+    pending_fds_.push_back(fd);
+  }
+}
+
+void EpollBackend::ApplyPendingChanges() {
+  for (int fd : pending_fds_) {
+    Entry* entry = &entries_[fd];
+    entry->pending = false;
+
+    uint32_t events = GetInterestedEvents(*entry);
+    if (events == entry->registered_events) continue;
+
+    if (events) {
+      UpdateRegistration(fd, entry, events);
+      continue;
+    }
+    // This fails if |fd| has been closed in the meantime, which is fine since
+    // closing it has removed the registration.
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    entry->registered_events = 0;
+  }
+  pending_fds_.clear();
+}
+
+bool EpollBackend::Dispatch(int fd, int ready_mode) {
+  uint64_t epoch = ++dispatch_epoch_;
+  bool called = false;
+  for (;;) {
+    // A callback may watch or stop watching |fd|, or watch a file descriptor
+    // which makes |entries_| grow, so the list is looked up again every time.
+    EventLoop::FdWatchController* controller = entries_[fd].head;
+    while (controller && (controller->dispatch_epoch_ == epoch ||
+                          (controller->mode_ & ready_mode) == 0)) {
+      controller = controller->next_;
+    }
+    if (!controller) break;
+
+    controller->dispatch_epoch_ = epoch;
+    int mode = controller->mode_ & ready_mode;
+    if (!controller->persistent_) Unwatch(controller);
+    called = true;
+    controller->OnFileReady(fd, mode);
+  }
+  return called;
+}
+
+}  // namespace internal
+}  // namespace base
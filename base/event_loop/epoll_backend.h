@@ -0,0 +1,90 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_EPOLL_BACKEND_H_
+#define BASE_EVENT_LOOP_EPOLL_BACKEND_H_
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include <vector>
+
+#include "base/event_loop/event_loop_backend.h"
+
+namespace base {
+namespace internal {
+
+// EventLoopBackend which drives epoll(7) directly.
+//
+// Every file descriptor is registered once, edge-triggered, with the union of
+// the interests of the controllers watching it. A controller which starts
+// watching a new direction re-arms the file descriptor with EPOLL_CTL_MOD, so
+// that readiness which has already been reported is reported again. Dropped
+// interests are only applied right before epoll_wait(), so stopping and
+// starting to watch within the same iteration costs at most one epoll_ctl().
+class EpollBackend : public EventLoopBackend {
+ public:
+  EpollBackend();
+  EpollBackend(const EpollBackend& other) = delete;
+  EpollBackend& operator=(const EpollBackend& other) = delete;
+  ~EpollBackend() override;
+
+  // EventLoopBackend methods
+  bool WatchFileDescriptor(int fd, bool persistent, int mode,
+                           EventLoop::FdWatchController* controller) override;
+  bool StopWatchingFileDescriptor(
+      EventLoop::FdWatchController* controller) override;
+  bool Poll(absl::Duration timeout) override;
+
+  // Becomes readable when Poll() would call a watcher.
+  int epoll_fd() const { return epoll_fd_; }
+
+ private:
+  // The state of a file descriptor, indexed by its value in |entries_|.
+  struct Entry {
+    // The controllers watching the file descriptor.
+    EventLoop::FdWatchController* head = nullptr;
+    // The events the file descriptor is registered for, or 0 if it isn't
+    // registered.
+    uint32_t registered_events = 0;
+    // Whether the file descriptor is in |pending_fds_|.
+    bool pending = false;
+  };
+
+  // The maximum number of events fetched by a single epoll_wait().
+  static constexpr int kMaxEvents = 256;
+
+  // Returns the events the controllers of |entry| are interested in.
+  static uint32_t GetInterestedEvents(const Entry& entry);
+
+  // Registers |fd| for |events| with EPOLL_CTL_MOD or EPOLL_CTL_ADD. Returns
+  // false and sets errno on failure.
+  bool UpdateRegistration(int fd, Entry* entry, uint32_t events);
+
+  // Removes |controller| from the file descriptor it watches, whose
+  // registration is updated by the next call to ApplyPendingChanges().
+  void Unwatch(EventLoop::FdWatchController* controller);
+
+  // Applies the registration changes Unwatch() has deferred.
+  void ApplyPendingChanges();
+
+  // Calls the controllers of |fd| which are interested in |ready_mode|.
+  // Returns true if any was called.
+  bool Dispatch(int fd, int ready_mode);
+
+  int epoll_fd_;
+  std::vector<Entry> entries_;
+  std::vector<int> pending_fds_;
+
+  // Incremented for every Dispatch() so that a controller isn't called twice
+  // for the same event when the list of |fd| changes during a callback.
+  uint64_t dispatch_epoch_ = 0;
+
+  epoll_event events_[kMaxEvents];
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_EPOLL_BACKEND_H_
@@ -8,14 +8,114 @@
 
 #include "base/event_loop/event_loop.h"
 
+#include <algorithm>
+#include <utility>
+
 #include "base/auto_reset.h"
+#include "base/event_loop/event_loop_backend.h"
+#include "base/event_loop/libevent_backend.h"
 #include "base/logging.h"
 #include "base/no_destructor.h"
-#include "event2/event_compat.h"
-#include "event2/event_struct.h"
+#include "base/time/time_util.h"
+#include "event2/util.h"
+
+#if defined(OS_POSIX)
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+#endif
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/eventfd.h>
+
+#include "base/event_loop/epoll_backend.h"
+#endif
+
+#if defined(OS_LINUX)
+#include "base/event_loop/io_uring_backend.h"
+#endif
 
 namespace base {
 
+namespace {
+
+// The granularity of the timers. Deadlines are rounded up to it.
+constexpr absl::Duration kTimerTickDuration = absl::Milliseconds(1);
+
+// The maximum number of posted tasks of each priority to run before going
+// back to I/O. Best-effort tasks are limited by time instead.
+constexpr int kMaxPostedTasksPerIteration = 64;
+
+constexpr absl::Duration kDefaultBestEffortTaskBudget = absl::Milliseconds(1);
+
+// A task posted by EventLoop::PostDelayedTask(). It owns itself while it is
+// scheduled.
+class DelayedTask : public TimingWheel::Entry {
+ public:
+  explicit DelayedTask(OnceClosure task) : task_(std::move(task)) {}
+  DelayedTask(const DelayedTask& other) = delete;
+  DelayedTask& operator=(const DelayedTask& other) = delete;
+  ~DelayedTask() override = default;
+
+ private:
+  // TimingWheel::Entry methods
+  void OnExpired() override {
+    OnceClosure task = std::move(task_);
+    delete this;
+    std::move(task).Run();
+  }
+
+  void OnDiscarded() override { delete this; }
+
+  OnceClosure task_;
+};
+
+// Creates the backend for |*backend|, which is updated if another one has to
+// be used instead.
+std::unique_ptr<internal::EventLoopBackend> CreateBackend(
+    EventLoop::Backend* backend) {
+  switch (*backend) {
+    case EventLoop::Backend::kLibevent:
+      return std::unique_ptr<internal::EventLoopBackend>(
+          new internal::LibeventBackend());
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    case EventLoop::Backend::kEpoll:
+      return std::unique_ptr<internal::EventLoopBackend>(
+          new internal::EpollBackend());
+#endif
+#if defined(OS_LINUX)
+    case EventLoop::Backend::kIoUring: {
+      std::unique_ptr<internal::IoUringBackend> io_uring_backend =
+          internal::IoUringBackend::Create();
+      if (io_uring_backend) return io_uring_backend;
+      LOG(WARNING) << "io_uring is not available, falling back to epoll";
+      *backend = EventLoop::Backend::kEpoll;
+      return std::unique_ptr<internal::EventLoopBackend>(
+          new internal::EpollBackend());
+    }
+#endif
+  }
+  NOTREACHED();
+  return nullptr;
+}
+
+}  // namespace
+
+class EventLoop::WakeupWatcher : public EventLoop::FdWatcher {
+ public:
+  explicit WakeupWatcher(EventLoop* event_loop) : event_loop_(event_loop) {}
+  WakeupWatcher(const WakeupWatcher& other) = delete;
+  WakeupWatcher& operator=(const WakeupWatcher& other) = delete;
+
+  // EventLoop::FdWatcher methods
+  void OnFileCanRead(int fd) override { event_loop_->OnWakeup(); }
+  void OnFileCanWrite(int fd) override {}
+
+ private:
+  EventLoop* const event_loop_;
+};
+
 EventLoop::FdWatcher::FdWatcher() = default;
 
 EventLoop::FdWatcher::~FdWatcher() = default;
@@ -23,7 +123,7 @@ EventLoop::FdWatcher::~FdWatcher() = default;
 EventLoop::FdWatchController::FdWatchController() = default;
 
 EventLoop::FdWatchController::~FdWatchController() {
-  if (event_) {
+  if (backend_) {
     CHECK(StopWatchingFileDescriptor());
   }
   if (was_destroyed_) {
@@ -33,53 +133,134 @@ EventLoop::FdWatchController::~FdWatchController() {
 }
 
 bool EventLoop::FdWatchController::StopWatchingFileDescriptor() {
-  std::unique_ptr<event> e = ReleaseEvent();
-  if (!e) return true;
+  if (!backend_) return true;
 
-  // event_del() is a no-op if the event isn't active.
-  int rv = event_del(e.get());
-  event_loop_ = nullptr;
+  bool rv = backend_->StopWatchingFileDescriptor(this);
+  backend_ = nullptr;
   watcher_ = nullptr;
-  return (rv == 0);
+  return rv;
 }
 
-void EventLoop::FdWatchController::Init(std::unique_ptr<event> e) {
+void EventLoop::FdWatchController::Init(event* e) {
   DCHECK(e);
   DCHECK(!event_);
 
-  event_ = std::move(e);
+  event_ = e;
 }
 
-std::unique_ptr<event> EventLoop::FdWatchController::ReleaseEvent() {
-  return std::move(event_);
+event* EventLoop::FdWatchController::ReleaseEvent() {
+  event* e = event_;
+  event_ = nullptr;
+  return e;
 }
 
 void EventLoop::FdWatchController::set_watcher(FdWatcher* watcher) {
   watcher_ = watcher;
 }
 
-void EventLoop::FdWatchController::set_event_loop(EventLoop* event_loop) {
-  event_loop_ = event_loop;
+void EventLoop::FdWatchController::set_backend(
+    internal::EventLoopBackend* backend) {
+  backend_ = backend;
 }
 
 void EventLoop::FdWatchController::OnFileCanRead(int fd) {
-  watcher_->OnFileCanRead(fd);
+  // The watcher may destroy |this|.
+  EventLoop* event_loop = event_loop_;
+  FdWatcher* watcher = watcher_;
+  if (!event_loop || !event_loop->stats_) {
+    watcher->OnFileCanRead(fd);
+    return;
+  }
+  absl::Duration start = MonotonicNow();
+  watcher->OnFileCanRead(fd);
+  event_loop->RecordCallback(EventLoopStats::CallbackType::kFdRead, fd,
+                             watcher, start, MonotonicNow());
 }
 
 void EventLoop::FdWatchController::OnFileCanWrite(int fd) {
-  watcher_->OnFileCanWrite(fd);
+  EventLoop* event_loop = event_loop_;
+  FdWatcher* watcher = watcher_;
+  if (!event_loop || !event_loop->stats_) {
+    watcher->OnFileCanWrite(fd);
+    return;
+  }
+  absl::Duration start = MonotonicNow();
+  watcher->OnFileCanWrite(fd);
+  event_loop->RecordCallback(EventLoopStats::CallbackType::kFdWrite, fd,
+                             watcher, start, MonotonicNow());
+}
+
+void EventLoop::FdWatchController::OnFileReady(int fd, int mode) {
+  if (mode == WATCH_READ_WRITE) {
+    // Both callbacks will be called. It is necessary to check that |this| is
+    // not destroyed.
+    bool controller_was_destroyed = false;
+    was_destroyed_ = &controller_was_destroyed;
+    OnFileCanWrite(fd);
+    if (!controller_was_destroyed) OnFileCanRead(fd);
+    if (!controller_was_destroyed) was_destroyed_ = nullptr;
+  } else if (mode & WATCH_WRITE) {
+    OnFileCanWrite(fd);
+  } else if (mode & WATCH_READ) {
+    OnFileCanRead(fd);
+  }
 }
 
+#if defined(OS_POSIX)
+EventLoop::IoOperation::IoOperation() = default;
+
+EventLoop::IoOperation::~IoOperation() { Cancel(); }
+
+void EventLoop::IoOperation::Cancel() {
+  if (backend_) backend_->CancelIo(this);
+}
+#endif  // defined(OS_POSIX)
+
 EventLoop::Delegate::~Delegate() = default;
 
-EventLoop::EventLoop() : event_base_(event_base_new()) {
-  CHECK(event_base_);
+EventLoop::EventLoop() : EventLoop(Backend::kLibevent) {}
+
+EventLoop::EventLoop(Backend backend)
+    : backend_(CreateBackend(&backend)),
+      backend_type_(backend),
+      timing_wheel_(new TimingWheel(kTimerTickDuration, MonotonicNow())),
+      best_effort_task_budget_(kDefaultBestEffortTaskBudget),
+      wakeup_pending_(false),
+      wakeup_watcher_(new WakeupWatcher(this)) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  wakeup_read_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  PCHECK(wakeup_read_fd_ >= 0) << "eventfd() failed";
+  wakeup_write_fd_ = wakeup_read_fd_;
+#else
+  evutil_socket_t fds[2];
+  PCHECK(evutil_socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0)
+      << "evutil_socketpair() failed";
+  for (evutil_socket_t fd : fds) {
+    CHECK_EQ(evutil_make_socket_nonblocking(fd), 0);
+    CHECK_EQ(evutil_make_socket_closeonexec(fd), 0);
+  }
+  wakeup_read_fd_ = fds[0];
+  wakeup_write_fd_ = fds[1];
+#endif
+  CHECK(WatchFileDescriptor(wakeup_read_fd_, true, WATCH_READ,
+                            &wakeup_controller_, wakeup_watcher_.get()));
+
   BindToCurrentThread(this);
 }
 
 EventLoop::~EventLoop() {
-  DCHECK(event_base_);
-  event_base_free(event_base_);
+  DCHECK(backend_);
+  // Pending tasks and timers may own objects which still watch file
+  // descriptors, so they have to go away before |backend_|.
+  OnceClosure task;
+  for (MpscQueue<OnceClosure>& task_queue : task_queues_) {
+    while (task_queue.Pop(&task)) task.Reset();
+  }
+  timing_wheel_.reset();
+  CHECK(wakeup_controller_.StopWatchingFileDescriptor());
+  evutil_closesocket(wakeup_read_fd_);
+  if (wakeup_write_fd_ != wakeup_read_fd_) evutil_closesocket(wakeup_write_fd_);
+  backend_.reset();
   BindToCurrentThread(nullptr);
 }
 
@@ -93,27 +274,58 @@ void EventLoop::Run(Delegate* delegate) {
   for (;;) {
     if (!keep_running_) break;
 
-    event_base_loop(event_base_, EVLOOP_NONBLOCK);
-    bool more_work_is_plausible = processed_io_events_;
-    processed_io_events_ = false;
+    if (stats_) ++stats_->iterations;
+
+    bool more_work_is_plausible = PollBackend(absl::ZeroDuration());
+
+    if (!keep_running_) break;
+
+    more_work_is_plausible |= RunExpiredTimers();
+
+    if (!keep_running_) break;
+
+    more_work_is_plausible |= RunPendingTasks();
 
     if (!keep_running_) break;
 
     if (more_work_is_plausible) continue;
 
-    more_work_is_plausible = delegate->DoIdleWork();
+    more_work_is_plausible = RunIdleWork(delegate);
 
     if (more_work_is_plausible) continue;
 
-    event_base_loop(event_base_, EVLOOP_ONCE);
+    // Tasks posted from this thread don't wake up the event loop.
+    if (HasPendingTasks()) continue;
+
+    if (busy_poll_budget_ > absl::ZeroDuration() && BusyPoll()) continue;
+
+    PollBackend(GetTimerDelay());
 
     if (!keep_running_) break;
   }
 }
 
-void EventLoop::Quit() {
-  event_base_loopexit(event_base_, nullptr);
-  keep_running_ = false;
+void EventLoop::Quit() { keep_running_ = false; }
+
+void EventLoop::SetBusyPollBudget(absl::Duration budget) {
+  DCHECK_GE(budget, absl::ZeroDuration());
+  busy_poll_budget_ = budget;
+}
+
+void EventLoop::SetBestEffortTaskBudget(absl::Duration budget) {
+  DCHECK_GE(budget, absl::ZeroDuration());
+  best_effort_task_budget_ = budget;
+}
+
+void EventLoop::EnableInstrumentation(absl::Duration slow_callback_threshold) {
+  stats_.reset(new EventLoopStats());
+  slow_callback_threshold_ = slow_callback_threshold;
+}
+
+void EventLoop::DisableInstrumentation() { stats_.reset(); }
+
+EventLoopStats EventLoop::GetStats() const {
+  return stats_ ? *stats_ : EventLoopStats();
 }
 
 bool EventLoop::WatchFileDescriptor(int fd, bool persistent, int mode,
@@ -124,78 +336,278 @@ bool EventLoop::WatchFileDescriptor(int fd, bool persistent, int mode,
   DCHECK(watcher);
   DCHECK(mode == WATCH_READ || mode == WATCH_WRITE || mode == WATCH_READ_WRITE);
 
-  int event_mask = persistent ? EV_PERSIST : 0;
-  if (mode & WATCH_READ) {
-    event_mask |= EV_READ;
-  }
-  if (mode & WATCH_WRITE) {
-    event_mask |= EV_WRITE;
+  DCHECK(!controller->backend_ || controller->backend_ == backend_.get());
+
+  if (!backend_->WatchFileDescriptor(fd, persistent, mode, controller)) {
+    return false;
   }
 
-  std::unique_ptr<event> evt(controller->ReleaseEvent());
-  if (!evt) {
-    // Ownership is transferred to the controller.
-    evt.reset(new event);
-  } else {
-    // Make sure we don't pick up any funky internal libevent masks.
-    int old_interest_mask = evt->ev_events & (EV_READ | EV_WRITE | EV_PERSIST);
+  controller->set_watcher(watcher);
+  controller->set_backend(backend_.get());
+  controller->event_loop_ = this;
+  return true;
+}
 
-    // Combine old/new event masks.
-    event_mask |= old_interest_mask;
+void EventLoop::PostDelayedTask(OnceClosure task, absl::Duration delay) {
+  DCHECK(!task.is_null());
+  timing_wheel_->Schedule(new DelayedTask(std::move(task)),
+                          MonotonicNow() + delay);
+}
 
-    // Must disarm the event before we can reuse it.
-    event_del(evt.get());
+void EventLoop::ScheduleTimer(TimingWheel::Entry* entry,
+                              absl::Duration delay) {
+  DCHECK(entry);
+  timing_wheel_->Schedule(entry, MonotonicNow() + delay);
+}
 
-    // It's illegal to use this function to listen on 2 separate fds with the
-    // same |controller|.
-    if (event_get_fd(evt.get()) != fd) {
-      NOTREACHED() << "FDs don't match" << event_get_fd(evt.get())
-                   << "!=" << fd;
-      return false;
-    }
+void EventLoop::PostTask(OnceClosure task) {
+  PostTask(TaskPriority::kNormal, std::move(task));
+}
+
+void EventLoop::PostTask(TaskPriority priority, OnceClosure task) {
+  DCHECK(!task.is_null());
+  task_queues_[static_cast<int>(priority)].Push(std::move(task));
+  // Run() checks |task_queues_| before it blocks, so there is no need to wake
+  // up the event loop from its own thread.
+  if (Current() == this) return;
+  ScheduleWakeup();
+}
+
+#if defined(OS_POSIX)
+bool EventLoop::SupportsCompletionIo() const {
+  return backend_->SupportsCompletionIo();
+}
+
+void EventLoop::SubmitRecv(int fd, std::shared_ptr<IOBuffer> buf, int buf_len,
+                           int flags, IoOperation* operation,
+                           CompletionOnceCallback callback) {
+  backend_->SubmitIo(internal::EventLoopBackend::IoType::kRecv, fd,
+                     std::move(buf), buf_len, flags, nullptr, 0, operation,
+                     std::move(callback));
+}
+
+void EventLoop::SubmitSend(int fd, std::shared_ptr<IOBuffer> buf, int buf_len,
+                           int flags, IoOperation* operation,
+                           CompletionOnceCallback callback) {
+  backend_->SubmitIo(internal::EventLoopBackend::IoType::kSend, fd,
+                     std::move(buf), buf_len, flags, nullptr, 0, operation,
+                     std::move(callback));
+}
+
+void EventLoop::SubmitRecvMsg(int fd, std::shared_ptr<IOBuffer> buf,
+                              int buf_len, int flags, IoOperation* operation,
+                              CompletionOnceCallback callback) {
+  backend_->SubmitIo(internal::EventLoopBackend::IoType::kRecvMsg, fd,
+                     std::move(buf), buf_len, flags, nullptr, 0, operation,
+                     std::move(callback));
+}
+
+void EventLoop::SubmitSendMsg(int fd, std::shared_ptr<IOBuffer> buf,
+                              int buf_len, const sockaddr* address,
+                              socklen_t address_len, int flags,
+                              IoOperation* operation,
+                              CompletionOnceCallback callback) {
+  backend_->SubmitIo(internal::EventLoopBackend::IoType::kSendMsg, fd,
+                     std::move(buf), buf_len, flags, address, address_len,
+                     operation, std::move(callback));
+}
+#endif  // defined(OS_POSIX)
+
+bool EventLoop::RunExpiredTimers() {
+  if (timing_wheel_->empty()) return false;
+  absl::Duration now = MonotonicNow();
+  if (timing_wheel_->Advance(now) == 0) return false;
+  if (stats_) {
+    RecordCallback(EventLoopStats::CallbackType::kTimers, -1, nullptr, now,
+                   MonotonicNow());
   }
+  return true;
+}
 
-  // Set current interest mask and message pump for this event.
-  event_set(evt.get(), fd, event_mask, OnNotification, controller);
+absl::Duration EventLoop::GetTimerDelay() const {
+  absl::Duration deadline = timing_wheel_->NextDeadline();
+  if (deadline == absl::InfiniteDuration()) return deadline;
+  return std::max(deadline - MonotonicNow(), absl::ZeroDuration());
+}
 
-  // Tell libevent which message pump this socket will belong to when we add it.
-  if (event_base_set(event_base_, evt.get())) {
-    DPLOG(ERROR) << "event_base_set(fd=" << event_get_fd(evt.get()) << ")";
-    return false;
+bool EventLoop::RunPendingTasks() {
+  bool ran = false;
+  for (TaskPriority priority : {TaskPriority::kHigh, TaskPriority::kNormal}) {
+    for (int count = 0; count < kMaxPostedTasksPerIteration; ++count) {
+      if (!RunNextTask(priority)) break;
+      ran = true;
+      if (!keep_running_) return true;
+    }
   }
 
-  // Add this socket to the list of monitored sockets.
-  if (event_add(evt.get(), nullptr)) {
-    DPLOG(ERROR) << "event_add failed(fd=" << event_get_fd(evt.get()) << ")";
-    return false;
+  if (task_queues_[static_cast<int>(TaskPriority::kBestEffort)].empty())
+    return ran;
+
+  // A high priority task preempts the remaining best-effort tasks.
+  const MpscQueue<OnceClosure>& high_priority_tasks =
+      task_queues_[static_cast<int>(TaskPriority::kHigh)];
+  absl::Duration deadline = MonotonicNow() + best_effort_task_budget_;
+  while (RunNextTask(TaskPriority::kBestEffort)) {
+    ran = true;
+    if (!keep_running_ || !high_priority_tasks.empty() ||
+        MonotonicNow() >= deadline) {
+      break;
+    }
   }
+  return ran;
+}
 
-  controller->Init(std::move(evt));
-  controller->set_watcher(watcher);
-  controller->set_event_loop(this);
+bool EventLoop::RunNextTask(TaskPriority priority) {
+  OnceClosure task;
+  if (!task_queues_[static_cast<int>(priority)].Pop(&task)) return false;
+  if (stats_) {
+    absl::Duration start = MonotonicNow();
+    std::move(task).Run();
+    RecordCallback(EventLoopStats::CallbackType::kTask, -1, nullptr, start,
+                   MonotonicNow());
+  } else {
+    std::move(task).Run();
+  }
   return true;
 }
 
-// static
-void EventLoop::OnNotification(evutil_socket_t fd, short flags, void* context) {
-  FdWatchController* controller = static_cast<FdWatchController*>(context);
-  DCHECK(controller);
+bool EventLoop::HasPendingTasks() const {
+  for (const MpscQueue<OnceClosure>& task_queue : task_queues_) {
+    if (!task_queue.empty()) return true;
+  }
+  return false;
+}
+
+bool EventLoop::PollBackend(absl::Duration timeout) {
+  if (!stats_) return backend_->Poll(timeout);
+
+  fd_callbacks_in_poll_ = 0;
+  fd_callback_time_in_poll_ = absl::ZeroDuration();
+  absl::Duration start = MonotonicNow();
+  bool rv = backend_->Poll(timeout);
+  absl::Duration end = MonotonicNow();
+  // A callback may have disabled the instrumentation.
+  if (!stats_) return rv;
+
+  stats_->events_per_poll.Add(fd_callbacks_in_poll_);
+  if (timeout != absl::ZeroDuration()) {
+    stats_->poll_wait.Add(absl::ToInt64Nanoseconds(
+        std::max(end - start - fd_callback_time_in_poll_,
+                 absl::ZeroDuration())));
+  }
+  return rv;
+}
 
-  controller->event_loop_->processed_io_events_ = true;
+bool EventLoop::RunIdleWork(Delegate* delegate) {
+  if (!stats_) return delegate->DoIdleWork();
 
-  if ((flags & (EV_READ | EV_WRITE)) == (EV_READ | EV_WRITE)) {
-    // Both callbacks will be called. It is necessary to check that |controller|
-    // is not destroyed.
-    bool controller_was_destroyed = false;
-    controller->was_destroyed_ = &controller_was_destroyed;
-    controller->OnFileCanWrite(fd);
-    if (!controller_was_destroyed) controller->OnFileCanRead(fd);
-    if (!controller_was_destroyed) controller->was_destroyed_ = nullptr;
-  } else if (flags & EV_WRITE) {
-    controller->OnFileCanWrite(fd);
-  } else if (flags & EV_READ) {
-    controller->OnFileCanRead(fd);
+  absl::Duration start = MonotonicNow();
+  bool rv = delegate->DoIdleWork();
+  RecordCallback(EventLoopStats::CallbackType::kIdleWork, -1, nullptr, start,
+                 MonotonicNow());
+  return rv;
+}
+
+void EventLoop::RecordCallback(EventLoopStats::CallbackType type, int fd,
+                               const void* watcher, absl::Duration start,
+                               absl::Duration end) {
+  // The callback may have disabled the instrumentation.
+  if (!stats_) return;
+
+  absl::Duration duration = end - start;
+  int64_t nanoseconds = absl::ToInt64Nanoseconds(duration);
+  switch (type) {
+    case EventLoopStats::CallbackType::kFdRead:
+    case EventLoopStats::CallbackType::kFdWrite:
+      stats_->fd_callback.Add(nanoseconds);
+      ++fd_callbacks_in_poll_;
+      fd_callback_time_in_poll_ += duration;
+      break;
+    case EventLoopStats::CallbackType::kTask:
+      stats_->task.Add(nanoseconds);
+      break;
+    case EventLoopStats::CallbackType::kTimers:
+      stats_->timers.Add(nanoseconds);
+      break;
+    case EventLoopStats::CallbackType::kIdleWork:
+      stats_->idle_work.Add(nanoseconds);
+      break;
+  }
+
+  if (duration < slow_callback_threshold_) return;
+  ++stats_->slow_callbacks;
+  std::vector<EventLoopStats::SlowCallback>& recent =
+      stats_->recent_slow_callbacks;
+  if (recent.size() == EventLoopStats::kMaxRecentSlowCallbacks)
+    recent.erase(recent.begin());
+  recent.push_back({type, fd, watcher, duration, start});
+  DVLOG(1) << "Slow event loop callback on fd " << fd << ": " << duration;
+}
+
+bool EventLoop::BusyPoll() {
+  // A due timer is work already.
+  absl::Duration timer_delay = GetTimerDelay();
+  if (timer_delay == absl::ZeroDuration()) return true;
+
+  absl::Duration start = MonotonicNow();
+  absl::Duration deadline = start + std::min(busy_poll_budget_, timer_delay);
+
+  // Posters skip the write to |wakeup_write_fd_| while the flag is set, and
+  // OnWakeup() leaves it set while |spinning_| is.
+  spinning_ = true;
+  wakeup_pending_.exchange(true);
+
+  bool found_work = false;
+  absl::Duration now = start;
+  while (now < deadline) {
+    if (backend_->Poll(absl::ZeroDuration()) || HasPendingTasks() ||
+        !keep_running_) {
+      found_work = true;
+      break;
+    }
+    now = MonotonicNow();
+  }
+
+  spinning_ = false;
+  // A post which skipped its write happened before this exchange, which thus
+  // makes its task visible below. Any later post writes again.
+  wakeup_pending_.exchange(false);
+  if (HasPendingTasks()) found_work = true;
+
+  ++busy_poll_stats_.spins;
+  if (found_work) ++busy_poll_stats_.hits;
+  busy_poll_stats_.spin_time += MonotonicNow() - start;
+  return found_work;
+}
+
+void EventLoop::ScheduleWakeup() {
+  // Only the first post since the last wakeup has to write. The exchange must
+  // happen after the task has been pushed, see OnWakeup().
+  if (wakeup_pending_.exchange(true)) return;
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  uint64_t value = 1;
+  int rv = HANDLE_EINTR(write(wakeup_write_fd_, &value, sizeof(value)));
+#else
+  char value = 0;
+  int rv = send(wakeup_write_fd_, &value, sizeof(value), 0);
+#endif
+  DPCHECK(rv >= 0) << "Failed to wake up the event loop";
+}
+
+void EventLoop::OnWakeup() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  uint64_t value;
+  HANDLE_EINTR(read(wakeup_read_fd_, &value, sizeof(value)));
+#else
+  char buffer[64];
+  while (recv(wakeup_read_fd_, buffer, sizeof(buffer), 0) > 0) {
   }
+#endif
+  // The flag is cleared before RunPendingTasks() drains |task_queues_|. A task
+  // which is pushed after the drain is thus either seen by it or followed by
+  // another write to |wakeup_write_fd_|.
+  if (!spinning_) wakeup_pending_.store(false);
 }
 
 // static
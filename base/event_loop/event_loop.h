@@ -9,16 +9,86 @@
 #ifndef BASE_EVENT_LOOP_EVENT_LOOP_H_
 #define BASE_EVENT_LOOP_EVENT_LOOP_H_
 
+#include <stdint.h>
+
+#include <atomic>
 #include <memory>
 
+#include "absl/time/time.h"
+#include "base/build_config.h"
+#include "base/callback.h"
+#include "base/completion_once_callback.h"
+#include "base/containers/mpsc_queue.h"
+#include "base/event_loop/event_loop_stats.h"
+#include "base/event_loop/frame_pool.h"
+#include "base/event_loop/timing_wheel.h"
 #include "base/export.h"
 #include "base/thread/thread_local.h"
 #include "event2/event.h"
 
+#if defined(OS_POSIX)
+#include <sys/socket.h>
+#endif
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/signalfd.h>
+
+#include "base/files/scoped_file.h"
+#endif
+
 namespace base {
 
+class IOBuffer;
+class Process;
+
+namespace internal {
+class EventLoopBackend;
+class LibeventBackend;
+class EpollBackend;
+class IoUringBackend;
+struct IoUringRequest;
+}  // namespace internal
+
 class BASE_EXPORT EventLoop {
  public:
+  // The mechanism the event loop waits for I/O with.
+  enum class Backend {
+    // libevent, which is available on every platform.
+    kLibevent,
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    // epoll(7) driven directly. File descriptors are registered
+    // edge-triggered and only re-registered when the interest of a
+    // FdWatchController changes, so watching the same direction again after
+    // each read or write costs a single epoll_ctl(). FdWatchers are expected
+    // to read or write until EAGAIN, or to watch again, before they are
+    // notified again.
+    kEpoll,
+#endif
+#if defined(OS_LINUX)
+    // io_uring(7), which also supports the completion-based I/O of
+    // SupportsCompletionIo(). File descriptors are watched with an epoll
+    // instance, which the ring polls. Falls back to kEpoll if the kernel lacks
+    // io_uring or a feature it needs, which backend() then returns.
+    kIoUring,
+#endif
+  };
+
+  // The lanes of PostTask(). Each iteration of Run() runs, after the FdWatcher
+  // callbacks and the expired timers, the high priority tasks, then the
+  // normal priority ones, then the best-effort ones for as long as the
+  // best-effort budget allows. Tasks of the same priority run in the order
+  // they were posted.
+  enum class TaskPriority {
+    // Latency-critical work, e.g. control-plane messages.
+    kHigh,
+    // The default, e.g. tasks which continue I/O.
+    kNormal,
+    // Bulk background work, which yields to I/O and to the other priorities
+    // once it has used up its budget. See SetBestEffortTaskBudget().
+    kBestEffort,
+  };
+  static constexpr int kNumTaskPriorities = 3;
+
   enum Mode {
     WATCH_READ = 1 << 0,
     WATCH_WRITE = 1 << 1,
@@ -43,20 +113,40 @@ class BASE_EXPORT EventLoop {
 
    private:
     friend class EventLoop;
+    friend class internal::LibeventBackend;
+    friend class internal::EpollBackend;
 
-    // Called by EventLoop.
-    void Init(std::unique_ptr<event> e);
+    // Called by LibeventBackend.
+    void Init(event* e);
 
-    // Used by EventLoop to take ownership of |event_|.
-    std::unique_ptr<event> ReleaseEvent();
+    // Used by LibeventBackend to take back |event_|.
+    event* ReleaseEvent();
 
     void set_watcher(FdWatcher* watcher);
-    void set_event_loop(EventLoop* event_loop);
+    void set_backend(internal::EventLoopBackend* backend);
 
     void OnFileCanRead(int Fd);
     void OnFileCanWrite(int Fd);
 
-    std::unique_ptr<event> event_;
+    // Calls the watcher for every direction set in |mode|. The watcher may
+    // destroy |this| in the first callback.
+    void OnFileReady(int fd, int mode);
+
+    // Used by LibeventBackend, which owns the storage of the event.
+    event* event_ = nullptr;
+
+    // Used by EpollBackend. |fd_| is -1 and |mode_| is 0 while the controller
+    // isn't watching. |prev_| and |next_| link the controllers which watch
+    // the same file descriptor.
+    int fd_ = -1;
+    int mode_ = 0;
+    bool persistent_ = false;
+    FdWatchController* prev_ = nullptr;
+    FdWatchController* next_ = nullptr;
+    uint64_t dispatch_epoch_ = 0;
+
+    internal::EventLoopBackend* backend_ = nullptr;
+    // The event loop the callbacks are timed for.
     EventLoop* event_loop_ = nullptr;
     FdWatcher* watcher_ = nullptr;
     // If this pointer is non-NULL, the pointee is set to true in the
@@ -64,30 +154,298 @@ class BASE_EXPORT EventLoop {
     bool* was_destroyed_ = nullptr;
   };
 
+#if defined(OS_POSIX)
+  // Tracks an operation submitted by one of the Submit*() methods.
+  class BASE_EXPORT IoOperation {
+   public:
+    IoOperation();
+    IoOperation(const IoOperation& other) = delete;
+    IoOperation& operator=(const IoOperation& other) = delete;
+    // Cancels the operation if it is pending.
+    ~IoOperation();
+
+    bool IsPending() const { return request_ != nullptr; }
+
+    // Cancels the operation, whose callback is then never called. It is a
+    // no-op if the operation is not pending.
+    void Cancel();
+
+    // The source address and the flags of the message received by
+    // SubmitRecvMsg(). Only valid in its callback.
+    const sockaddr_storage& address() const { return address_; }
+    socklen_t address_len() const { return address_len_; }
+    int msg_flags() const { return msg_flags_; }
+
+   private:
+    friend class internal::IoUringBackend;
+
+    internal::EventLoopBackend* backend_ = nullptr;
+    internal::IoUringRequest* request_ = nullptr;
+
+    sockaddr_storage address_;
+    socklen_t address_len_ = 0;
+    int msg_flags_ = 0;
+  };
+#endif  // defined(OS_POSIX)
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Tracks a signal watched by WatchSignal(). Destroying it stops watching.
+  class BASE_EXPORT SignalWatchController : private FdWatcher {
+   public:
+    SignalWatchController();
+    SignalWatchController(const SignalWatchController& other) = delete;
+    SignalWatchController& operator=(const SignalWatchController& other) =
+        delete;
+    ~SignalWatchController() override;
+
+    // Stops watching. The signal stays blocked.
+    bool StopWatchingSignal();
+
+   private:
+    friend class EventLoop;
+
+    // EventLoop::FdWatcher methods
+    void OnFileCanRead(int fd) override;
+    void OnFileCanWrite(int fd) override;
+
+    ScopedFD signal_fd_;
+    FdWatchController controller_;
+    RepeatingCallback<void(const signalfd_siginfo&)> callback_;
+    // If this pointer is non-NULL, the pointee is set to true in the
+    // destructor.
+    bool* was_destroyed_ = nullptr;
+  };
+
+  // Tracks a process watched by WatchProcessExit(). Destroying it stops
+  // watching.
+  class BASE_EXPORT ProcessExitWatchController : private FdWatcher {
+   public:
+    ProcessExitWatchController();
+    ProcessExitWatchController(const ProcessExitWatchController& other) =
+        delete;
+    ProcessExitWatchController& operator=(
+        const ProcessExitWatchController& other) = delete;
+    ~ProcessExitWatchController() override;
+
+    bool StopWatchingProcess();
+
+   private:
+    friend class EventLoop;
+
+    // EventLoop::FdWatcher methods
+    void OnFileCanRead(int fd) override;
+    void OnFileCanWrite(int fd) override;
+
+    ScopedFD pid_fd_;
+    pid_t pid_ = 0;
+    FdWatchController controller_;
+    OnceCallback<void(int)> callback_;
+  };
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
+  // How often the busy-poll phase of Run() paid off. See
+  // SetBusyPollBudget().
+  struct BusyPollStats {
+    // The number of times the event loop spun before blocking.
+    uint64_t spins = 0;
+    // The number of those which found work, and thus didn't block.
+    uint64_t hits = 0;
+    // The total time spent spinning.
+    absl::Duration spin_time;
+  };
+
   class Delegate {
    public:
     virtual ~Delegate();
 
+    // Called when there is neither I/O nor a task to run. Returns true if
+    // there may be more idle work. A call isn't bounded by the best-effort
+    // budget, so bulk work is better posted in small tasks with
+    // TaskPriority::kBestEffort.
     virtual bool DoIdleWork() = 0;
   };
 
+  // Creates an event loop which uses Backend::kLibevent.
   EventLoop();
+  explicit EventLoop(Backend backend);
   ~EventLoop();
   EventLoop(const EventLoop& other) = delete;
   EventLoop& operator=(const EventLoop& other) = delete;
 
   static EventLoop* Current();
 
+  Backend backend() const { return backend_type_; }
+
+  // The pool which the frames of the coroutines started on this event loop
+  // are allocated from. Must only be used on the thread this event loop is
+  // bound to.
+  FramePool* frame_pool() { return &frame_pool_; }
+
   void Run(Delegate* delegate);
 
   void Quit();
 
+  // Makes Run() spin, polling for I/O and posted tasks without blocking, for
+  // up to |budget| before it blocks, which saves the cost of a wakeup when
+  // work arrives within |budget|. While it spins, PostTask() from another
+  // thread doesn't wake the event loop up, since it is going to see the task
+  // anyway. This only pays off on a dedicated core. The default budget of
+  // zero never spins. See also SetBusyPoll() in socket_options.h, which makes
+  // the kernel busy-poll the device queue of a socket.
+  void SetBusyPollBudget(absl::Duration budget);
+  absl::Duration busy_poll_budget() const { return busy_poll_budget_; }
+
+  const BusyPollStats& busy_poll_stats() const { return busy_poll_stats_; }
+
+  // Limits how long each iteration of Run() keeps running best-effort tasks
+  // before it goes back to I/O. At least one best-effort task runs per
+  // iteration, so a single task longer than |budget| still delays I/O; split
+  // bulk work into small tasks. The default is 1 millisecond.
+  void SetBestEffortTaskBudget(absl::Duration budget);
+  absl::Duration best_effort_task_budget() const {
+    return best_effort_task_budget_;
+  }
+
+  // Starts recording EventLoopStats from scratch: how long Run() waits for
+  // I/O, how long each FdWatcher callback, posted task, batch of timers and
+  // DoIdleWork() takes, and how many FdWatcher callbacks each poll runs. A
+  // callback which takes longer than |slow_callback_threshold| is recorded as
+  // slow, along with its file descriptor and watcher. This costs two reads of
+  // the monotonic clock per callback while enabled, and a branch otherwise.
+  void EnableInstrumentation(absl::Duration slow_callback_threshold);
+  void DisableInstrumentation();
+  bool IsInstrumentationEnabled() const { return stats_ != nullptr; }
+
+  // Returns a snapshot of the stats, which are empty unless instrumentation
+  // is enabled. Must be called on the thread this event loop is bound to;
+  // post a task to it to take a snapshot from another thread.
+  EventLoopStats GetStats() const;
+
   bool WatchFileDescriptor(int Fd, bool persistent, int mode,
                            FdWatchController* controller, FdWatcher* watcher);
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Calls |callback| on this event loop every time |signo| is delivered, until
+  // |controller| stops watching. The signal is read from a signalfd, so it has
+  // to be blocked instead of handled: this blocks it on the calling thread, but
+  // it must also be blocked on every other thread of the process, or it may be
+  // delivered to one of them instead. The simplest way is to call this, or to
+  // block the signal, before starting any thread, since new threads inherit
+  // the signal mask. Several deliveries of a standard signal before the event
+  // loop reads them are merged into one, as they would be for a handler.
+  // Returns false on failure.
+  bool WatchSignal(int signo, SignalWatchController* controller,
+                   RepeatingCallback<void(const signalfd_siginfo&)> callback);
+
+  // Calls |callback| on this event loop with the exit code of |process| once
+  // it exits, having reaped it, unless |controller| stops watching first. The
+  // exit code is -1 if the process was killed by a signal, or was reaped by
+  // somebody else. |process| must be a child of this process which hasn't been
+  // waited for yet. The process is watched with a pidfd, so this needs Linux
+  // 5.3 or later; it returns false on older kernels and on failure, in which
+  // case Process::WaitForExit() still works.
+  bool WatchProcessExit(const Process& process,
+                        ProcessExitWatchController* controller,
+                        OnceCallback<void(int)> callback);
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
+  // Runs |task| on this event loop once |delay| has elapsed. Must be called on
+  // the thread this event loop is bound to. Tasks which haven't run yet when
+  // the event loop is destroyed are deleted without being run.
+  void PostDelayedTask(OnceClosure task, absl::Duration delay);
+
+  // Schedules |entry| to expire on this event loop once |delay| has elapsed.
+  // If |entry| is already scheduled, it is rescheduled. Cancel it with
+  // TimingWheel::Entry::Cancel(). This is what OneShotTimer and RepeatingTimer
+  // are built on.
+  void ScheduleTimer(TimingWheel::Entry* entry, absl::Duration delay);
+
+  // Runs |task| on this event loop as soon as possible, in the order tasks
+  // were posted. Unlike the other methods, this can be called from any thread
+  // without locking. A burst of posts from other threads wakes up the event
+  // loop only once. The caller must make sure that the event loop outlives the
+  // call. Tasks which haven't run yet when the event loop is destroyed are
+  // deleted without being run. To stop the event loop from another thread,
+  // post a task which calls Quit().
+  void PostTask(OnceClosure task);
+
+  // Like PostTask(), but in the lane of |priority|.
+  void PostTask(TaskPriority priority, OnceClosure task);
+
+#if defined(OS_POSIX)
+  // Returns true if the Submit*() methods can be used, which is the case for
+  // Backend::kIoUring.
+  bool SupportsCompletionIo() const;
+
+  // Completion-based socket I/O. Instead of waiting for |fd| to become ready
+  // and then calling recv() or send(), the operation is handed to the kernel,
+  // in a single system call with every other operation submitted in the same
+  // iteration of Run(). |callback| is called with the number of bytes
+  // transferred or a negative errno, unless |operation| is cancelled or
+  // destroyed first. |operation| must not be pending. |buf| is kept alive
+  // until the kernel is done with it, even if the operation is cancelled.
+  void SubmitRecv(int fd, std::shared_ptr<IOBuffer> buf, int buf_len,
+                  int flags, IoOperation* operation,
+                  CompletionOnceCallback callback);
+  void SubmitSend(int fd, std::shared_ptr<IOBuffer> buf, int buf_len,
+                  int flags, IoOperation* operation,
+                  CompletionOnceCallback callback);
+
+  // Like SubmitRecv(), but with recvmsg(), so that the source address and the
+  // flags of the message can be read from |operation| in |callback|.
+  void SubmitRecvMsg(int fd, std::shared_ptr<IOBuffer> buf, int buf_len,
+                     int flags, IoOperation* operation,
+                     CompletionOnceCallback callback);
+
+  // Like SubmitSend(), but with sendmsg() to |address|, which is copied and
+  // may be null for a connected socket.
+  void SubmitSendMsg(int fd, std::shared_ptr<IOBuffer> buf, int buf_len,
+                     const sockaddr* address, socklen_t address_len, int flags,
+                     IoOperation* operation, CompletionOnceCallback callback);
+#endif  // defined(OS_POSIX)
+
  private:
-  // Called by libevent to tell us a registered FD can be read/written to.
-  static void OnNotification(evutil_socket_t Fd, short flags, void* context);
+  class WakeupWatcher;
+
+  // Runs the timers whose deadline has passed. Returns true if any did run.
+  bool RunExpiredTimers();
+
+  // Returns how long a blocking poll may wait before the earliest timer is
+  // due, or absl::InfiniteDuration() if there is none.
+  absl::Duration GetTimerDelay() const;
+
+  // Runs the tasks posted by PostTask(), at most a fixed number of high and
+  // normal priority tasks and best-effort tasks for at most
+  // |best_effort_task_budget_| per call so that I/O isn't starved. Returns
+  // true if any did run.
+  bool RunPendingTasks();
+
+  // Runs the next task of |priority|. Returns false if there is none.
+  bool RunNextTask(TaskPriority priority);
+
+  bool HasPendingTasks() const;
+
+  // Polls |backend_| and records the stats of the poll.
+  bool PollBackend(absl::Duration timeout);
+
+  // Runs DoIdleWork() of |delegate| and records its duration.
+  bool RunIdleWork(Delegate* delegate);
+
+  // Records a callback of |type| which ran from |start| to |end|. |fd| and
+  // |watcher| are only set for the FdWatcher callbacks.
+  void RecordCallback(EventLoopStats::CallbackType type, int fd,
+                      const void* watcher, absl::Duration start,
+                      absl::Duration end);
+
+  // Polls without blocking until work shows up, the busy-poll budget runs
+  // out or the next timer is due. Returns true if work was found.
+  bool BusyPoll();
+
+  // Writes to |wakeup_write_fd_| unless a wakeup is already pending.
+  void ScheduleWakeup();
+
+  // Called when |wakeup_read_fd_| becomes readable.
+  void OnWakeup();
 
   static ThreadLocalPointer<EventLoop>& CurrentTLS();
   static void BindToCurrentThread(EventLoop* event_loop);
@@ -98,12 +456,49 @@ class BASE_EXPORT EventLoop {
   // This flag is set when inside Run.
   bool in_run_;
 
-  // This flag is set if libevent has processed I/O events.
-  bool processed_io_events_;
+  // This flag is set when inside BusyPoll().
+  bool spinning_ = false;
+
+  absl::Duration busy_poll_budget_;
+  BusyPollStats busy_poll_stats_;
+
+  // Null unless instrumentation is enabled.
+  std::unique_ptr<EventLoopStats> stats_;
+  absl::Duration slow_callback_threshold_;
+  // The FdWatcher callbacks run by the current poll, and the time they took.
+  uint64_t fd_callbacks_in_poll_ = 0;
+  absl::Duration fd_callback_time_in_poll_;
+
+  // Watches all file descriptors registered with it, and sends readiness
+  // callbacks when one is ready for I/O.
+  std::unique_ptr<internal::EventLoopBackend> backend_;
+
+  // The backend actually in use, which may differ from the requested one.
+  Backend backend_type_;
+
+  // Every timer of this event loop lives in |timing_wheel_|. The backend is
+  // told to wake up when the earliest of them is due.
+  std::unique_ptr<TimingWheel> timing_wheel_;
+
+  FramePool frame_pool_;
+
+  // Tasks posted by PostTask(), possibly from other threads, indexed by
+  // TaskPriority.
+  MpscQueue<OnceClosure> task_queues_[kNumTaskPriorities];
+
+  absl::Duration best_effort_task_budget_;
 
-  // Libevent dispatcher.  Watches all sockets registered with it, and sends
-  // readiness callbacks when a socket is ready for I/O.
-  event_base* event_base_;
+  // Set by the thread which writes to |wakeup_write_fd_| and cleared by this
+  // event loop when it reads from |wakeup_read_fd_|, so that only the first
+  // post after a wakeup pays for the system call. BusyPoll() keeps it set
+  // while it spins.
+  std::atomic<bool> wakeup_pending_;
+  // These are the same eventfd on Linux and the two ends of a socket pair
+  // elsewhere.
+  int wakeup_read_fd_;
+  int wakeup_write_fd_;
+  FdWatchController wakeup_controller_;
+  std::unique_ptr<WakeupWatcher> wakeup_watcher_;
 };
 
 }  // namespace base
@@ -0,0 +1,63 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_EVENT_LOOP_BACKEND_H_
+#define BASE_EVENT_LOOP_EVENT_LOOP_BACKEND_H_
+
+#include <memory>
+
+#include "absl/time/time.h"
+#include "base/completion_once_callback.h"
+#include "base/event_loop/event_loop.h"
+#include "base/io_buffer.h"
+#include "base/logging.h"
+
+namespace base {
+namespace internal {
+
+// The part of EventLoop which waits for I/O and calls the FdWatchers. See
+// EventLoop::Backend for the implementations.
+class EventLoopBackend {
+ public:
+  enum class IoType { kRecv, kSend, kRecvMsg, kSendMsg };
+
+  virtual ~EventLoopBackend() = default;
+
+  // Starts watching |fd| for |mode| on behalf of |controller|. If
+  // |controller| is already watching, |mode| and |persistent| are combined
+  // with the current ones. Returns false and sets errno on failure.
+  virtual bool WatchFileDescriptor(int fd, bool persistent, int mode,
+                                   EventLoop::FdWatchController* controller) = 0;
+
+  // Stops watching whatever |controller| is watching. Returns false on
+  // failure.
+  virtual bool StopWatchingFileDescriptor(
+      EventLoop::FdWatchController* controller) = 0;
+
+  // Waits up to |timeout| for I/O and calls the watchers of the ready file
+  // descriptors. absl::ZeroDuration() doesn't block and
+  // absl::InfiniteDuration() blocks until there is I/O. Returns true if any
+  // watcher was called.
+  virtual bool Poll(absl::Duration timeout) = 0;
+
+#if defined(OS_POSIX)
+  // Completion-based I/O. See EventLoop::SupportsCompletionIo() and the
+  // EventLoop::Submit*() methods. The backends which don't override these
+  // don't support it.
+  virtual bool SupportsCompletionIo() const { return false; }
+  virtual void SubmitIo(IoType type, int fd, std::shared_ptr<IOBuffer> buf,
+                        int buf_len, int flags, const sockaddr* address,
+                        socklen_t address_len,
+                        EventLoop::IoOperation* operation,
+                        CompletionOnceCallback callback) {
+    NOTREACHED();
+  }
+  virtual void CancelIo(EventLoop::IoOperation* operation) { NOTREACHED(); }
+#endif  // defined(OS_POSIX)
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_EVENT_LOOP_BACKEND_H_
@@ -0,0 +1,122 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/event_loop_group.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+#include "base/build_config.h"
+#include "base/logging.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace base {
+
+namespace {
+
+class IdleDelegate : public EventLoop::Delegate {
+ public:
+  // EventLoop::Delegate methods
+  bool DoIdleWork() override { return false; }
+};
+
+// Signals the constructor once every thread has created its event loop.
+struct StartupState {
+  std::mutex lock;
+  std::condition_variable cv;
+  size_t started = 0;
+};
+
+void PinCurrentThread(size_t index) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  cpu_set_t available;
+  CPU_ZERO(&available);
+  if (sched_getaffinity(0, sizeof(available), &available) != 0) {
+    DPLOG(ERROR) << "sched_getaffinity";
+    return;
+  }
+  // Only pick among the CPUs this process may run on, which may be fewer
+  // than the ones configured.
+  int count = CPU_COUNT(&available);
+  if (count == 0) return;
+  int target = static_cast<int>(index % count);
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &available)) continue;
+    if (target-- > 0) continue;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rv = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rv != 0) DLOG(ERROR) << "pthread_setaffinity_np failed: " << rv;
+    return;
+  }
+#endif
+}
+
+}  // namespace
+
+EventLoopGroup::EventLoopGroup() : EventLoopGroup(Options()) {}
+
+EventLoopGroup::EventLoopGroup(const Options& options) : next_index_(0) {
+  size_t size = options.size;
+  if (size == 0) size = std::max(std::thread::hardware_concurrency(), 1u);
+
+  event_loops_.resize(size, nullptr);
+  StartupState state;
+  threads_.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    threads_.emplace_back([this, i, options, &state]() {
+      if (options.pin_threads) PinCurrentThread(i);
+      EventLoop event_loop(options.backend);
+      {
+        std::lock_guard<std::mutex> guard(state.lock);
+        event_loops_[i] = &event_loop;
+        ++state.started;
+      }
+      state.cv.notify_one();
+      IdleDelegate delegate;
+      event_loop.Run(&delegate);
+    });
+  }
+
+  std::unique_lock<std::mutex> guard(state.lock);
+  state.cv.wait(guard, [&state, size]() { return state.started == size; });
+}
+
+EventLoopGroup::~EventLoopGroup() { Stop(); }
+
+EventLoop* EventLoopGroup::event_loop(size_t index) const {
+  DCHECK_LT(index, event_loops_.size());
+  DCHECK(!threads_.empty()) << "The group is stopped";
+  return event_loops_[index];
+}
+
+EventLoop* EventLoopGroup::Next() {
+  size_t index = next_index_.fetch_add(1, std::memory_order_relaxed);
+  return event_loop(index % event_loops_.size());
+}
+
+void EventLoopGroup::PostTaskToEach(RepeatingCallback<void(size_t)> task) {
+  DCHECK(!task.is_null());
+  for (size_t i = 0; i < size(); ++i) {
+    event_loop(i)->PostTask([task, i]() { task.Run(i); });
+  }
+}
+
+void EventLoopGroup::Stop() {
+  if (threads_.empty()) return;
+
+  for (EventLoop* event_loop : event_loops_) {
+    event_loop->PostTask([event_loop]() { event_loop->Quit(); });
+  }
+  for (std::thread& thread : threads_) thread.join();
+  threads_.clear();
+}
+
+}  // namespace base
@@ -0,0 +1,80 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_EVENT_LOOP_GROUP_H_
+#define BASE_EVENT_LOOP_EVENT_LOOP_GROUP_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/event_loop/event_loop.h"
+#include "base/export.h"
+
+namespace base {
+
+// Runs an EventLoop on each of a number of threads, by default one per CPU,
+// each pinned to its own CPU where the platform allows it.
+//
+// The event loops are only reached with EventLoop::PostTask(). A server
+// typically creates one TCPServerSocket or UDPServerSocket per event loop,
+// with AllowPortReuse(), from a task posted by PostTaskToEach(), so that the
+// kernel spreads the load across the threads without a shared accept lock:
+//
+//   EventLoopGroup group;
+//   group.PostTaskToEach([](size_t index) {
+//     auto* server = new TCPServerSocket();
+//     server->AllowPortReuse();
+//     server->Listen(address, backlog);
+//     ...
+//   });
+class BASE_EXPORT EventLoopGroup {
+ public:
+  struct Options {
+    // The number of threads. 0 means one per CPU.
+    size_t size = 0;
+    EventLoop::Backend backend = EventLoop::Backend::kLibevent;
+    // Whether the i-th thread is pinned to the i-th CPU, modulo the number of
+    // CPUs. Only supported on Linux and Android.
+    bool pin_threads = true;
+  };
+
+  // Starts the threads with the default Options.
+  EventLoopGroup();
+  // Starts the threads and returns once each event loop has been created.
+  explicit EventLoopGroup(const Options& options);
+  EventLoopGroup(const EventLoopGroup& other) = delete;
+  EventLoopGroup& operator=(const EventLoopGroup& other) = delete;
+  // Calls Stop().
+  ~EventLoopGroup();
+
+  size_t size() const { return event_loops_.size(); }
+
+  // Returns the event loop of the |index|-th thread. It is valid until Stop().
+  EventLoop* event_loop(size_t index) const;
+
+  // Returns the event loops in turn. Thread-safe.
+  EventLoop* Next();
+
+  // Posts |task| to each event loop, which runs it with its index.
+  void PostTaskToEach(RepeatingCallback<void(size_t)> task);
+
+  // Quits each event loop once the tasks already posted to it have run, and
+  // joins the threads. Tasks posted afterwards are never run, and must not be
+  // posted once the event loops are gone. It is a no-op if the group is
+  // already stopped.
+  void Stop();
+
+ private:
+  std::vector<std::thread> threads_;
+  std::vector<EventLoop*> event_loops_;
+  std::atomic<size_t> next_index_;
+};
+
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_EVENT_LOOP_GROUP_H_
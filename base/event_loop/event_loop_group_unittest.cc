@@ -0,0 +1,51 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/event_loop_group.h"
+
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(EventLoopGroupTest, PostTaskToEach) {
+  EventLoopGroup::Options options;
+  options.size = 4;
+  EventLoopGroup group(options);
+  ASSERT_EQ(4u, group.size());
+
+  std::mutex lock;
+  std::vector<EventLoop*> event_loops(group.size(), nullptr);
+  std::set<std::thread::id> thread_ids;
+  group.PostTaskToEach([&](size_t index) {
+    std::lock_guard<std::mutex> guard(lock);
+    event_loops[index] = EventLoop::Current();
+    thread_ids.insert(std::this_thread::get_id());
+  });
+  // Stop() runs the tasks posted before it.
+  std::vector<EventLoop*> expected;
+  for (size_t i = 0; i < group.size(); ++i)
+    expected.push_back(group.event_loop(i));
+  group.Stop();
+
+  EXPECT_EQ(expected, event_loops);
+  EXPECT_EQ(4u, thread_ids.size());
+  EXPECT_EQ(0u, thread_ids.count(std::this_thread::get_id()));
+}
+
+TEST(EventLoopGroupTest, Next) {
+  EventLoopGroup::Options options;
+  options.size = 3;
+  EventLoopGroup group(options);
+
+  for (size_t i = 0; i < 2 * group.size(); ++i) {
+    EXPECT_EQ(group.event_loop(i % group.size()), group.Next());
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,181 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "base/event_loop/event_loop.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/process/process.h"
+
+#if !defined(__NR_pidfd_open)
+#define __NR_pidfd_open 434
+#endif
+
+namespace base {
+
+namespace {
+
+// The number of signals read from a signalfd at once.
+constexpr size_t kMaxSignalsPerRead = 16;
+
+int PidfdOpen(pid_t pid) {
+  return static_cast<int>(syscall(__NR_pidfd_open, pid, 0));
+}
+
+}  // namespace
+
+EventLoop::SignalWatchController::SignalWatchController() = default;
+
+EventLoop::SignalWatchController::~SignalWatchController() {
+  CHECK(StopWatchingSignal());
+  if (was_destroyed_) {
+    DCHECK(!*was_destroyed_);
+    *was_destroyed_ = true;
+  }
+}
+
+bool EventLoop::SignalWatchController::StopWatchingSignal() {
+  bool rv = controller_.StopWatchingFileDescriptor();
+  signal_fd_.reset();
+  callback_.Reset();
+  return rv;
+}
+
+void EventLoop::SignalWatchController::OnFileCanRead(int fd) {
+  // Read until EAGAIN, since EventLoop::Backend::kEpoll only notifies once
+  // per batch of signals.
+  while (true) {
+    signalfd_siginfo infos[kMaxSignalsPerRead];
+    ssize_t rv = HANDLE_EINTR(read(fd, infos, sizeof(infos)));
+    if (rv < 0) {
+      if (errno != EAGAIN) DPLOG(ERROR) << "read";
+      return;
+    }
+
+    size_t count = static_cast<size_t>(rv) / sizeof(signalfd_siginfo);
+    for (size_t i = 0; i < count; ++i) {
+      // The callback may stop watching or destroy |this|, so run a copy of
+      // it.
+      RepeatingCallback<void(const signalfd_siginfo&)> callback = callback_;
+      bool destroyed = false;
+      was_destroyed_ = &destroyed;
+      callback.Run(infos[i]);
+      if (destroyed) return;
+      was_destroyed_ = nullptr;
+      if (!signal_fd_.is_valid()) return;
+    }
+    if (count < kMaxSignalsPerRead) return;
+  }
+}
+
+void EventLoop::SignalWatchController::OnFileCanWrite(int fd) { NOTREACHED(); }
+
+EventLoop::ProcessExitWatchController::ProcessExitWatchController() = default;
+
+EventLoop::ProcessExitWatchController::~ProcessExitWatchController() {
+  CHECK(StopWatchingProcess());
+}
+
+bool EventLoop::ProcessExitWatchController::StopWatchingProcess() {
+  bool rv = controller_.StopWatchingFileDescriptor();
+  pid_fd_.reset();
+  pid_ = 0;
+  callback_.Reset();
+  return rv;
+}
+
+void EventLoop::ProcessExitWatchController::OnFileCanRead(int fd) {
+  int status = 0;
+  pid_t rv = HANDLE_EINTR(waitpid(pid_, &status, WNOHANG));
+
+  int exit_code = -1;
+  if (rv < 0) {
+    DPLOG(ERROR) << "waitpid(" << pid_ << ")";
+  } else if (rv == 0) {
+    // A pidfd becomes readable once the process exits, so waitpid() only
+    // returns 0 if somebody else reaped it and its pid got reused by another
+    // child. The pidfd stays readable, so stop watching it rather than spin.
+    DLOG(ERROR) << "Process " << pid_ << " was reaped elsewhere";
+  } else if (WIFEXITED(status)) {
+    exit_code = WEXITSTATUS(status);
+  }
+
+  // |callback| may destroy |this|.
+  OnceCallback<void(int)> callback = std::move(callback_);
+  StopWatchingProcess();
+  std::move(callback).Run(exit_code);
+}
+
+void EventLoop::ProcessExitWatchController::OnFileCanWrite(int fd) {
+  NOTREACHED();
+}
+
+bool EventLoop::WatchSignal(
+    int signo, SignalWatchController* controller,
+    RepeatingCallback<void(const signalfd_siginfo&)> callback) {
+  DCHECK(controller);
+  DCHECK(callback);
+  if (!controller->StopWatchingSignal()) return false;
+
+  sigset_t mask;
+  sigemptyset(&mask);
+  if (sigaddset(&mask, signo) != 0) {
+    DPLOG(ERROR) << "sigaddset(" << signo << ")";
+    return false;
+  }
+  int rv = pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+  if (rv != 0) {
+    errno = rv;
+    DPLOG(ERROR) << "pthread_sigmask";
+    return false;
+  }
+
+  ScopedFD signal_fd(signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC));
+  if (!signal_fd.is_valid()) {
+    DPLOG(ERROR) << "signalfd";
+    return false;
+  }
+
+  if (!WatchFileDescriptor(signal_fd.get(), true, WATCH_READ,
+                           &controller->controller_, controller)) {
+    return false;
+  }
+  controller->signal_fd_ = std::move(signal_fd);
+  controller->callback_ = std::move(callback);
+  return true;
+}
+
+bool EventLoop::WatchProcessExit(const Process& process,
+                                 ProcessExitWatchController* controller,
+                                 OnceCallback<void(int)> callback) {
+  DCHECK(process.IsValid());
+  DCHECK(!process.is_current());
+  DCHECK(controller);
+  DCHECK(callback);
+  if (!controller->StopWatchingProcess()) return false;
+
+  ScopedFD pid_fd(PidfdOpen(process.Pid()));
+  if (!pid_fd.is_valid()) {
+    if (errno != ENOSYS) DPLOG(ERROR) << "pidfd_open(" << process.Pid() << ")";
+    return false;
+  }
+
+  if (!WatchFileDescriptor(pid_fd.get(), true, WATCH_READ,
+                           &controller->controller_, controller)) {
+    return false;
+  }
+  controller->pid_fd_ = std::move(pid_fd);
+  controller->pid_ = process.Pid();
+  controller->callback_ = std::move(callback);
+  return true;
+}
+
+}  // namespace base
@@ -0,0 +1,59 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/event_loop_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/bits.h"
+#include "base/logging.h"
+
+namespace base {
+
+constexpr int Log2Histogram::kNumBuckets;
+
+Log2Histogram::Log2Histogram() { std::fill_n(buckets_, kNumBuckets, 0); }
+
+void Log2Histogram::Add(uint64_t value) {
+  ++buckets_[64 - bits::CountLeadingZeroBits(value)];
+  ++count_;
+  sum_ += value;
+  max_ = std::max(max_, value);
+}
+
+double Log2Histogram::Mean() const {
+  return count_ == 0 ? 0 : static_cast<double>(sum_) / count_;
+}
+
+uint64_t Log2Histogram::Percentile(double percentile) const {
+  DCHECK_GE(percentile, 0);
+  DCHECK_LE(percentile, 100);
+  if (count_ == 0) return 0;
+
+  uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100 * count_));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen < rank) continue;
+    if (i == 0) return 0;
+    uint64_t upper_bound = i == 64 ? UINT64_MAX : (uint64_t{1} << i) - 1;
+    return std::min(upper_bound, max_);
+  }
+  return max_;
+}
+
+constexpr size_t EventLoopStats::kMaxRecentSlowCallbacks;
+
+EventLoopStats::EventLoopStats() = default;
+
+EventLoopStats::EventLoopStats(const EventLoopStats& other) = default;
+
+EventLoopStats& EventLoopStats::operator=(const EventLoopStats& other) =
+    default;
+
+EventLoopStats::~EventLoopStats() = default;
+
+}  // namespace base
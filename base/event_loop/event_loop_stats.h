@@ -0,0 +1,105 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_EVENT_LOOP_STATS_H_
+#define BASE_EVENT_LOOP_EVENT_LOOP_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "absl/time/time.h"
+#include "base/export.h"
+
+namespace base {
+
+// A histogram of unsigned values with a bucket per power of two. Adding a
+// value costs a count-leading-zeros and a few additions, and the histogram
+// has a fixed size, so it can record every iteration of an event loop.
+// Percentiles are accurate to within a factor of two.
+class BASE_EXPORT Log2Histogram {
+ public:
+  // Bucket 0 holds 0, and bucket i holds the values in [2^(i-1), 2^i).
+  static constexpr int kNumBuckets = 65;
+
+  Log2Histogram();
+
+  void Add(uint64_t value);
+
+  uint64_t count() const { return count_; }
+  uint64_t sum() const { return sum_; }
+  uint64_t max() const { return max_; }
+  uint64_t bucket_count(int bucket) const { return buckets_[bucket]; }
+
+  // Returns 0 if the histogram is empty.
+  double Mean() const;
+
+  // Returns an upper bound of the |percentile|-th value, in [0, 100], which
+  // is at most twice that value. Returns 0 if the histogram is empty.
+  uint64_t Percentile(double percentile) const;
+
+ private:
+  uint64_t buckets_[kNumBuckets];
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t max_ = 0;
+};
+
+// What EventLoop records when its instrumentation is enabled. See
+// EventLoop::EnableInstrumentation(). The histograms of durations are in
+// nanoseconds.
+struct BASE_EXPORT EventLoopStats {
+  // The callbacks which are timed.
+  enum class CallbackType {
+    kFdRead,
+    kFdWrite,
+    // A task posted with PostTask().
+    kTask,
+    // The timers and delayed tasks which expired together.
+    kTimers,
+    kIdleWork,
+  };
+
+  // A callback which ran longer than the threshold.
+  struct SlowCallback {
+    CallbackType type;
+    // The file descriptor for kFdRead and kFdWrite, -1 otherwise.
+    int fd;
+    // The FdWatcher for kFdRead and kFdWrite, null otherwise. Only meant to
+    // identify it, it may be gone.
+    const void* watcher;
+    absl::Duration duration;
+    // When it started, on the clock of base::MonotonicNow().
+    absl::Duration start;
+  };
+
+  // The number of most recent slow callbacks kept.
+  static constexpr size_t kMaxRecentSlowCallbacks = 16;
+
+  EventLoopStats();
+  EventLoopStats(const EventLoopStats& other);
+  EventLoopStats& operator=(const EventLoopStats& other);
+  ~EventLoopStats();
+
+  // The number of iterations of EventLoop::Run().
+  uint64_t iterations = 0;
+
+  // The time spent blocked waiting for I/O, not counting the callbacks.
+  Log2Histogram poll_wait;
+  Log2Histogram fd_callback;
+  Log2Histogram task;
+  Log2Histogram timers;
+  Log2Histogram idle_work;
+  // The number of FdWatcher callbacks per poll of the backend.
+  Log2Histogram events_per_poll;
+
+  uint64_t slow_callbacks = 0;
+  // The most recent of |slow_callbacks|, oldest first.
+  std::vector<SlowCallback> recent_slow_callbacks;
+};
+
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_EVENT_LOOP_STATS_H_
@@ -0,0 +1,47 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/event_loop_stats.h"
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(Log2HistogramTest, Add) {
+  Log2Histogram histogram;
+  EXPECT_EQ(0u, histogram.Percentile(50));
+  EXPECT_EQ(0, histogram.Mean());
+
+  histogram.Add(0);
+  histogram.Add(1);
+  histogram.Add(3);
+  histogram.Add(1000);
+
+  EXPECT_EQ(4u, histogram.count());
+  EXPECT_EQ(1004u, histogram.sum());
+  EXPECT_EQ(1000u, histogram.max());
+  EXPECT_EQ(251, histogram.Mean());
+  EXPECT_EQ(1u, histogram.bucket_count(0));
+  EXPECT_EQ(1u, histogram.bucket_count(1));
+  EXPECT_EQ(1u, histogram.bucket_count(2));
+  // 2^9 <= 1000 < 2^10
+  EXPECT_EQ(1u, histogram.bucket_count(10));
+
+  histogram.Add(UINT64_MAX);
+  EXPECT_EQ(1u, histogram.bucket_count(64));
+}
+
+TEST(Log2HistogramTest, Percentile) {
+  Log2Histogram histogram;
+  for (uint64_t i = 1; i <= 100; ++i) histogram.Add(i);
+
+  // The 50th value is 50, in [32, 64).
+  EXPECT_EQ(63u, histogram.Percentile(50));
+  // The 99th value is 99, in [64, 128), which is capped by the maximum.
+  EXPECT_EQ(100u, histogram.Percentile(99));
+  EXPECT_EQ(1u, histogram.Percentile(0));
+  EXPECT_EQ(100u, histogram.Percentile(100));
+}
+
+}  // namespace base
@@ -0,0 +1,630 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/event_loop.h"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "base/io_buffer.h"
+#include "base/process/process.h"
+#include "base/time/time_util.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class IdleDelegate : public EventLoop::Delegate {
+ public:
+  bool DoIdleWork() override { return false; }
+};
+
+class TestFdWatcher : public EventLoop::FdWatcher {
+ public:
+  TestFdWatcher(std::function<void(int)> on_read,
+                std::function<void(int)> on_write)
+      : on_read_(std::move(on_read)), on_write_(std::move(on_write)) {}
+
+  // EventLoop::FdWatcher methods
+  void OnFileCanRead(int fd) override { on_read_(fd); }
+  void OnFileCanWrite(int fd) override { on_write_(fd); }
+
+ private:
+  std::function<void(int)> on_read_;
+  std::function<void(int)> on_write_;
+};
+
+std::vector<EventLoop::Backend> GetBackends() {
+  return {
+      EventLoop::Backend::kLibevent,
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+      EventLoop::Backend::kEpoll,
+#endif
+#if defined(OS_LINUX)
+      EventLoop::Backend::kIoUring,
+#endif
+  };
+}
+
+class SocketPair {
+ public:
+  SocketPair() {
+    EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds_));
+  }
+  ~SocketPair() {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  int fd(int i) const { return fds_[i]; }
+
+  void Send(int i) {
+    char c = 0;
+    EXPECT_EQ(1, send(fds_[i], &c, 1, 0));
+  }
+
+  // Reads until EAGAIN and returns the number of bytes read.
+  int Drain(int i) {
+    char buffer[64];
+    int total = 0;
+    ssize_t rv;
+    while ((rv = recv(fds_[i], buffer, sizeof(buffer), 0)) > 0) total += rv;
+    return total;
+  }
+
+ private:
+  int fds_[2];
+};
+
+}  // namespace
+
+TEST(EventLoopTest, PostDelayedTask) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  std::vector<int> order;
+  absl::Duration start = MonotonicNow();
+  absl::Duration quit_time;
+  event_loop.PostDelayedTask([&order]() { order.push_back(2); },
+                             absl::Milliseconds(20));
+  event_loop.PostDelayedTask([&order]() { order.push_back(1); },
+                             absl::Milliseconds(10));
+  event_loop.PostDelayedTask(
+      [&]() {
+        quit_time = MonotonicNow();
+        event_loop.Quit();
+      },
+      absl::Milliseconds(30));
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(std::vector<int>({1, 2}), order);
+  EXPECT_GE(quit_time - start, absl::Milliseconds(30));
+}
+
+TEST(EventLoopTest, PostDelayedTaskFromDelayedTask) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  int count = 0;
+  std::function<void()> task = [&]() {
+    if (++count == 3) {
+      event_loop.Quit();
+      return;
+    }
+    event_loop.PostDelayedTask(task, absl::ZeroDuration());
+  };
+  event_loop.PostDelayedTask(task, absl::Milliseconds(1));
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(3, count);
+}
+
+TEST(EventLoopTest, DeletesPendingDelayedTasks) {
+  struct Flag {
+    explicit Flag(bool* deleted) : deleted(deleted) {}
+    ~Flag() { *deleted = true; }
+    bool* deleted;
+  };
+
+  bool deleted = false;
+  bool ran = false;
+  {
+    EventLoop event_loop;
+    std::shared_ptr<Flag> flag = std::make_shared<Flag>(&deleted);
+    event_loop.PostDelayedTask([flag, &ran]() { ran = true; },
+                               absl::Seconds(10));
+    flag.reset();
+    EXPECT_FALSE(deleted);
+  }
+  EXPECT_TRUE(deleted);
+  EXPECT_FALSE(ran);
+}
+
+TEST(EventLoopTest, PostTaskRunsInOrder) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  std::vector<int> order;
+  for (int i = 0; i < 3; ++i) {
+    event_loop.PostTask([&order, i]() { order.push_back(i); });
+  }
+  event_loop.PostTask([&event_loop]() { event_loop.Quit(); });
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), order);
+}
+
+TEST(EventLoopTest, PostTaskRunsByPriority) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  std::vector<int> order;
+  event_loop.PostTask(EventLoop::TaskPriority::kBestEffort, [&]() {
+    order.push_back(0);
+    // Preempts the remaining best-effort task.
+    event_loop.PostTask(EventLoop::TaskPriority::kHigh,
+                        [&]() { order.push_back(1); });
+  });
+  event_loop.PostTask(EventLoop::TaskPriority::kBestEffort, [&]() {
+    order.push_back(2);
+    event_loop.Quit();
+  });
+  event_loop.PostTask([&]() { order.push_back(3); });
+  event_loop.PostTask(EventLoop::TaskPriority::kHigh,
+                      [&]() { order.push_back(4); });
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(std::vector<int>({4, 3, 0, 1, 2}), order);
+}
+
+TEST(EventLoopTest, BestEffortTasksYieldToIo) {
+  constexpr int kNumTasks = 20;
+
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    event_loop.SetBestEffortTaskBudget(absl::Milliseconds(1));
+    IdleDelegate delegate;
+    SocketPair sockets;
+
+    int tasks_run = 0;
+    int tasks_run_before_read = -1;
+    for (int i = 0; i < kNumTasks; ++i) {
+      event_loop.PostTask(EventLoop::TaskPriority::kBestEffort, [&]() {
+        if (tasks_run == 0) sockets.Send(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (++tasks_run == kNumTasks) event_loop.Quit();
+      });
+    }
+
+    EventLoop::FdWatchController controller;
+    TestFdWatcher watcher(
+        [&](int fd) {
+          sockets.Drain(0);
+          tasks_run_before_read = tasks_run;
+        },
+        [](int fd) { ADD_FAILURE(); });
+    ASSERT_TRUE(event_loop.WatchFileDescriptor(sockets.fd(0), false,
+                                               EventLoop::WATCH_READ,
+                                               &controller, &watcher));
+    event_loop.Run(&delegate);
+
+    EXPECT_EQ(kNumTasks, tasks_run);
+    EXPECT_GE(tasks_run_before_read, 1);
+    EXPECT_LT(tasks_run_before_read, kNumTasks);
+  }
+}
+
+TEST(EventLoopTest, PostTaskFromOtherThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kTasksPerThread = 10000;
+
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  // Only touched on the event loop thread.
+  int count = 0;
+  std::vector<int> last_seen(kNumThreads, -1);
+  bool in_order = true;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kTasksPerThread; ++i) {
+        event_loop.PostTask([&, t, i]() {
+          in_order &= last_seen[t] == i - 1;
+          last_seen[t] = i;
+          if (++count == kNumThreads * kTasksPerThread) event_loop.Quit();
+        });
+      }
+    });
+  }
+  event_loop.Run(&delegate);
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_EQ(kNumThreads * kTasksPerThread, count);
+  EXPECT_TRUE(in_order);
+}
+
+TEST(EventLoopTest, PostTaskWakesUpEveryBackend) {
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    IdleDelegate delegate;
+
+    bool ran = false;
+    std::thread thread([&]() {
+      event_loop.PostTask([&]() {
+        ran = true;
+        event_loop.Quit();
+      });
+    });
+    event_loop.Run(&delegate);
+    thread.join();
+
+    EXPECT_TRUE(ran);
+  }
+}
+
+TEST(EventLoopTest, BusyPoll) {
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    event_loop.SetBusyPollBudget(absl::Seconds(10));
+    IdleDelegate delegate;
+    SocketPair sockets;
+
+    // Both the readiness of a file descriptor and a task posted from another
+    // thread are seen while spinning.
+    std::thread poster;
+    EventLoop::FdWatchController controller;
+    TestFdWatcher watcher(
+        [&](int fd) {
+          sockets.Drain(0);
+          poster = std::thread([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            event_loop.PostTask([&]() { event_loop.Quit(); });
+          });
+        },
+        [](int fd) {});
+    ASSERT_TRUE(event_loop.WatchFileDescriptor(
+        sockets.fd(0), false, EventLoop::WATCH_READ, &controller, &watcher));
+    std::thread sender([&]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      sockets.Send(1);
+    });
+    event_loop.Run(&delegate);
+    sender.join();
+    poster.join();
+
+    const EventLoop::BusyPollStats& stats = event_loop.busy_poll_stats();
+    EXPECT_GE(stats.spins, 2u);
+    EXPECT_EQ(stats.spins, stats.hits);
+    EXPECT_GT(stats.spin_time, absl::ZeroDuration());
+  }
+}
+
+TEST(EventLoopTest, BusyPollBudgetRunsOut) {
+  EventLoop event_loop;
+  event_loop.SetBusyPollBudget(absl::Microseconds(100));
+  IdleDelegate delegate;
+
+  event_loop.PostDelayedTask([&]() { event_loop.Quit(); },
+                             absl::Milliseconds(10));
+  event_loop.Run(&delegate);
+
+  const EventLoop::BusyPollStats& stats = event_loop.busy_poll_stats();
+  EXPECT_GE(stats.spins, 1u);
+  EXPECT_LT(stats.hits, stats.spins);
+}
+
+TEST(EventLoopTest, BusyPollDoesNotLosePostedTasks) {
+  constexpr int kNumThreads = 4;
+  constexpr int kTasksPerThread = 10000;
+
+  EventLoop event_loop;
+  // Short enough that the event loop keeps alternating between spinning and
+  // blocking.
+  event_loop.SetBusyPollBudget(absl::Microseconds(2));
+  IdleDelegate delegate;
+
+  int count = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kTasksPerThread; ++i) {
+        event_loop.PostTask([&]() {
+          if (++count == kNumThreads * kTasksPerThread) event_loop.Quit();
+        });
+        if (i % 100 == 0) std::this_thread::yield();
+      }
+    });
+  }
+  event_loop.Run(&delegate);
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_EQ(kNumThreads * kTasksPerThread, count);
+}
+
+TEST(EventLoopTest, Instrumentation) {
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    event_loop.EnableInstrumentation(absl::Milliseconds(5));
+    IdleDelegate delegate;
+    SocketPair sockets;
+
+    EventLoop::FdWatchController controller;
+    TestFdWatcher watcher(
+        [&](int fd) {
+          sockets.Drain(0);
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+          event_loop.Quit();
+        },
+        [](int fd) {});
+    ASSERT_TRUE(event_loop.WatchFileDescriptor(
+        sockets.fd(0), false, EventLoop::WATCH_READ, &controller, &watcher));
+    event_loop.PostTask([]() {});
+    event_loop.PostDelayedTask([&]() { sockets.Send(1); },
+                               absl::Milliseconds(2));
+    event_loop.Run(&delegate);
+
+    EventLoopStats stats = event_loop.GetStats();
+    EXPECT_GT(stats.iterations, 0u);
+    EXPECT_GT(stats.poll_wait.count(), 0u);
+    EXPECT_EQ(1u, stats.fd_callback.count());
+    EXPECT_EQ(1u, stats.task.count());
+    EXPECT_EQ(1u, stats.timers.count());
+    EXPECT_GT(stats.idle_work.count(), 0u);
+    EXPECT_EQ(1u, stats.events_per_poll.max());
+
+    ASSERT_EQ(1u, stats.slow_callbacks);
+    ASSERT_EQ(1u, stats.recent_slow_callbacks.size());
+    const EventLoopStats::SlowCallback& slow = stats.recent_slow_callbacks[0];
+    EXPECT_EQ(EventLoopStats::CallbackType::kFdRead, slow.type);
+    EXPECT_EQ(sockets.fd(0), slow.fd);
+    EXPECT_EQ(&watcher, slow.watcher);
+    EXPECT_GE(slow.duration, absl::Milliseconds(10));
+
+    event_loop.DisableInstrumentation();
+    EXPECT_EQ(0u, event_loop.GetStats().iterations);
+  }
+}
+
+TEST(EventLoopTest, WatchFileDescriptor) {
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    IdleDelegate delegate;
+    SocketPair sockets;
+
+    // Every read stops and starts watching again, like SocketPosix does.
+    int reads = 0;
+    EventLoop::FdWatchController controller;
+    TestFdWatcher watcher(
+        [&](int fd) {
+          EXPECT_EQ(sockets.fd(0), fd);
+          EXPECT_EQ(1, sockets.Drain(0));
+          EXPECT_TRUE(controller.StopWatchingFileDescriptor());
+          if (++reads == 3) {
+            event_loop.Quit();
+            return;
+          }
+          sockets.Send(1);
+          EXPECT_TRUE(event_loop.WatchFileDescriptor(
+              sockets.fd(0), true, EventLoop::WATCH_READ, &controller,
+              &watcher));
+        },
+        [](int fd) { ADD_FAILURE(); });
+    ASSERT_TRUE(event_loop.WatchFileDescriptor(
+        sockets.fd(0), true, EventLoop::WATCH_READ, &controller, &watcher));
+    sockets.Send(1);
+    event_loop.Run(&delegate);
+
+    EXPECT_EQ(3, reads);
+  }
+}
+
+TEST(EventLoopTest, WatchManyFileDescriptors) {
+  // More controllers than fit in the first slab of LibeventBackend, watching
+  // twice so that the second round reuses the recycled events.
+  constexpr int kNumSockets = 150;
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    IdleDelegate delegate;
+    std::vector<std::unique_ptr<SocketPair>> sockets;
+    std::vector<std::unique_ptr<EventLoop::FdWatchController>> controllers;
+    for (int i = 0; i < kNumSockets; ++i) {
+      sockets.emplace_back(new SocketPair());
+      controllers.emplace_back(new EventLoop::FdWatchController());
+    }
+
+    int reads = 0;
+    TestFdWatcher watcher(
+        [&](int fd) {
+          char c;
+          EXPECT_EQ(1, recv(fd, &c, 1, 0));
+          if (++reads % kNumSockets == 0) event_loop.Quit();
+        },
+        [](int fd) { ADD_FAILURE(); });
+    for (int round = 0; round < 2; ++round) {
+      for (int i = 0; i < kNumSockets; ++i) {
+        ASSERT_TRUE(event_loop.WatchFileDescriptor(
+            sockets[i]->fd(0), false, EventLoop::WATCH_READ,
+            controllers[i].get(), &watcher));
+        sockets[i]->Send(1);
+      }
+      event_loop.Run(&delegate);
+      for (auto& controller : controllers)
+        EXPECT_TRUE(controller->StopWatchingFileDescriptor());
+    }
+
+    EXPECT_EQ(2 * kNumSockets, reads);
+  }
+}
+
+TEST(EventLoopTest, WatchFileDescriptorWithTwoControllers) {
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    IdleDelegate delegate;
+    SocketPair sockets;
+
+    bool wrote = false;
+    bool read = false;
+    EventLoop::FdWatchController read_controller;
+    EventLoop::FdWatchController write_controller;
+    TestFdWatcher read_watcher(
+        [&](int fd) {
+          EXPECT_TRUE(wrote);
+          EXPECT_EQ(1, sockets.Drain(0));
+          read = true;
+          event_loop.Quit();
+        },
+        [](int fd) { ADD_FAILURE(); });
+    TestFdWatcher write_watcher([](int fd) { ADD_FAILURE(); },
+                                [&](int fd) {
+                                  EXPECT_FALSE(wrote);
+                                  wrote = true;
+                                  sockets.Send(1);
+                                });
+    ASSERT_TRUE(event_loop.WatchFileDescriptor(sockets.fd(0), true,
+                                               EventLoop::WATCH_READ,
+                                               &read_controller,
+                                               &read_watcher));
+    // Not persistent, so this fires only once although the socket stays
+    // writable.
+    ASSERT_TRUE(event_loop.WatchFileDescriptor(sockets.fd(0), false,
+                                               EventLoop::WATCH_WRITE,
+                                               &write_controller,
+                                               &write_watcher));
+    event_loop.Run(&delegate);
+
+    EXPECT_TRUE(wrote);
+    EXPECT_TRUE(read);
+  }
+}
+
+#if defined(OS_LINUX)
+TEST(EventLoopTest, CompletionIo) {
+  EventLoop event_loop(EventLoop::Backend::kIoUring);
+  if (!event_loop.SupportsCompletionIo()) {
+    EXPECT_EQ(EventLoop::Backend::kEpoll, event_loop.backend());
+    return;
+  }
+  IdleDelegate delegate;
+  SocketPair sockets;
+
+  // The receive is submitted before there is anything to receive.
+  std::shared_ptr<IOBuffer> read_buf = std::make_shared<IOBuffer>(16);
+  EventLoop::IoOperation read_operation;
+  int read_result = 0;
+  event_loop.SubmitRecv(sockets.fd(0), read_buf, 16, 0, &read_operation,
+                        [&](int rv) {
+                          read_result = rv;
+                          event_loop.Quit();
+                        });
+  EXPECT_TRUE(read_operation.IsPending());
+
+  std::shared_ptr<IOBuffer> write_buf = std::make_shared<IOBuffer>(5);
+  memcpy(write_buf->data(), "hello", 5);
+  EventLoop::IoOperation write_operation;
+  int write_result = 0;
+  event_loop.SubmitSend(sockets.fd(1), write_buf, 5, 0, &write_operation,
+                        [&](int rv) { write_result = rv; });
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(5, write_result);
+  EXPECT_EQ(5, read_result);
+  EXPECT_EQ(0, memcmp(read_buf->data(), "hello", 5));
+  EXPECT_FALSE(read_operation.IsPending());
+}
+
+TEST(EventLoopTest, CancelCompletionIo) {
+  EventLoop event_loop(EventLoop::Backend::kIoUring);
+  if (!event_loop.SupportsCompletionIo()) return;
+  IdleDelegate delegate;
+  SocketPair sockets;
+
+  std::shared_ptr<IOBuffer> read_buf = std::make_shared<IOBuffer>(16);
+  EventLoop::IoOperation read_operation;
+  event_loop.SubmitRecv(sockets.fd(0), read_buf, 16, 0, &read_operation,
+                        [](int rv) { ADD_FAILURE(); });
+  read_operation.Cancel();
+  EXPECT_FALSE(read_operation.IsPending());
+
+  event_loop.PostDelayedTask([&]() { sockets.Send(1); },
+                             absl::Milliseconds(5));
+  event_loop.PostDelayedTask([&]() { event_loop.Quit(); },
+                             absl::Milliseconds(20));
+  event_loop.Run(&delegate);
+
+  // The cancelled receive hasn't consumed the byte.
+  EXPECT_EQ(1, sockets.Drain(0));
+}
+#endif  // defined(OS_LINUX)
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+TEST(EventLoopTest, WatchSignal) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGUSR1);
+  sigset_t old_mask;
+  ASSERT_EQ(0, pthread_sigmask(SIG_BLOCK, &mask, &old_mask));
+
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    IdleDelegate delegate;
+
+    int signals = 0;
+    EventLoop::SignalWatchController controller;
+    ASSERT_TRUE(event_loop.WatchSignal(
+        SIGUSR1, &controller, [&](const signalfd_siginfo& info) {
+          EXPECT_EQ(static_cast<uint32_t>(SIGUSR1), info.ssi_signo);
+          if (++signals == 2) {
+            event_loop.Quit();
+          } else {
+            event_loop.PostTask([]() { raise(SIGUSR1); });
+          }
+        }));
+    event_loop.PostTask([]() { raise(SIGUSR1); });
+    event_loop.Run(&delegate);
+
+    EXPECT_EQ(2, signals);
+    EXPECT_TRUE(controller.StopWatchingSignal());
+  }
+
+  ASSERT_EQ(0, pthread_sigmask(SIG_SETMASK, &old_mask, nullptr));
+}
+
+TEST(EventLoopTest, WatchProcessExit) {
+  for (EventLoop::Backend backend : GetBackends()) {
+    EventLoop event_loop(backend);
+    IdleDelegate delegate;
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) _exit(3);
+    Process process(pid);
+
+    int exit_code = 0;
+    EventLoop::ProcessExitWatchController controller;
+    if (!event_loop.WatchProcessExit(process, &controller, [&](int code) {
+          exit_code = code;
+          event_loop.Quit();
+        })) {
+      // The kernel lacks pidfd_open().
+      EXPECT_TRUE(process.WaitForExit(nullptr));
+      return;
+    }
+    event_loop.Run(&delegate);
+
+    EXPECT_EQ(3, exit_code);
+  }
+}
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
+}  // namespace base
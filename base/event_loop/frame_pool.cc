@@ -0,0 +1,75 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/frame_pool.h"
+
+#include <new>
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// Returns the index of the free list for |size|, which is at most
+// FramePool::kMaxSize.
+size_t GetSizeIndex(size_t size) {
+  return size == 0 ? 0 : (size - 1) / FramePool::kGranularity;
+}
+
+}  // namespace
+
+constexpr size_t FramePool::kGranularity;
+constexpr size_t FramePool::kMaxSize;
+constexpr size_t FramePool::kMaxFreeBlocks;
+
+FramePool::FramePool() = default;
+
+FramePool::~FramePool() {
+  for (FreeBlock* block : free_lists_) {
+    while (block) {
+      FreeBlock* next = block->next;
+      ::operator delete(block);
+      block = next;
+    }
+  }
+}
+
+// static
+size_t FramePool::GetAllocationSize(size_t size) {
+  if (size > kMaxSize) return size;
+  return (GetSizeIndex(size) + 1) * kGranularity;
+}
+
+void* FramePool::Allocate(size_t size) {
+  if (size > kMaxSize) return ::operator new(size);
+
+  size_t index = GetSizeIndex(size);
+  FreeBlock* block = free_lists_[index];
+  if (!block) return ::operator new(GetAllocationSize(size));
+
+  free_lists_[index] = block->next;
+  --free_counts_[index];
+  return block;
+}
+
+void FramePool::Free(void* ptr, size_t size) {
+  DCHECK(ptr);
+  if (size > kMaxSize) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  size_t index = GetSizeIndex(size);
+  if (free_counts_[index] == kMaxFreeBlocks) {
+    ::operator delete(ptr);
+    return;
+  }
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  block->next = free_lists_[index];
+  free_lists_[index] = block;
+  ++free_counts_[index];
+}
+
+}  // namespace base
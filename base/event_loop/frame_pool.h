@@ -0,0 +1,57 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_FRAME_POOL_H_
+#define BASE_EVENT_LOOP_FRAME_POOL_H_
+
+#include <stddef.h>
+
+#include "base/export.h"
+
+namespace base {
+
+// Recycles the small blocks, such as coroutine frames, which are allocated
+// and freed over and over on an EventLoop. Sizes are rounded up to a multiple
+// of |kGranularity| and freed blocks are kept on a free list per size, so
+// once the pool is warm, allocating a block of a size it has seen costs no
+// call to the heap. Blocks larger than |kMaxSize| go to the heap directly.
+//
+// Every block comes from ::operator new() with its rounded size, so it may be
+// freed to any FramePool or with ::operator delete().
+//
+// This class is not thread-safe.
+class BASE_EXPORT FramePool {
+ public:
+  static constexpr size_t kGranularity = 64;
+  static constexpr size_t kMaxSize = 4096;
+  // The number of free blocks kept per size, beyond which they go back to the
+  // heap.
+  static constexpr size_t kMaxFreeBlocks = 256;
+
+  FramePool();
+  FramePool(const FramePool& other) = delete;
+  FramePool& operator=(const FramePool& other) = delete;
+  ~FramePool();
+
+  // Returns the number of bytes allocated for a block of |size| bytes.
+  static size_t GetAllocationSize(size_t size);
+
+  void* Allocate(size_t size);
+  // |size| must be the size |ptr| was allocated with.
+  void Free(void* ptr, size_t size);
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static constexpr size_t kNumSizes = kMaxSize / kGranularity;
+
+  FreeBlock* free_lists_[kNumSizes] = {};
+  size_t free_counts_[kNumSizes] = {};
+};
+
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_FRAME_POOL_H_
@@ -0,0 +1,39 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/frame_pool.h"
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(FramePoolTest, GetAllocationSize) {
+  EXPECT_EQ(64u, FramePool::GetAllocationSize(1));
+  EXPECT_EQ(64u, FramePool::GetAllocationSize(64));
+  EXPECT_EQ(128u, FramePool::GetAllocationSize(65));
+  EXPECT_EQ(FramePool::kMaxSize,
+            FramePool::GetAllocationSize(FramePool::kMaxSize));
+  EXPECT_EQ(FramePool::kMaxSize + 1,
+            FramePool::GetAllocationSize(FramePool::kMaxSize + 1));
+}
+
+TEST(FramePoolTest, ReusesFreedBlocks) {
+  FramePool pool;
+  void* a = pool.Allocate(100);
+  void* b = pool.Allocate(200);
+  pool.Free(a, 100);
+  pool.Free(b, 200);
+
+  // Blocks are reused for any size which rounds up the same way.
+  EXPECT_EQ(a, pool.Allocate(128));
+  EXPECT_EQ(b, pool.Allocate(193));
+  void* c = pool.Allocate(100);
+  EXPECT_NE(a, c);
+
+  pool.Free(a, 128);
+  pool.Free(b, 193);
+  pool.Free(c, 100);
+}
+
+}  // namespace base
@@ -0,0 +1,453 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/io_uring_backend.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// The number of entries of the submission ring. The completion ring is twice
+// as large.
+constexpr unsigned kNumEntries = 256;
+
+// |user_data| of the entries which aren't operations. Requests are at least
+// 8-byte aligned, so neither is a valid request.
+constexpr uint64_t kCancelTag = 0;
+constexpr uint64_t kEpollPollTag = 2;
+
+// Set in |user_data| of the poll an operation is linked behind.
+constexpr uint64_t kPollBit = 1;
+
+// Loads and stores of the indices shared with the kernel.
+unsigned LoadAcquire(const unsigned* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void StoreRelease(unsigned* p, unsigned value) {
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+T* Offset(void* base, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<IoUringBackend> IoUringBackend::Create() {
+  std::unique_ptr<IoUringBackend> backend(new IoUringBackend());
+  if (!backend->Init()) return nullptr;
+  return backend;
+}
+
+IoUringBackend::IoUringBackend() = default;
+
+IoUringBackend::~IoUringBackend() {
+  if (ring_fd_ >= 0 && cqes_) {
+    // The kernel may still write to the buffers of the requests in flight, so
+    // they are cancelled and waited for.
+    for (IoUringRequest* request = inflight_requests_; request;
+         request = request->next) {
+      if (request->operation) {
+        request->operation->request_ = nullptr;
+        request->operation->backend_ = nullptr;
+        request->operation = nullptr;
+        request->callback.Reset();
+      }
+      QueueCancel(reinterpret_cast<uint64_t>(request));
+      QueueCancel(reinterpret_cast<uint64_t>(request) | kPollBit);
+    }
+    bool epoll_ready;
+    while (inflight_requests_ && Enter(1, absl::InfiniteDuration())) {
+      ReapCompletions(&epoll_ready);
+    }
+  }
+
+  while (free_requests_) {
+    IoUringRequest* request = free_requests_;
+    free_requests_ = request->next;
+    delete request;
+  }
+
+  if (sqes_) munmap(sqes_, sqes_size_);
+  if (cq_ring_ && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_) munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ >= 0 && IGNORE_EINTR(close(ring_fd_)) < 0) {
+    DPLOG(ERROR) << "close() failed";
+  }
+}
+
+bool IoUringBackend::WatchFileDescriptor(
+    int fd, bool persistent, int mode,
+    EventLoop::FdWatchController* controller) {
+  return epoll_->WatchFileDescriptor(fd, persistent, mode, controller);
+}
+
+bool IoUringBackend::StopWatchingFileDescriptor(
+    EventLoop::FdWatchController* controller) {
+  return epoll_->StopWatchingFileDescriptor(controller);
+}
+
+bool IoUringBackend::Poll(absl::Duration timeout) {
+  if (!epoll_polled_) {
+    io_uring_sqe* sqe = GetSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = epoll_->epoll_fd();
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = kEpollPollTag;
+    epoll_polled_ = true;
+  }
+
+  // Don't block if there are completions left over, e.g. from a submission
+  // which had to be made because the ring was full.
+  bool has_completions = *cq_head_ != LoadAcquire(cq_tail_);
+  unsigned min_complete =
+      (timeout == absl::ZeroDuration() || has_completions) ? 0 : 1;
+  Enter(min_complete, timeout);
+
+  bool epoll_ready = false;
+  bool processed_io_events = ReapCompletions(&epoll_ready);
+  if (epoll_ready) processed_io_events |= epoll_->Poll(absl::ZeroDuration());
+  return processed_io_events;
+}
+
+bool IoUringBackend::SupportsCompletionIo() const { return true; }
+
+void IoUringBackend::SubmitIo(IoType type, int fd,
+                              std::shared_ptr<IOBuffer> buf, int buf_len,
+                              int flags, const sockaddr* address,
+                              socklen_t address_len,
+                              EventLoop::IoOperation* operation,
+                              CompletionOnceCallback callback) {
+  DCHECK(!operation->IsPending());
+  DCHECK(buf);
+  DCHECK_GT(buf_len, 0);
+  DCHECK(!callback.is_null());
+
+  IoUringRequest* request = AllocateRequest();
+  request->type = type;
+  request->fd = fd;
+  request->flags = flags;
+  request->buffer = std::move(buf);
+  request->buffer_len = buf_len;
+  if (address) {
+    DCHECK_LE(static_cast<size_t>(address_len), sizeof(request->address));
+    memcpy(&request->address, address, address_len);
+    request->address_len = address_len;
+  } else {
+    request->address_len = 0;
+  }
+  request->operation = operation;
+  request->callback = std::move(callback);
+
+  operation->backend_ = this;
+  operation->request_ = request;
+
+  QueueRequest(request, false);
+}
+
+void IoUringBackend::CancelIo(EventLoop::IoOperation* operation) {
+  IoUringRequest* request = operation->request_;
+  DCHECK(request);
+  operation->request_ = nullptr;
+  operation->backend_ = nullptr;
+
+  // The request itself stays around until the kernel is done with it.
+  request->operation = nullptr;
+  request->callback.Reset();
+  QueueCancel(reinterpret_cast<uint64_t>(request));
+  if (request->polling) {
+    QueueCancel(reinterpret_cast<uint64_t>(request) | kPollBit);
+  }
+}
+
+bool IoUringBackend::Init() {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, kNumEntries, &params);
+  if (ring_fd_ < 0) {
+    DVPLOG(1) << "io_uring_setup() failed";
+    return false;
+  }
+  // IORING_FEAT_EXT_ARG is needed to wait with a timeout, and comes with
+  // Linux 5.11, which supports every operation used here.
+  if (!(params.features & IORING_FEAT_EXT_ARG)) {
+    DVLOG(1) << "io_uring lacks IORING_FEAT_EXT_ARG";
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    DVPLOG(1) << "mmap() failed";
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      DVPLOG(1) << "mmap() failed";
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    DVPLOG(1) << "mmap() failed";
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  sq_head_ = Offset<unsigned>(sq_ring_, params.sq_off.head);
+  sq_tail_ = Offset<unsigned>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = *Offset<unsigned>(sq_ring_, params.sq_off.ring_mask);
+  sq_entries_ = *Offset<unsigned>(sq_ring_, params.sq_off.ring_entries);
+  sq_array_ = Offset<unsigned>(sq_ring_, params.sq_off.array);
+  cq_head_ = Offset<unsigned>(cq_ring_, params.cq_off.head);
+  cq_tail_ = Offset<unsigned>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = *Offset<unsigned>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = Offset<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+  sq_local_tail_ = *sq_tail_;
+
+  epoll_.reset(new EpollBackend());
+  return true;
+}
+
+io_uring_sqe* IoUringBackend::GetSqe() {
+  if (sq_local_tail_ - LoadAcquire(sq_head_) == sq_entries_) {
+    // The ring is full. Hand the queued entries to the kernel to make room.
+    Enter(0, absl::ZeroDuration());
+    CHECK_LT(sq_local_tail_ - LoadAcquire(sq_head_), sq_entries_);
+  }
+
+  unsigned index = sq_local_tail_ & sq_mask_;
+  io_uring_sqe* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  ++sq_local_tail_;
+  return sqe;
+}
+
+void IoUringBackend::QueueRequest(IoUringRequest* request,
+                                  bool wait_for_readiness) {
+  bool is_recv = request->type == IoType::kRecv ||
+                 request->type == IoType::kRecvMsg;
+
+  if (wait_for_readiness) {
+    // The linked pair must not be split across two submissions.
+    if (sq_entries_ - (sq_local_tail_ - LoadAcquire(sq_head_)) < 2) {
+      Enter(0, absl::ZeroDuration());
+    }
+    io_uring_sqe* sqe = GetSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = request->fd;
+    sqe->poll32_events = is_recv ? POLLIN : POLLOUT;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = reinterpret_cast<uint64_t>(request) | kPollBit;
+    request->polling = true;
+    ++request->inflight;
+  }
+
+  io_uring_sqe* sqe = GetSqe();
+  sqe->fd = request->fd;
+  sqe->msg_flags = request->flags;
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  switch (request->type) {
+    case IoType::kRecv:
+    case IoType::kSend:
+      sqe->opcode = is_recv ? IORING_OP_RECV : IORING_OP_SEND;
+      sqe->addr = reinterpret_cast<uint64_t>(request->buffer->data());
+      sqe->len = request->buffer_len;
+      break;
+    case IoType::kRecvMsg:
+    case IoType::kSendMsg:
+      request->iov.iov_base = request->buffer->data();
+      request->iov.iov_len = request->buffer_len;
+      memset(&request->msg, 0, sizeof(request->msg));
+      request->msg.msg_iov = &request->iov;
+      request->msg.msg_iovlen = 1;
+      if (is_recv) {
+        request->msg.msg_name = &request->address;
+        request->msg.msg_namelen = sizeof(request->address);
+      } else if (request->address_len) {
+        request->msg.msg_name = &request->address;
+        request->msg.msg_namelen = request->address_len;
+      }
+      sqe->opcode = is_recv ? IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+      sqe->addr = reinterpret_cast<uint64_t>(&request->msg);
+      sqe->len = 1;
+      break;
+  }
+  ++request->inflight;
+}
+
+void IoUringBackend::QueueCancel(uint64_t user_data) {
+  io_uring_sqe* sqe = GetSqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = user_data;
+  sqe->user_data = kCancelTag;
+}
+
+bool IoUringBackend::Enter(unsigned min_complete, absl::Duration timeout) {
+  StoreRelease(sq_tail_, sq_local_tail_);
+  unsigned to_submit = sq_local_tail_ - LoadAcquire(sq_head_);
+  if (to_submit == 0 && min_complete == 0) return true;
+
+  unsigned flags = 0;
+  io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  __kernel_timespec ts;
+  if (min_complete) {
+    flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    if (timeout != absl::InfiniteDuration()) {
+      timespec value = absl::ToTimespec(timeout);
+      ts.tv_sec = value.tv_sec;
+      ts.tv_nsec = value.tv_nsec;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+  }
+
+  int rv = syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                   flags, min_complete ? &arg : nullptr,
+                   min_complete ? sizeof(arg) : 0);
+  if (rv < 0) {
+    // ETIME means that |timeout| has passed. EBUSY and EAGAIN mean that the
+    // completions have to be reaped before more can be submitted.
+    if (errno == EINTR || errno == ETIME || errno == EBUSY || errno == EAGAIN) {
+      return true;
+    }
+    DPLOG(ERROR) << "io_uring_enter() failed";
+    return false;
+  }
+  return true;
+}
+
+bool IoUringBackend::ReapCompletions(bool* epoll_ready) {
+  bool called = false;
+  unsigned head = *cq_head_;
+  // Completions which arrive while the callbacks run are left for the next
+  // call, so that this can't go on forever.
+  unsigned tail = LoadAcquire(cq_tail_);
+  while (head != tail) {
+    io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+    uint64_t user_data = cqe->user_data;
+    int32_t result = cqe->res;
+    StoreRelease(cq_head_, ++head);
+
+    if (user_data == kCancelTag) continue;
+    if (user_data == kEpollPollTag) {
+      epoll_polled_ = false;
+      *epoll_ready = true;
+      continue;
+    }
+    IoUringRequest* request =
+        reinterpret_cast<IoUringRequest*>(user_data & ~kPollBit);
+    called |= OnRequestCompletion(request, user_data & kPollBit, result);
+  }
+  return called;
+}
+
+bool IoUringBackend::OnRequestCompletion(IoUringRequest* request,
+                                         bool is_poll, int32_t result) {
+  DCHECK_GT(request->inflight, 0);
+  --request->inflight;
+
+  if (is_poll) {
+    // The operation linked behind the poll completes on its own, with
+    // -ECANCELED if the poll failed.
+    request->polling = false;
+  } else if (request->operation) {
+    if (result == -EAGAIN) {
+      // Non-blocking sockets may fail this way instead of being polled by
+      // the kernel. Retry once the socket is ready.
+      QueueRequest(request, true);
+      return false;
+    }
+
+    EventLoop::IoOperation* operation = request->operation;
+    if (request->type == IoType::kRecvMsg && result >= 0) {
+      memcpy(&operation->address_, &request->address,
+             request->msg.msg_namelen);
+      operation->address_len_ = request->msg.msg_namelen;
+      operation->msg_flags_ = request->msg.msg_flags;
+    }
+    operation->request_ = nullptr;
+    operation->backend_ = nullptr;
+    request->operation = nullptr;
+    CompletionOnceCallback callback = std::move(request->callback);
+    if (request->inflight == 0) FreeRequest(request);
+    std::move(callback).Run(result);
+    return true;
+  }
+
+  if (request->inflight == 0 && !request->operation) FreeRequest(request);
+  return false;
+}
+
+IoUringRequest* IoUringBackend::AllocateRequest() {
+  IoUringRequest* request = free_requests_;
+  if (request) {
+    free_requests_ = request->next;
+  } else {
+    request = new IoUringRequest();
+  }
+  request->inflight = 0;
+  request->polling = false;
+  request->prev = nullptr;
+  request->next = inflight_requests_;
+  if (inflight_requests_) inflight_requests_->prev = request;
+  inflight_requests_ = request;
+  return request;
+}
+
+void IoUringBackend::FreeRequest(IoUringRequest* request) {
+  DCHECK_EQ(request->inflight, 0);
+  if (request->prev) {
+    request->prev->next = request->next;
+  } else {
+    DCHECK_EQ(inflight_requests_, request);
+    inflight_requests_ = request->next;
+  }
+  if (request->next) request->next->prev = request->prev;
+
+  request->buffer.reset();
+  request->callback.Reset();
+  request->prev = nullptr;
+  request->next = free_requests_;
+  free_requests_ = request;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,151 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_IO_URING_BACKEND_H_
+#define BASE_EVENT_LOOP_IO_URING_BACKEND_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <memory>
+
+#include "base/event_loop/epoll_backend.h"
+#include "base/event_loop/event_loop_backend.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace base {
+namespace internal {
+
+// An operation submitted to the ring. It outlives the EventLoop::IoOperation
+// it was submitted for when that is cancelled, since the kernel may still
+// use |buffer| and |msg| until the last completion arrives.
+struct IoUringRequest {
+  EventLoopBackend::IoType type;
+  int fd;
+  int flags;
+  std::shared_ptr<IOBuffer> buffer;
+  int buffer_len;
+  iovec iov;
+  msghdr msg;
+  // The destination of kSendMsg, or the source of kRecvMsg.
+  sockaddr_storage address;
+  socklen_t address_len;
+
+  // Null once the operation has been cancelled.
+  EventLoop::IoOperation* operation;
+  CompletionOnceCallback callback;
+
+  // The number of queued entries whose completion hasn't arrived yet.
+  int inflight;
+  // Whether the operation is linked behind a poll which hasn't completed.
+  bool polling;
+
+  // Links the requests which are in flight, or the free ones.
+  IoUringRequest* prev;
+  IoUringRequest* next;
+};
+
+// EventLoopBackend on top of io_uring(7), driven with raw system calls.
+//
+// The operations submitted with SubmitIo() are queued in the submission ring
+// and handed to the kernel in a single io_uring_enter() per Poll(), which also
+// waits for their completions. File descriptors are watched by an
+// EpollBackend whose epoll file descriptor is itself polled by the ring, so
+// that a single io_uring_enter() waits for both.
+class IoUringBackend : public EventLoopBackend {
+ public:
+  // Returns null if the kernel doesn't support io_uring or a feature this
+  // needs.
+  static std::unique_ptr<IoUringBackend> Create();
+
+  IoUringBackend(const IoUringBackend& other) = delete;
+  IoUringBackend& operator=(const IoUringBackend& other) = delete;
+  ~IoUringBackend() override;
+
+  // EventLoopBackend methods
+  bool WatchFileDescriptor(int fd, bool persistent, int mode,
+                           EventLoop::FdWatchController* controller) override;
+  bool StopWatchingFileDescriptor(
+      EventLoop::FdWatchController* controller) override;
+  bool Poll(absl::Duration timeout) override;
+  bool SupportsCompletionIo() const override;
+  void SubmitIo(IoType type, int fd, std::shared_ptr<IOBuffer> buf,
+                int buf_len, int flags, const sockaddr* address,
+                socklen_t address_len, EventLoop::IoOperation* operation,
+                CompletionOnceCallback callback) override;
+  void CancelIo(EventLoop::IoOperation* operation) override;
+
+ private:
+  IoUringBackend();
+
+  // Maps the rings of |ring_fd_|. Returns false on failure.
+  bool Init();
+
+  // Returns a zeroed submission queue entry. Submits the queued ones first if
+  // the ring is full.
+  io_uring_sqe* GetSqe();
+
+  // Queues the entries for |request|. If |wait_for_readiness| is true, the
+  // operation is linked behind a poll of its file descriptor.
+  void QueueRequest(IoUringRequest* request, bool wait_for_readiness);
+
+  // Queues a cancellation of the entries with |user_data|.
+  void QueueCancel(uint64_t user_data);
+
+  // Submits the queued entries and, if |min_complete| is not 0, waits up to
+  // |timeout| for that many completions. Returns false on failure.
+  bool Enter(unsigned min_complete, absl::Duration timeout);
+
+  // Handles the available completions. Returns true if any operation
+  // callback was called. Sets |*epoll_ready| if the epoll file descriptor is
+  // readable.
+  bool ReapCompletions(bool* epoll_ready);
+
+  // Handles the completion of an entry of |request|.
+  bool OnRequestCompletion(IoUringRequest* request, bool is_poll,
+                           int32_t result);
+
+  IoUringRequest* AllocateRequest();
+  void FreeRequest(IoUringRequest* request);
+
+  int ring_fd_ = -1;
+
+  // The mapped rings. |sq_ring_| and |cq_ring_| may be the same mapping.
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  // The tail of the submission ring, published to the kernel by Enter().
+  unsigned sq_local_tail_ = 0;
+
+  // Whether the ring has a pending poll of |epoll_|'s file descriptor.
+  bool epoll_polled_ = false;
+
+  std::unique_ptr<EpollBackend> epoll_;
+
+  IoUringRequest* inflight_requests_ = nullptr;
+  IoUringRequest* free_requests_ = nullptr;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_IO_URING_BACKEND_H_
@@ -0,0 +1,162 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/libevent_backend.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "event2/event_compat.h"
+#include "event2/event_struct.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// The number of events allocated at once when the pool runs out.
+constexpr size_t kEventsPerSlab = 64;
+
+}  // namespace
+
+LibeventBackend::LibeventBackend() : event_base_(event_base_new()) {
+  CHECK(event_base_);
+  timer_event_ =
+      event_new(event_base_, -1, 0, &LibeventBackend::OnTimerEvent, this);
+  CHECK(timer_event_);
+}
+
+LibeventBackend::~LibeventBackend() {
+  DCHECK_EQ(free_events_.size(), slabs_.size() * kEventsPerSlab)
+      << "A FdWatchController outlives its event loop";
+  event_free(timer_event_);
+  event_base_free(event_base_);
+}
+
+bool LibeventBackend::WatchFileDescriptor(
+    int fd, bool persistent, int mode,
+    EventLoop::FdWatchController* controller) {
+  int event_mask = persistent ? EV_PERSIST : 0;
+  if (mode & EventLoop::WATCH_READ) {
+    event_mask |= EV_READ;
+  }
+  if (mode & EventLoop::WATCH_WRITE) {
+    event_mask |= EV_WRITE;
+  }
+
+  event* evt = controller->ReleaseEvent();
+  if (!evt) {
+    // The controller holds on to it until it stops watching.
+    evt = AllocateEvent();
+  } else {
+    // Make sure we don't pick up any funky internal libevent masks.
+    int old_interest_mask = evt->ev_events & (EV_READ | EV_WRITE | EV_PERSIST);
+
+    // Combine old/new event masks.
+    event_mask |= old_interest_mask;
+
+    // Must disarm the event before we can reuse it.
+    event_del(evt);
+
+    // It's illegal to use this function to listen on 2 separate fds with the
+    // same |controller|.
+    if (event_get_fd(evt) != fd) {
+      NOTREACHED() << "FDs don't match" << event_get_fd(evt) << "!=" << fd;
+      FreeEvent(evt);
+      return false;
+    }
+  }
+
+  // Set current interest mask and message pump for this event.
+  event_set(evt, fd, event_mask, OnNotification, controller);
+
+  // Tell libevent which message pump this socket will belong to when we add it.
+  if (event_base_set(event_base_, evt)) {
+    DPLOG(ERROR) << "event_base_set(fd=" << event_get_fd(evt) << ")";
+    FreeEvent(evt);
+    return false;
+  }
+
+  // Add this socket to the list of monitored sockets.
+  if (event_add(evt, nullptr)) {
+    DPLOG(ERROR) << "event_add failed(fd=" << event_get_fd(evt) << ")";
+    FreeEvent(evt);
+    return false;
+  }
+
+  controller->Init(evt);
+  return true;
+}
+
+bool LibeventBackend::StopWatchingFileDescriptor(
+    EventLoop::FdWatchController* controller) {
+  event* e = controller->ReleaseEvent();
+  if (!e) return true;
+
+  // event_del() is a no-op if the event isn't active.
+  bool rv = event_del(e) == 0;
+  FreeEvent(e);
+  return rv;
+}
+
+bool LibeventBackend::Poll(absl::Duration timeout) {
+  if (timeout == absl::ZeroDuration()) {
+    event_base_loop(event_base_, EVLOOP_NONBLOCK);
+  } else {
+    if (timeout == absl::InfiniteDuration()) {
+      event_del(timer_event_);
+    } else {
+      timeval tv = absl::ToTimeval(timeout);
+      if (event_add(timer_event_, &tv)) {
+        DPLOG(ERROR) << "event_add failed(timer)";
+      }
+    }
+    event_base_loop(event_base_, EVLOOP_ONCE);
+  }
+
+  bool processed_io_events = processed_io_events_;
+  processed_io_events_ = false;
+  return processed_io_events;
+}
+
+event* LibeventBackend::AllocateEvent() {
+  if (free_events_.empty()) {
+    slabs_.emplace_back(new event[kEventsPerSlab]);
+    event* slab = slabs_.back().get();
+    free_events_.reserve(slabs_.size() * kEventsPerSlab);
+    for (size_t i = kEventsPerSlab; i > 0; --i)
+      free_events_.push_back(&slab[i - 1]);
+  }
+  event* e = free_events_.back();
+  free_events_.pop_back();
+  return e;
+}
+
+void LibeventBackend::FreeEvent(event* e) { free_events_.push_back(e); }
+
+// static
+void LibeventBackend::OnNotification(evutil_socket_t fd, short flags,
+                                     void* context) {
+  EventLoop::FdWatchController* controller =
+      static_cast<EventLoop::FdWatchController*>(context);
+  DCHECK(controller);
+
+  static_cast<LibeventBackend*>(controller->backend_)->processed_io_events_ =
+      true;
+
+  int mode = 0;
+  if (flags & EV_READ) mode |= EventLoop::WATCH_READ;
+  if (flags & EV_WRITE) mode |= EventLoop::WATCH_WRITE;
+  controller->OnFileReady(fd, mode);
+}
+
+// static
+void LibeventBackend::OnTimerEvent(evutil_socket_t fd, short flags,
+                                   void* context) {
+  // Nothing to do here. This only wakes up event_base_loop(), and the expired
+  // timers are run by EventLoop::Run().
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,67 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_LIBEVENT_BACKEND_H_
+#define BASE_EVENT_LOOP_LIBEVENT_BACKEND_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/event_loop/event_loop_backend.h"
+#include "event2/event.h"
+
+namespace base {
+namespace internal {
+
+// EventLoopBackend on top of libevent.
+class LibeventBackend : public EventLoopBackend {
+ public:
+  LibeventBackend();
+  LibeventBackend(const LibeventBackend& other) = delete;
+  LibeventBackend& operator=(const LibeventBackend& other) = delete;
+  ~LibeventBackend() override;
+
+  // EventLoopBackend methods
+  bool WatchFileDescriptor(int fd, bool persistent, int mode,
+                           EventLoop::FdWatchController* controller) override;
+  bool StopWatchingFileDescriptor(
+      EventLoop::FdWatchController* controller) override;
+  bool Poll(absl::Duration timeout) override;
+
+ private:
+  // Called by libevent to tell us a registered FD can be read/written to.
+  static void OnNotification(evutil_socket_t fd, short flags, void* context);
+
+  // Called by libevent when |timer_event_| fires.
+  static void OnTimerEvent(evutil_socket_t fd, short flags, void* context);
+
+  // Returns an event for a FdWatchController to use until it stops
+  // watching, from |free_events_| or a new slab.
+  event* AllocateEvent();
+  void FreeEvent(event* e);
+
+  // This flag is set if libevent has processed I/O events.
+  bool processed_io_events_ = false;
+
+  // Libevent dispatcher.  Watches all sockets registered with it, and sends
+  // readiness callbacks when a socket is ready for I/O.
+  event_base* event_base_;
+
+  // Wakes up a blocking Poll() when its timeout has passed.
+  event* timer_event_;
+
+  // The events of the FdWatchControllers are carved out of slabs and
+  // recycled, so that watching a new file descriptor, such as an accepted
+  // socket, doesn't allocate once the pool has grown to the number of
+  // controllers watching at the same time.
+  std::vector<std::unique_ptr<event[]>> slabs_;
+  std::vector<event*> free_events_;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_LIBEVENT_BACKEND_H_
@@ -0,0 +1,233 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/timing_wheel.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+constexpr uint64_t kSlotMask = TimingWheel::kSlotsPerLevel - 1;
+
+// Entries further away than this are parked in the coarsest wheel and
+// cascaded again until they come into range.
+constexpr uint64_t kMaxDeltaTicks =
+    (uint64_t{1} << (TimingWheel::kNumLevels * TimingWheel::kBitsPerLevel)) -
+    1;
+
+constexpr int LevelShift(int level) {
+  return level * TimingWheel::kBitsPerLevel;
+}
+
+}  // namespace
+
+TimingWheel::Entry::Entry() = default;
+
+TimingWheel::Entry::~Entry() { Cancel(); }
+
+void TimingWheel::Entry::Cancel() {
+  if (wheel_) wheel_->Remove(this);
+}
+
+TimingWheel::TimingWheel(absl::Duration tick_duration, absl::Duration now)
+    : tick_duration_(tick_duration),
+      tick_nanoseconds_(absl::ToInt64Nanoseconds(tick_duration)) {
+  CHECK_GT(tick_nanoseconds_, 0);
+  current_tick_ = TickAtOrBefore(now);
+  for (int level = 0; level < kNumLevels; ++level) {
+    for (int slot = 0; slot < kSlotsPerLevel; ++slot) {
+      InitList(&slots_[level][slot]);
+    }
+  }
+}
+
+TimingWheel::~TimingWheel() {
+  for (int level = 0; level < kNumLevels; ++level) {
+    for (int slot = 0; slot < kSlotsPerLevel; ++slot) {
+      Node* head = &slots_[level][slot];
+      while (!IsListEmpty(head)) {
+        Entry* entry = static_cast<Entry*>(head->next);
+        Remove(entry);
+        entry->OnDiscarded();
+      }
+    }
+  }
+  DCHECK_EQ(size_, 0u);
+}
+
+void TimingWheel::Schedule(Entry* entry, absl::Duration deadline) {
+  DCHECK(entry);
+  entry->Cancel();
+
+  entry->wheel_ = this;
+  entry->expiration_tick_ = TickAtOrAfter(deadline);
+  ++size_;
+  Insert(entry);
+}
+
+size_t TimingWheel::Advance(absl::Duration now) {
+  uint64_t now_tick = TickAtOrBefore(now);
+  size_t count = 0;
+  while (current_tick_ <= now_tick) {
+    if (size_ == 0) {
+      current_tick_ = now_tick + 1;
+      break;
+    }
+    // Skip the ticks in which neither an entry expires nor a coarser slot
+    // needs to be cascaded.
+    uint64_t next_tick = NextEventTick();
+    if (next_tick > now_tick) {
+      current_tick_ = now_tick + 1;
+      break;
+    }
+    current_tick_ = next_tick;
+    count += ProcessCurrentTick();
+  }
+  return count;
+}
+
+absl::Duration TimingWheel::NextDeadline() const {
+  if (size_ == 0) return absl::InfiniteDuration();
+  return absl::Nanoseconds(NextEventTick() * tick_nanoseconds_);
+}
+
+// static
+void TimingWheel::InitList(Node* head) {
+  head->prev = head;
+  head->next = head;
+}
+
+// static
+bool TimingWheel::IsListEmpty(const Node* head) { return head->next == head; }
+
+// static
+void TimingWheel::Unlink(Node* node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->prev = nullptr;
+  node->next = nullptr;
+}
+
+// static
+void TimingWheel::LinkBefore(Node* head, Node* node) {
+  node->next = head;
+  node->prev = head->prev;
+  head->prev->next = node;
+  head->prev = node;
+}
+
+// static
+void TimingWheel::SpliceList(Node* from, Node* to) {
+  DCHECK(IsListEmpty(to));
+  if (IsListEmpty(from)) return;
+  to->next = from->next;
+  to->prev = from->prev;
+  to->next->prev = to;
+  to->prev->next = to;
+  InitList(from);
+}
+
+uint64_t TimingWheel::TickAtOrBefore(absl::Duration time) const {
+  int64_t nanoseconds = absl::ToInt64Nanoseconds(time);
+  if (nanoseconds <= 0) return 0;
+  return static_cast<uint64_t>(nanoseconds) / tick_nanoseconds_;
+}
+
+uint64_t TimingWheel::TickAtOrAfter(absl::Duration time) const {
+  int64_t nanoseconds = absl::ToInt64Nanoseconds(time);
+  if (nanoseconds <= 0) return 0;
+  // Can't overflow since |nanoseconds| is at most 2^63 - 1.
+  return (static_cast<uint64_t>(nanoseconds) + tick_nanoseconds_ - 1) /
+         tick_nanoseconds_;
+}
+
+uint64_t TimingWheel::NextEventTick() const {
+  DCHECK_GT(size_, 0u);
+
+  uint64_t next_tick = std::numeric_limits<uint64_t>::max();
+  for (int level = 0; level < kNumLevels; ++level) {
+    int shift = LevelShift(level);
+    // The first boundary of this level which has not been processed yet.
+    uint64_t first = (current_tick_ + (uint64_t{1} << shift) - 1) >> shift;
+    for (uint64_t i = 0; i < kSlotsPerLevel; ++i) {
+      uint64_t tick = (first + i) << shift;
+      if (tick >= next_tick) break;
+      if (!IsListEmpty(&slots_[level][(first + i) & kSlotMask])) {
+        next_tick = tick;
+        break;
+      }
+    }
+  }
+  return next_tick;
+}
+
+void TimingWheel::Insert(Entry* entry) {
+  uint64_t expiration_tick = std::max(entry->expiration_tick_, current_tick_);
+  uint64_t delta = std::min(expiration_tick - current_tick_, kMaxDeltaTicks);
+  expiration_tick = current_tick_ + delta;
+
+  int level = 0;
+  while (level < kNumLevels - 1 &&
+         delta >= (uint64_t{1} << LevelShift(level + 1))) {
+    ++level;
+  }
+  uint64_t slot = (expiration_tick >> LevelShift(level)) & kSlotMask;
+  LinkBefore(&slots_[level][slot], entry);
+}
+
+void TimingWheel::Remove(Entry* entry) {
+  DCHECK_EQ(entry->wheel_, this);
+  Unlink(entry);
+  entry->wheel_ = nullptr;
+  --size_;
+}
+
+void TimingWheel::Cascade(int level, int slot) {
+  Node entries;
+  InitList(&entries);
+  SpliceList(&slots_[level][slot], &entries);
+  while (!IsListEmpty(&entries)) {
+    Entry* entry = static_cast<Entry*>(entries.next);
+    Unlink(entry);
+    Insert(entry);
+  }
+}
+
+size_t TimingWheel::ProcessCurrentTick() {
+  // Cascade the coarser wheels whose slot boundary has been reached. The
+  // coarsest one goes first, since its entries may land in the finer slots
+  // which are cascaded at the same tick.
+  int top_level = 0;
+  while (top_level < kNumLevels - 1 &&
+         (current_tick_ & ((uint64_t{1} << LevelShift(top_level + 1)) - 1)) ==
+             0) {
+    ++top_level;
+  }
+  for (int level = top_level; level > 0; --level) {
+    Cascade(level, (current_tick_ >> LevelShift(level)) & kSlotMask);
+  }
+
+  Node expired;
+  InitList(&expired);
+  SpliceList(&slots_[0][current_tick_ & kSlotMask], &expired);
+  // Entries rescheduled by OnExpired() must not land in the slot being
+  // processed.
+  ++current_tick_;
+
+  size_t count = 0;
+  while (!IsListEmpty(&expired)) {
+    Entry* entry = static_cast<Entry*>(expired.next);
+    Remove(entry);
+    entry->OnExpired();
+    ++count;
+  }
+  return count;
+}
+
+}  // namespace base
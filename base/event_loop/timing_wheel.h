@@ -0,0 +1,132 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_EVENT_LOOP_TIMING_WHEEL_H_
+#define BASE_EVENT_LOOP_TIMING_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "absl/time/time.h"
+#include "base/export.h"
+
+namespace base {
+
+// A hierarchical timing wheel as described by Varghese & Lauck. Entries are
+// kept in intrusive lists hung off the slots of |kNumLevels| wheels, each of
+// which spans |kSlotsPerLevel| times the range of the wheel below it.
+// Scheduling and cancelling an entry are O(1) and never allocate. Advancing
+// costs O(1) per elapsed tick plus the cost of cascading entries from the
+// coarser wheels down to the finer ones.
+//
+// Deadlines are expressed as absolute values on the clock returned by
+// base::MonotonicNow() and are rounded up to the tick granularity, so an
+// entry never expires before its deadline.
+//
+// This class is not thread-safe.
+class BASE_EXPORT TimingWheel {
+ private:
+  struct Node {
+    Node* prev = nullptr;
+    Node* next = nullptr;
+  };
+
+ public:
+  static constexpr int kBitsPerLevel = 8;
+  static constexpr int kSlotsPerLevel = 1 << kBitsPerLevel;
+  static constexpr int kNumLevels = 4;
+
+  class BASE_EXPORT Entry : private Node {
+   public:
+    Entry();
+    Entry(const Entry& other) = delete;
+    Entry& operator=(const Entry& other) = delete;
+    // Cancels the entry if it is still scheduled.
+    virtual ~Entry();
+
+    bool IsScheduled() const { return wheel_ != nullptr; }
+
+    // Removes the entry from its wheel. It is a no-op if the entry is not
+    // scheduled.
+    void Cancel();
+
+   protected:
+    // Called when the deadline has passed. The entry is no longer scheduled
+    // at this point, so it may reschedule itself.
+    virtual void OnExpired() = 0;
+
+    // Called instead of OnExpired() when the wheel is destroyed while the
+    // entry is still scheduled.
+    virtual void OnDiscarded() {}
+
+   private:
+    friend class TimingWheel;
+
+    TimingWheel* wheel_ = nullptr;
+    uint64_t expiration_tick_ = 0;
+  };
+
+  // |now| is the current time on the clock used for deadlines.
+  TimingWheel(absl::Duration tick_duration, absl::Duration now);
+  TimingWheel(const TimingWheel& other) = delete;
+  TimingWheel& operator=(const TimingWheel& other) = delete;
+  ~TimingWheel();
+
+  // Schedules |entry| to expire at |deadline|. If |entry| is already
+  // scheduled, it is rescheduled. A deadline in the past expires on the next
+  // call to Advance().
+  void Schedule(Entry* entry, absl::Duration deadline);
+
+  // Expires every entry whose deadline is not later than |now|. Returns the
+  // number of entries that have expired.
+  size_t Advance(absl::Duration now);
+
+  // Returns a lower bound on the earliest deadline, which is exact if the
+  // entry is going to expire within the current rotation of the finest
+  // wheel. Returns absl::InfiniteDuration() if there is nothing scheduled.
+  absl::Duration NextDeadline() const;
+
+  absl::Duration tick_duration() const { return tick_duration_; }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+ private:
+  static void InitList(Node* head);
+  static bool IsListEmpty(const Node* head);
+  static void Unlink(Node* node);
+  static void LinkBefore(Node* head, Node* node);
+  // Moves every node of |from| to the empty list |to|.
+  static void SpliceList(Node* from, Node* to);
+
+  uint64_t TickAtOrBefore(absl::Duration time) const;
+  uint64_t TickAtOrAfter(absl::Duration time) const;
+
+  // Returns the first tick, not earlier than |current_tick_|, at which an
+  // entry expires or a non-empty slot of a coarser wheel is cascaded.
+  uint64_t NextEventTick() const;
+
+  // Puts |entry| into the slot matching its expiration tick.
+  void Insert(Entry* entry);
+  void Remove(Entry* entry);
+
+  // Re-inserts every entry of |slot| in |level|.
+  void Cascade(int level, int slot);
+
+  // Processes the tick |current_tick_| and advances to the next one.
+  size_t ProcessCurrentTick();
+
+  const absl::Duration tick_duration_;
+  const int64_t tick_nanoseconds_;
+
+  // The tick that has not been processed yet.
+  uint64_t current_tick_;
+  size_t size_ = 0;
+
+  Node slots_[kNumLevels][kSlotsPerLevel];
+};
+
+}  // namespace base
+
+#endif  // BASE_EVENT_LOOP_TIMING_WHEEL_H_
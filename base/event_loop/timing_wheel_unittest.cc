@@ -0,0 +1,235 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/event_loop/timing_wheel.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class TestEntry : public TimingWheel::Entry {
+ public:
+  TestEntry(int id, std::vector<int>* expired) : id_(id), expired_(expired) {}
+
+  int discarded_count() const { return discarded_count_; }
+
+ private:
+  // TimingWheel::Entry methods
+  void OnExpired() override { expired_->push_back(id_); }
+  void OnDiscarded() override { ++discarded_count_; }
+
+  int id_;
+  std::vector<int>* expired_;
+  int discarded_count_ = 0;
+};
+
+// Reschedules itself |count| times with |wheel|.
+class RepeatingEntry : public TimingWheel::Entry {
+ public:
+  RepeatingEntry(TimingWheel* wheel, absl::Duration* now, int count)
+      : wheel_(wheel), now_(now), count_(count) {}
+
+  int run_count() const { return run_count_; }
+
+ private:
+  // TimingWheel::Entry methods
+  void OnExpired() override {
+    ++run_count_;
+    if (run_count_ < count_) wheel_->Schedule(this, *now_);
+  }
+
+  TimingWheel* wheel_;
+  absl::Duration* now_;
+  int count_;
+  int run_count_ = 0;
+};
+
+constexpr absl::Duration kTick = absl::Milliseconds(1);
+
+}  // namespace
+
+TEST(TimingWheelTest, ExpiresAtDeadline) {
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::ZeroDuration());
+  TestEntry entry(1, &expired);
+
+  wheel.Schedule(&entry, absl::Milliseconds(5));
+  EXPECT_TRUE(entry.IsScheduled());
+  EXPECT_EQ(1u, wheel.size());
+
+  EXPECT_EQ(0u, wheel.Advance(absl::Milliseconds(4)));
+  EXPECT_TRUE(expired.empty());
+  EXPECT_EQ(1u, wheel.Advance(absl::Milliseconds(5)));
+  EXPECT_EQ(std::vector<int>({1}), expired);
+  EXPECT_FALSE(entry.IsScheduled());
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, RoundsDeadlineUp) {
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::ZeroDuration());
+  TestEntry entry(1, &expired);
+
+  wheel.Schedule(&entry, absl::Microseconds(5500));
+  EXPECT_EQ(0u, wheel.Advance(absl::Microseconds(5999)));
+  EXPECT_EQ(1u, wheel.Advance(absl::Milliseconds(6)));
+}
+
+TEST(TimingWheelTest, PastDeadlineExpiresOnNextAdvance) {
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::Milliseconds(100));
+  TestEntry entry(1, &expired);
+
+  wheel.Schedule(&entry, absl::Milliseconds(10));
+  EXPECT_EQ(absl::Milliseconds(100), wheel.NextDeadline());
+  EXPECT_EQ(1u, wheel.Advance(absl::Milliseconds(100)));
+}
+
+TEST(TimingWheelTest, CancelAndReschedule) {
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::ZeroDuration());
+  TestEntry entry1(1, &expired);
+  TestEntry entry2(2, &expired);
+
+  wheel.Schedule(&entry1, absl::Milliseconds(10));
+  wheel.Schedule(&entry2, absl::Milliseconds(10));
+  entry1.Cancel();
+  EXPECT_FALSE(entry1.IsScheduled());
+  EXPECT_EQ(1u, wheel.size());
+
+  // Rescheduling moves the entry rather than adding it twice.
+  wheel.Schedule(&entry2, absl::Milliseconds(20));
+  EXPECT_EQ(1u, wheel.size());
+
+  EXPECT_EQ(0u, wheel.Advance(absl::Milliseconds(19)));
+  EXPECT_EQ(1u, wheel.Advance(absl::Milliseconds(20)));
+  EXPECT_EQ(std::vector<int>({2}), expired);
+}
+
+TEST(TimingWheelTest, DestroyedEntryIsCancelled) {
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::ZeroDuration());
+  {
+    TestEntry entry(1, &expired);
+    wheel.Schedule(&entry, absl::Milliseconds(10));
+  }
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(0u, wheel.Advance(absl::Milliseconds(10)));
+}
+
+TEST(TimingWheelTest, CascadesFromCoarserWheels) {
+  // One deadline for each wheel, plus one which is beyond the range of all of
+  // them.
+  const std::vector<absl::Duration> kDeadlines = {
+      absl::Milliseconds(200),
+      absl::Milliseconds(70000),
+      absl::Milliseconds(20000000),
+      absl::Milliseconds(5000000000),
+  };
+
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::ZeroDuration());
+  std::vector<std::unique_ptr<TestEntry>> entries;
+  for (size_t i = 0; i < kDeadlines.size(); ++i) {
+    entries.push_back(std::make_unique<TestEntry>(i, &expired));
+    wheel.Schedule(entries.back().get(), kDeadlines[i]);
+  }
+
+  for (size_t i = 0; i < kDeadlines.size(); ++i) {
+    EXPECT_LE(wheel.NextDeadline(), kDeadlines[i]);
+    EXPECT_EQ(0u, wheel.Advance(kDeadlines[i] - kTick));
+    EXPECT_EQ(i, expired.size());
+    EXPECT_EQ(1u, wheel.Advance(kDeadlines[i]));
+    EXPECT_EQ(static_cast<int>(i), expired.back());
+  }
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, ManyEntriesExpireInOrder) {
+  constexpr int kNumEntries = 10000;
+
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::Milliseconds(12345));
+  std::vector<std::unique_ptr<TestEntry>> entries;
+  for (int i = 0; i < kNumEntries; ++i) {
+    entries.push_back(std::make_unique<TestEntry>(i, &expired));
+    // Spread the deadlines over the first two wheels in a scrambled order.
+    wheel.Schedule(entries.back().get(),
+                   absl::Milliseconds(12345 + (i * 7919) % kNumEntries * 7));
+  }
+
+  absl::Duration now = absl::Milliseconds(12342);
+  size_t total = 0;
+  while (!wheel.empty()) {
+    now += absl::Milliseconds(3);
+    size_t count = wheel.Advance(now);
+    for (size_t i = expired.size() - count; i < expired.size(); ++i) {
+      absl::Duration deadline =
+          absl::Milliseconds(12345 + (expired[i] * 7919) % kNumEntries * 7);
+      EXPECT_LE(deadline, now);
+      EXPECT_GT(deadline, now - absl::Milliseconds(3));
+    }
+    total += count;
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumEntries), total);
+}
+
+TEST(TimingWheelTest, NextDeadline) {
+  std::vector<int> expired;
+  TimingWheel wheel(kTick, absl::ZeroDuration());
+  EXPECT_EQ(absl::InfiniteDuration(), wheel.NextDeadline());
+
+  TestEntry entry1(1, &expired);
+  TestEntry entry2(2, &expired);
+  wheel.Schedule(&entry1, absl::Milliseconds(100));
+  wheel.Schedule(&entry2, absl::Milliseconds(30));
+  EXPECT_EQ(absl::Milliseconds(30), wheel.NextDeadline());
+
+  entry2.Cancel();
+  EXPECT_EQ(absl::Milliseconds(100), wheel.NextDeadline());
+
+  // Deadlines in the coarser wheels are approximated from below.
+  entry1.Cancel();
+  wheel.Schedule(&entry1, absl::Milliseconds(1000));
+  EXPECT_LE(wheel.NextDeadline(), absl::Milliseconds(1000));
+  EXPECT_GT(wheel.NextDeadline(), absl::ZeroDuration());
+}
+
+TEST(TimingWheelTest, RescheduleFromOnExpired) {
+  absl::Duration now = absl::ZeroDuration();
+  TimingWheel wheel(kTick, now);
+  RepeatingEntry entry(&wheel, &now, 3);
+
+  wheel.Schedule(&entry, now);
+  // An entry rescheduled with a deadline which has already passed expires on
+  // the next tick rather than within the same Advance().
+  EXPECT_EQ(1u, wheel.Advance(now));
+  EXPECT_EQ(0u, wheel.Advance(now));
+  now += kTick;
+  EXPECT_EQ(1u, wheel.Advance(now));
+  now += kTick;
+  EXPECT_EQ(1u, wheel.Advance(now));
+  now += kTick;
+  EXPECT_EQ(0u, wheel.Advance(now));
+  EXPECT_EQ(3, entry.run_count());
+}
+
+TEST(TimingWheelTest, DiscardsEntriesOnDestruction) {
+  std::vector<int> expired;
+  TestEntry entry(1, &expired);
+  {
+    TimingWheel wheel(kTick, absl::ZeroDuration());
+    wheel.Schedule(&entry, absl::Milliseconds(10));
+  }
+  EXPECT_FALSE(entry.IsScheduled());
+  EXPECT_EQ(1, entry.discarded_count());
+  EXPECT_TRUE(expired.empty());
+}
+
+}  // namespace base
@@ -0,0 +1,182 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_INLINE_ONCE_CALLBACK_H_
+#define BASE_INLINE_ONCE_CALLBACK_H_
+
+#include <stddef.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "base/callback.h"
+#include "base/template_util.h"
+
+namespace base {
+
+namespace internal {
+
+// Whether an lvalue of |F| can be called with |Args| and returns something
+// convertible to |R|.
+template <typename F, typename Signature, typename = void>
+struct IsInvocableAs : std::false_type {};
+
+template <typename F, typename R, typename... Args>
+struct IsInvocableAs<
+    F, R(Args...),
+    void_t<decltype(std::declval<F&>()(std::declval<Args>()...))>>
+    : std::integral_constant<
+          bool, std::is_void<R>::value ||
+                    std::is_convertible<decltype(std::declval<F&>()(
+                                            std::declval<Args>()...)),
+                                        R>::value> {};
+
+}  // namespace internal
+
+template <typename Signature, size_t kInlineSize = 48>
+class InlineOnceCallback;
+
+// A move-only OnceCallback which keeps its functor in |kInlineSize| bytes of
+// inline storage instead of a std::function, so that constructing one from a
+// lambda or absl::bind_front() with a few captures doesn't allocate. A functor
+// which is larger, over-aligned or whose move constructor may throw goes to
+// the heap instead. Unlike OnceCallback, it can hold move-only functors, but
+// it can't be copied.
+template <typename R, typename... Args, size_t kInlineSize>
+class InlineOnceCallback<R(Args...), kInlineSize> {
+ public:
+  InlineOnceCallback() = default;
+  InlineOnceCallback(std::nullptr_t) = delete;
+  template <typename F, typename Functor = std::decay_t<F>,
+            std::enable_if_t<
+                !std::is_same<Functor, InlineOnceCallback>::value &&
+                internal::IsInvocableAs<Functor, R(Args...)>::value>* =
+                nullptr>
+  InlineOnceCallback(F&& functor) {
+    Construct<Functor>(std::forward<F>(functor));
+  }
+  // A OnceCallback fits in the inline storage.
+  InlineOnceCallback(OnceCallback<R(Args...)>&& callback) {
+    if (callback.is_null()) return;
+    Construct<OnceCallbackAdapter>(OnceCallbackAdapter{std::move(callback)});
+  }
+  InlineOnceCallback(const InlineOnceCallback& other) = delete;
+  InlineOnceCallback& operator=(const InlineOnceCallback& other) = delete;
+  InlineOnceCallback(InlineOnceCallback&& other) noexcept { MoveFrom(&other); }
+  InlineOnceCallback& operator=(InlineOnceCallback&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(&other);
+    }
+    return *this;
+  }
+  ~InlineOnceCallback() { Reset(); }
+
+  // The functor is moved out of |this| before it runs, so it may destroy
+  // |this|.
+  R Run(Args... args) && {
+    InlineOnceCallback callback = std::move(*this);
+    return callback.ops_->invoke(callback.storage_,
+                                 std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  bool is_null() const { return ops_ == nullptr; }
+
+  void Reset() {
+    if (!ops_) return;
+    ops_->destroy(storage_);
+    ops_ = nullptr;
+  }
+
+ private:
+  struct OnceCallbackAdapter {
+    R operator()(Args... args) {
+      return std::move(callback).Run(std::forward<Args>(args)...);
+    }
+
+    OnceCallback<R(Args...)> callback;
+  };
+
+  // How to call, move and destroy the functor in |storage_|.
+  struct Ops {
+    R (*invoke)(void* storage, Args&&... args);
+    // Moves the functor at |from| to the uninitialized |to| and destroys the
+    // one at |from|.
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename F>
+  struct InlineOps {
+    static R Invoke(void* storage, Args&&... args) {
+      return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(void* from, void* to) {
+      F* functor = static_cast<F*>(from);
+      new (to) F(std::move(*functor));
+      functor->~F();
+    }
+    static void Destroy(void* storage) { static_cast<F*>(storage)->~F(); }
+
+    static const Ops* Get() {
+      static constexpr Ops ops = {&Invoke, &Relocate, &Destroy};
+      return &ops;
+    }
+  };
+
+  template <typename F>
+  struct HeapOps {
+    static F* Functor(void* storage) { return *static_cast<F**>(storage); }
+    static R Invoke(void* storage, Args&&... args) {
+      return (*Functor(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(void* from, void* to) { new (to) F*(Functor(from)); }
+    static void Destroy(void* storage) { delete Functor(storage); }
+
+    static const Ops* Get() {
+      static constexpr Ops ops = {&Invoke, &Relocate, &Destroy};
+      return &ops;
+    }
+  };
+
+  template <typename F>
+  using FitsInline = std::integral_constant<
+      bool, sizeof(F) <= kInlineSize && alignof(F) <= alignof(max_align_t) &&
+                std::is_nothrow_move_constructible<F>::value>;
+
+  template <typename F, typename Arg>
+  void Construct(Arg&& functor) {
+    Construct<F>(std::forward<Arg>(functor), FitsInline<F>());
+  }
+  template <typename F, typename Arg>
+  void Construct(Arg&& functor, std::true_type fits_inline) {
+    new (storage_) F(std::forward<Arg>(functor));
+    ops_ = InlineOps<F>::Get();
+  }
+  template <typename F, typename Arg>
+  void Construct(Arg&& functor, std::false_type fits_inline) {
+    new (storage_) F*(new F(std::forward<Arg>(functor)));
+    ops_ = HeapOps<F>::Get();
+  }
+
+  void MoveFrom(InlineOnceCallback* other) {
+    if (!other->ops_) return;
+    other->ops_->relocate(other->storage_, storage_);
+    ops_ = other->ops_;
+    other->ops_ = nullptr;
+  }
+
+  static_assert(kInlineSize >= sizeof(void*),
+                "The inline storage must at least hold a pointer");
+
+  alignas(max_align_t) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace base
+
+#endif  // BASE_INLINE_ONCE_CALLBACK_H_
@@ -0,0 +1,122 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/inline_once_callback.h"
+
+#include <array>
+#include <memory>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Counts how many instances are alive.
+class Counted {
+ public:
+  explicit Counted(int* alive) : alive_(alive) { ++*alive_; }
+  Counted(const Counted& other) : alive_(other.alive_) { ++*alive_; }
+  Counted(Counted&& other) noexcept : alive_(other.alive_) { ++*alive_; }
+  ~Counted() { --*alive_; }
+
+ private:
+  int* alive_;
+};
+
+}  // namespace
+
+TEST(InlineOnceCallbackTest, Run) {
+  int result = 0;
+  InlineOnceCallback<void(int)> callback([&result](int value) {
+    result = value;
+  });
+  EXPECT_FALSE(callback.is_null());
+  std::move(callback).Run(3);
+  EXPECT_EQ(3, result);
+  EXPECT_TRUE(callback.is_null());
+}
+
+TEST(InlineOnceCallbackTest, ReturnValue) {
+  InlineOnceCallback<int(int, int)> callback([](int a, int b) { return a + b; });
+  EXPECT_EQ(5, std::move(callback).Run(2, 3));
+}
+
+TEST(InlineOnceCallbackTest, MoveOnlyFunctor) {
+  std::unique_ptr<int> value(new int(7));
+  InlineOnceCallback<int()> callback(
+      [value = std::move(value)]() { return *value; });
+  InlineOnceCallback<int()> moved = std::move(callback);
+  EXPECT_TRUE(callback.is_null());
+  EXPECT_EQ(7, std::move(moved).Run());
+}
+
+TEST(InlineOnceCallbackTest, DestroysFunctor) {
+  int alive = 0;
+  {
+    Counted counted(&alive);
+    InlineOnceCallback<void()> callback([counted]() {});
+    EXPECT_EQ(2, alive);
+    InlineOnceCallback<void()> moved = std::move(callback);
+    EXPECT_EQ(2, alive);
+    moved.Reset();
+    EXPECT_EQ(1, alive);
+  }
+  EXPECT_EQ(0, alive);
+
+  Counted counted(&alive);
+  InlineOnceCallback<void()> callback([counted]() {});
+  std::move(callback).Run();
+  EXPECT_EQ(1, alive);
+}
+
+TEST(InlineOnceCallbackTest, LargeFunctor) {
+  int alive = 0;
+  std::array<int, 64> values;
+  values.fill(1);
+  {
+    Counted counted(&alive);
+    InlineOnceCallback<int(), 16> callback([values, counted]() {
+      int sum = 0;
+      for (int value : values) sum += value;
+      return sum;
+    });
+    InlineOnceCallback<int(), 16> moved = std::move(callback);
+    EXPECT_EQ(2, alive);
+    EXPECT_EQ(64, std::move(moved).Run());
+    EXPECT_EQ(1, alive);
+  }
+  EXPECT_EQ(0, alive);
+}
+
+TEST(InlineOnceCallbackTest, FromOnceCallback) {
+  int result = 0;
+  OnceCallback<void(int)> once_callback([&result](int value) {
+    result = value;
+  });
+  InlineOnceCallback<void(int)> callback(std::move(once_callback));
+  std::move(callback).Run(4);
+  EXPECT_EQ(4, result);
+
+  InlineOnceCallback<void(int)> null_callback((OnceCallback<void(int)>()));
+  EXPECT_TRUE(null_callback.is_null());
+}
+
+TEST(InlineOnceCallbackTest, RunMayDestroyOwner) {
+  int alive = 0;
+  Counted counted(&alive);
+  std::unique_ptr<InlineOnceCallback<void()>> owner;
+  bool ran = false;
+  owner.reset(new InlineOnceCallback<void()>([&, counted]() {
+    owner.reset();
+    ran = true;
+  }));
+  std::move(*owner).Run();
+  EXPECT_TRUE(ran);
+  EXPECT_FALSE(owner);
+  EXPECT_EQ(1, alive);
+}
+
+}  // namespace base
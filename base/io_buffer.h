@@ -158,6 +158,15 @@ class BASE_EXPORT WrappedIOBuffer : public IOBuffer {
   ~WrappedIOBuffer() override;
 };
 
+// The |len| bytes of |buf| from |offset| on. A list of slices is read or
+// written with a single readv() or writev(), e.g. to send a header and a body
+// without copying them into one IOBuffer.
+struct IOBufferSlice {
+  std::shared_ptr<IOBuffer> buf;
+  int len;
+  int offset = 0;
+};
+
 }  // namespace base
 
 #endif  // BASE_IO_BUFFER_H_
@@ -0,0 +1,237 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/buffered_stream_socket.h"
+
+#include <string.h>
+
+#include <utility>
+
+#include "absl/functional/bind_front.h"
+#include "base/logging.h"
+#include "base/socket/socket_errors.h"
+
+namespace base {
+
+constexpr size_t BufferedStreamSocket::kDefaultBufferSize;
+
+BufferedStreamSocket::BufferedStreamSocket(
+    std::unique_ptr<StreamSocket> transport, size_t read_buffer_size,
+    size_t write_buffer_size)
+    : read_buf_(std::make_shared<GrowableIOBuffer>()),
+      write_buffer_size_(write_buffer_size),
+      write_error_(OK),
+      transport_(std::move(transport)) {
+  DCHECK(transport_);
+  DCHECK_GT(read_buffer_size, 0u);
+  read_buf_->SetCapacity(read_buffer_size);
+}
+
+BufferedStreamSocket::~BufferedStreamSocket() = default;
+
+int BufferedStreamSocket::ReadUntil(absl::string_view delimiter,
+                                    absl::string_view* data,
+                                    CompletionOnceCallback callback) {
+  DCHECK(!delimiter.empty());
+  DCHECK(data);
+  DCHECK(read_callback_.is_null());
+
+  read_delimiter_ = std::string(delimiter);
+  read_searched_ = 0;
+  read_data_ = data;
+  int rv = DoReadLoop();
+  if (rv == ERR_IO_PENDING) read_callback_ = std::move(callback);
+  return rv;
+}
+
+int BufferedStreamSocket::ReadExactly(size_t size, absl::string_view* data,
+                                      CompletionOnceCallback callback) {
+  DCHECK(data);
+  DCHECK(read_callback_.is_null());
+
+  if (size > read_buf_->capacity()) return ERR_MSG_TOO_BIG;
+
+  read_delimiter_.clear();
+  read_size_ = size;
+  read_data_ = data;
+  int rv = DoReadLoop();
+  if (rv == ERR_IO_PENDING) read_callback_ = std::move(callback);
+  return rv;
+}
+
+absl::string_view BufferedStreamSocket::Peek() const {
+  return absl::string_view(read_buf_->StartOfBuffer() + read_begin_,
+                           read_buf_->offset() - read_begin_);
+}
+
+void BufferedStreamSocket::Consume(size_t size) {
+  DCHECK_LE(size, Peek().size());
+  read_begin_ += size;
+  read_searched_ = 0;
+}
+
+int BufferedStreamSocket::Write(absl::string_view data) {
+  if (write_error_ != OK) return write_error_;
+
+  write_buffer_.append(data.data(), data.size());
+  if (write_buf_) return OK;  // Sent once the pending write completes.
+
+  if (write_buffer_.size() >= write_buffer_size_) {
+    flush_timer_.Stop();
+    int rv = DoFlush();
+    return rv == ERR_IO_PENDING ? OK : rv;
+  }
+  if (!flush_timer_.IsRunning()) {
+    flush_timer_.Start(absl::ZeroDuration(), this,
+                       &BufferedStreamSocket::OnFlushTimerFired);
+  }
+  return OK;
+}
+
+int BufferedStreamSocket::Flush(CompletionOnceCallback callback) {
+  DCHECK(flush_callback_.is_null());
+
+  if (write_error_ != OK) return write_error_;
+
+  flush_timer_.Stop();
+  int rv = write_buf_ ? ERR_IO_PENDING : DoFlush();
+  if (rv == ERR_IO_PENDING) flush_callback_ = std::move(callback);
+  return rv;
+}
+
+size_t BufferedStreamSocket::pending_write_bytes() const {
+  return write_buffer_.size() + (write_buf_ ? write_buf_->BytesRemaining() : 0);
+}
+
+int BufferedStreamSocket::DoReadLoop() {
+  while (true) {
+    size_t size;
+    if (FindMessage(&size)) {
+      *read_data_ =
+          absl::string_view(read_buf_->StartOfBuffer() + read_begin_, size);
+      read_begin_ += size;
+      read_searched_ = 0;
+      return OK;
+    }
+
+    int rv = FillReadBuffer();
+    if (rv == ERR_IO_PENDING || rv < 0) return rv;
+    if (rv == 0) return ERR_CONNECTION_CLOSED;
+  }
+}
+
+bool BufferedStreamSocket::FindMessage(size_t* size) {
+  absl::string_view buffered = Peek();
+  if (read_delimiter_.empty()) {
+    *size = read_size_;
+    return buffered.size() >= read_size_;
+  }
+
+  // The delimiter may straddle the data which has already been searched.
+  size_t start = read_searched_ >= read_delimiter_.size()
+                     ? read_searched_ - read_delimiter_.size() + 1
+                     : 0;
+  size_t pos = buffered.find(read_delimiter_, start);
+  if (pos == absl::string_view::npos) {
+    read_searched_ = buffered.size();
+    return false;
+  }
+  *size = pos + read_delimiter_.size();
+  return true;
+}
+
+int BufferedStreamSocket::FillReadBuffer() {
+  size_t buffered = read_buf_->offset() - read_begin_;
+  size_t needed = read_delimiter_.empty() ? read_size_ : buffered + 1;
+  if (buffered == 0) {
+    read_begin_ = 0;
+    read_buf_->SetOffset(0);
+  } else if (read_begin_ + needed > read_buf_->capacity() ||
+             read_buf_->RemainingCapacity() < read_buf_->capacity() / 4) {
+    // Move the partial message to the front, rather than reading in smaller
+    // and smaller pieces.
+    memmove(read_buf_->StartOfBuffer(),
+            read_buf_->StartOfBuffer() + read_begin_, buffered);
+    read_begin_ = 0;
+    read_buf_->SetOffset(buffered);
+  }
+  if (read_buf_->RemainingCapacity() == 0) return ERR_MSG_TOO_BIG;
+
+  // |transport_| is owned by |this| and the callback won't be run once
+  // |transport_| is gone.
+  int rv = transport_->Read(
+      read_buf_, read_buf_->RemainingCapacity(),
+      absl::bind_front(&BufferedStreamSocket::OnReadComplete, this));
+  if (rv > 0) read_buf_->SetOffset(read_buf_->offset() + rv);
+  return rv;
+}
+
+void BufferedStreamSocket::OnReadComplete(int result) {
+  DCHECK(!read_callback_.is_null());
+
+  if (result > 0) {
+    read_buf_->SetOffset(read_buf_->offset() + result);
+    result = DoReadLoop();
+    if (result == ERR_IO_PENDING) return;
+  } else if (result == 0) {
+    result = ERR_CONNECTION_CLOSED;
+  }
+  std::move(read_callback_).Run(result);
+}
+
+int BufferedStreamSocket::DoFlush() {
+  while (true) {
+    if (!write_buf_ || write_buf_->BytesRemaining() == 0) {
+      write_buf_.reset();
+      if (write_buffer_.empty()) return OK;
+
+      size_t size = write_buffer_.size();
+      write_buf_ = std::make_shared<DrainableIOBuffer>(
+          std::make_shared<StringIOBuffer>(
+              std::make_unique<std::string>(std::move(write_buffer_))),
+          size);
+      write_buffer_.clear();
+    }
+
+    // |transport_| is owned by |this| and the callback won't be run once
+    // |transport_| is gone.
+    int rv = transport_->Write(
+        write_buf_, write_buf_->BytesRemaining(),
+        absl::bind_front(&BufferedStreamSocket::OnWriteComplete, this));
+    if (rv == ERR_IO_PENDING) return rv;
+    if (rv < 0) {
+      write_buf_.reset();
+      write_buffer_.clear();
+      write_error_ = rv;
+      return rv;
+    }
+    write_buf_->DidConsume(rv);
+  }
+}
+
+void BufferedStreamSocket::OnWriteComplete(int result) {
+  DCHECK(write_buf_);
+
+  if (result < 0) {
+    write_buf_.reset();
+    write_buffer_.clear();
+    write_error_ = result;
+  } else {
+    write_buf_->DidConsume(result);
+    result = DoFlush();
+    if (result == ERR_IO_PENDING) return;
+  }
+
+  if (!flush_callback_.is_null()) std::move(flush_callback_).Run(result);
+}
+
+void BufferedStreamSocket::OnFlushTimerFired() {
+  if (write_buf_) return;  // Sent once the pending write completes.
+
+  int rv = DoFlush();
+  if (rv < 0 && rv != ERR_IO_PENDING)
+    DVLOG(1) << "Failed to flush: " << rv;
+}
+
+}  // namespace base
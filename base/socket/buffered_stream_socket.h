@@ -0,0 +1,126 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SOCKET_BUFFERED_STREAM_SOCKET_H_
+#define BASE_SOCKET_BUFFERED_STREAM_SOCKET_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "base/completion_once_callback.h"
+#include "base/export.h"
+#include "base/io_buffer.h"
+#include "base/socket/stream_socket.h"
+#include "base/timer/timer.h"
+
+namespace base {
+
+// Buffers the reads and writes of a connected StreamSocket, for protocols
+// which exchange many small messages, like line based ones.
+//
+// Reads fill a receive buffer with as much as the socket has, and the
+// messages are handed out as views into it, without copying. ReadUntil() and
+// ReadExactly() hold at most |read_buffer_size| bytes, which bounds the size
+// of a message.
+//
+// Writes are copied into a send buffer, which is flushed on the next
+// iteration of the EventLoop, or as soon as it holds |write_buffer_size|
+// bytes, so that the writes of one iteration go out in one system call.
+// Flush() sends the buffered data right away.
+//
+// At most one ReadUntil() or ReadExactly(), and one Flush() may be in progress
+// at a time.
+class BASE_EXPORT BufferedStreamSocket {
+ public:
+  static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+  explicit BufferedStreamSocket(
+      std::unique_ptr<StreamSocket> transport,
+      size_t read_buffer_size = kDefaultBufferSize,
+      size_t write_buffer_size = kDefaultBufferSize);
+  BufferedStreamSocket(const BufferedStreamSocket& other) = delete;
+  BufferedStreamSocket& operator=(const BufferedStreamSocket& other) = delete;
+  ~BufferedStreamSocket();
+
+  StreamSocket* transport() const { return transport_.get(); }
+
+  // Reads until |delimiter| and sets |*data| to the data up to and including
+  // it, which is consumed. Returns OK if |*data| is set right away, otherwise
+  // ERR_IO_PENDING and runs |callback| once it is. Returns ERR_MSG_TOO_BIG
+  // if the delimiter doesn't turn up within the read buffer, and
+  // ERR_CONNECTION_CLOSED if the peer closes the connection first. |*data|
+  // stays valid until the next ReadUntil() or ReadExactly().
+  int ReadUntil(absl::string_view delimiter, absl::string_view* data,
+                CompletionOnceCallback callback);
+
+  // Like ReadUntil(), but reads exactly |size| bytes.
+  int ReadExactly(size_t size, absl::string_view* data,
+                  CompletionOnceCallback callback);
+
+  // Returns the data which has been received but not consumed yet, without
+  // consuming it. It stays valid until the next ReadUntil() or ReadExactly().
+  absl::string_view Peek() const;
+
+  // Consumes the first |size| bytes of Peek().
+  void Consume(size_t size);
+
+  // Buffers |data| to be sent. Returns OK, or the error of an earlier write
+  // which failed, after which nothing more is sent.
+  int Write(absl::string_view data);
+
+  // Sends the buffered data. Returns OK if it is all sent right away, otherwise
+  // ERR_IO_PENDING and runs |callback| once it is, or returns the error.
+  int Flush(CompletionOnceCallback callback);
+
+  // The number of bytes buffered or being sent.
+  size_t pending_write_bytes() const;
+
+ private:
+  // Returns OK once the pending read has a complete message, otherwise reads
+  // from |transport_|.
+  int DoReadLoop();
+  // Sets |*size| to the size of the message at the front of the receive
+  // buffer. Returns false if it hasn't been received completely yet.
+  bool FindMessage(size_t* size);
+  int FillReadBuffer();
+  void OnReadComplete(int result);
+
+  // Writes the buffered data until it is all sent or |transport_| would block.
+  int DoFlush();
+  void OnWriteComplete(int result);
+  void OnFlushTimerFired();
+
+  // |read_buf_| holds the received data from |read_begin_| on, up to its
+  // offset(), where the next read goes.
+  std::shared_ptr<GrowableIOBuffer> read_buf_;
+  size_t read_begin_ = 0;
+
+  // The pending ReadUntil() or ReadExactly(). |read_delimiter_| is empty for
+  // ReadExactly().
+  std::string read_delimiter_;
+  size_t read_size_ = 0;
+  // The bytes already searched for |read_delimiter_|.
+  size_t read_searched_ = 0;
+  absl::string_view* read_data_ = nullptr;
+  CompletionOnceCallback read_callback_;
+
+  const size_t write_buffer_size_;
+  // The data written since the last flush began.
+  std::string write_buffer_;
+  // The data being sent, if any.
+  std::shared_ptr<DrainableIOBuffer> write_buf_;
+  int write_error_;
+  CompletionOnceCallback flush_callback_;
+  OneShotTimer flush_timer_;
+
+  // Destroyed first, so that it doesn't outlive the buffers it reads into.
+  std::unique_ptr<StreamSocket> transport_;
+};
+
+}  // namespace base
+
+#endif  // BASE_SOCKET_BUFFERED_STREAM_SOCKET_H_
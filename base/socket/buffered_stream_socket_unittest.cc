@@ -0,0 +1,108 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/buffered_stream_socket.h"
+
+#include <memory>
+#include <string>
+
+#include "base/event_loop/event_loop.h"
+#include "base/socket/socket_errors.h"
+#include "base/test/socket_test_util.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class BufferedStreamSocketTest : public LoopbackPeerTest {
+ protected:
+  // Creates |socket_| with |read_buffer_size|, connected to |peer_fd_|.
+  void Connect(size_t read_buffer_size) {
+    socket_ = std::make_unique<BufferedStreamSocket>(ConnectToPeer(),
+                                                     read_buffer_size);
+  }
+
+  // Waits for the result of a read which returned |rv|.
+  int WaitForResult(int rv, int* result) {
+    if (rv != ERR_IO_PENDING) return rv;
+    event_loop_.Run(&delegate_);
+    return *result;
+  }
+
+  std::unique_ptr<BufferedStreamSocket> socket_;
+};
+
+}  // namespace
+
+TEST_F(BufferedStreamSocketTest, ReadUntilAndReadExactly) {
+  Connect(BufferedStreamSocket::kDefaultBufferSize);
+  SendFromPeer("GET / HTTP/1.1\r\nHost: a\r\nbody");
+
+  absl::string_view data;
+  int result = ERR_IO_PENDING;
+  auto callback = [&](int rv) {
+    result = rv;
+    event_loop_.Quit();
+  };
+  int rv = socket_->ReadUntil("\r\n", &data, callback);
+  ASSERT_EQ(OK, WaitForResult(rv, &result));
+  EXPECT_EQ("GET / HTTP/1.1\r\n", data);
+  rv = socket_->ReadUntil("\r\n", &data, callback);
+  ASSERT_EQ(OK, WaitForResult(rv, &result));
+  EXPECT_EQ("Host: a\r\n", data);
+  rv = socket_->ReadExactly(4, &data, callback);
+  ASSERT_EQ(OK, WaitForResult(rv, &result));
+  EXPECT_EQ("body", data);
+  EXPECT_TRUE(socket_->Peek().empty());
+
+  // The delimiter is split across two reads.
+  result = ERR_IO_PENDING;
+  ASSERT_EQ(ERR_IO_PENDING, socket_->ReadUntil("\r\n", &data, callback));
+  SendFromPeer("line\r");
+  RunUntil([this]() { return socket_->Peek() == "line\r"; });
+  EXPECT_EQ(ERR_IO_PENDING, result);
+  SendFromPeer("\nnext");
+  ASSERT_EQ(OK, WaitForResult(ERR_IO_PENDING, &result));
+  EXPECT_EQ("line\r\n", data);
+
+  RunUntil([this]() { return socket_->Peek() == "next"; });
+  socket_->Consume(2);
+  EXPECT_EQ("xt", socket_->Peek());
+}
+
+TEST_F(BufferedStreamSocketTest, ReadUntilMessageTooBig) {
+  Connect(8);
+  SendFromPeer("0123456789");
+
+  absl::string_view data;
+  int result = ERR_IO_PENDING;
+  int rv = socket_->ReadUntil("\n", &data, [&](int rv) {
+    result = rv;
+    event_loop_.Quit();
+  });
+  EXPECT_EQ(ERR_MSG_TOO_BIG, WaitForResult(rv, &result));
+  EXPECT_EQ(ERR_MSG_TOO_BIG,
+            socket_->ReadExactly(9, &data, [](int rv) { NOTREACHED(); }));
+}
+
+TEST_F(BufferedStreamSocketTest, CoalescesWrites) {
+  Connect(BufferedStreamSocket::kDefaultBufferSize);
+
+  EXPECT_EQ(OK, socket_->Write("a"));
+  EXPECT_EQ(OK, socket_->Write("b"));
+  EXPECT_EQ(OK, socket_->Write("c"));
+  EXPECT_EQ(3u, socket_->pending_write_bytes());
+  EXPECT_EQ("", ReceiveOnPeer());
+
+  // Sent together on the next iteration of the EventLoop.
+  RunUntil([this]() { return socket_->pending_write_bytes() == 0; });
+  EXPECT_EQ("abc", ReceiveOnPeer());
+
+  EXPECT_EQ(OK, socket_->Write("d"));
+  EXPECT_EQ(OK, socket_->Flush([](int rv) { NOTREACHED(); }));
+  EXPECT_EQ("d", ReceiveOnPeer());
+}
+
+}  // namespace base
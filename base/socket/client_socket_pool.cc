@@ -0,0 +1,326 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/client_socket_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/functional/bind_front.h"
+#include "base/auto_reset.h"
+#include "base/logging.h"
+#include "base/socket/address_list.h"
+#include "base/socket/socket_errors.h"
+#include "base/time/time_util.h"
+
+namespace base {
+
+ClientSocketPool::Group::Group() = default;
+
+ClientSocketPool::Group::~Group() = default;
+
+ClientSocketPool::ClientSocketPool() : ClientSocketPool(Options()) {}
+
+ClientSocketPool::ClientSocketPool(const Options& options)
+    : options_(options) {
+  DCHECK_GT(options_.max_sockets_per_endpoint, 0u);
+  DCHECK_GE(options_.max_sockets, options_.max_sockets_per_endpoint);
+}
+
+ClientSocketPool::~ClientSocketPool() = default;
+
+int ClientSocketPool::RequestSocket(const IPEndPoint& endpoint,
+                                    std::unique_ptr<TCPClientSocket>* socket,
+                                    CompletionOnceCallback callback) {
+  DCHECK(socket);
+  DCHECK(!callback.is_null());
+
+  Group& group = groups_[endpoint];
+  if (TakeIdleSocket(&group, socket)) {
+    ++group.active_socket_count;
+    return OK;
+  }
+
+  // Connects already in flight, e.g. from Preconnect(), serve the pending
+  // requests in order, so only start one if they are all spoken for.
+  if (group.connecting_sockets.size() <= group.pending_requests.size()) {
+    if (group.socket_count() < options_.max_sockets_per_endpoint &&
+        socket_count_ >= options_.max_sockets) {
+      CloseOldestIdleSocket();
+    }
+    if (HasRoom(group)) {
+      int rv = ConnectSocket(endpoint, &group, socket);
+      if (rv == OK) {
+        ++group.active_socket_count;
+        return OK;
+      }
+      if (rv != ERR_IO_PENDING) {
+        EraseGroupIfEmpty(endpoint);
+        return rv;
+      }
+    }
+  }
+
+  group.pending_requests.push_back(Request{socket, std::move(callback)});
+  return ERR_IO_PENDING;
+}
+
+void ClientSocketPool::CancelRequest(const IPEndPoint& endpoint,
+                                     std::unique_ptr<TCPClientSocket>* socket) {
+  auto it = groups_.find(endpoint);
+  if (it == groups_.end()) return;
+
+  std::deque<Request>& requests = it->second.pending_requests;
+  auto request = std::find_if(
+      requests.begin(), requests.end(),
+      [socket](const Request& request) { return request.socket == socket; });
+  if (request != requests.end()) requests.erase(request);
+  EraseGroupIfEmpty(endpoint);
+}
+
+void ClientSocketPool::ReleaseSocket(const IPEndPoint& endpoint,
+                                     std::unique_ptr<TCPClientSocket> socket) {
+  auto it = groups_.find(endpoint);
+  DCHECK(it != groups_.end());
+  Group& group = it->second;
+  DCHECK_GT(group.active_socket_count, 0u);
+  --group.active_socket_count;
+
+  if (socket && socket->IsConnectedAndIdle()) {
+    HandOutOrAddIdleSocket(&group, std::move(socket));
+    // Another end point may be waiting for room, which the idle socket takes.
+    if (socket_count_ >= options_.max_sockets) ProcessPendingRequests();
+    return;
+  }
+
+  socket.reset();
+  --socket_count_;
+  // Erases |group| if that was its last socket.
+  ProcessPendingRequests();
+}
+
+void ClientSocketPool::Preconnect(const IPEndPoint& endpoint,
+                                  size_t num_sockets) {
+  {
+    AutoReset<bool> keep_empty_groups(&keep_empty_groups_, true);
+    Group& group = groups_[endpoint];
+    while (group.socket_count() < num_sockets && HasRoom(group)) {
+      std::unique_ptr<TCPClientSocket> socket;
+      int rv = ConnectSocket(endpoint, &group, &socket);
+      if (rv == OK) {
+        HandOutOrAddIdleSocket(&group, std::move(socket));
+      } else if (rv != ERR_IO_PENDING) {
+        DVLOG(1) << "Preconnect to " << endpoint.ToString()
+                 << " failed: " << rv;
+        break;
+      }
+    }
+  }
+  EraseGroupIfEmpty(endpoint);
+}
+
+void ClientSocketPool::CloseIdleSockets() {
+  for (auto& entry : groups_) {
+    socket_count_ -= entry.second.idle_sockets.size();
+    entry.second.idle_sockets.clear();
+  }
+  cleanup_timer_.Stop();
+  EraseEmptyGroups();
+}
+
+size_t ClientSocketPool::IdleSocketCount() const {
+  size_t count = 0;
+  for (const auto& entry : groups_) count += entry.second.idle_sockets.size();
+  return count;
+}
+
+size_t ClientSocketPool::IdleSocketCountForEndpoint(
+    const IPEndPoint& endpoint) const {
+  auto it = groups_.find(endpoint);
+  return it == groups_.end() ? 0 : it->second.idle_sockets.size();
+}
+
+bool ClientSocketPool::HasRoom(const Group& group) const {
+  return group.socket_count() < options_.max_sockets_per_endpoint &&
+         socket_count_ < options_.max_sockets;
+}
+
+bool ClientSocketPool::TakeIdleSocket(
+    Group* group, std::unique_ptr<TCPClientSocket>* socket) {
+  while (!group->idle_sockets.empty()) {
+    std::unique_ptr<TCPClientSocket> idle_socket =
+        std::move(group->idle_sockets.back().socket);
+    group->idle_sockets.pop_back();
+    if (idle_socket->IsConnectedAndIdle()) {
+      *socket = std::move(idle_socket);
+      return true;
+    }
+    --socket_count_;
+  }
+  return false;
+}
+
+int ClientSocketPool::ConnectSocket(const IPEndPoint& endpoint, Group* group,
+                                    std::unique_ptr<TCPClientSocket>* socket) {
+  auto connecting_socket =
+      std::make_unique<TCPClientSocket>(AddressList(endpoint));
+  ++socket_count_;
+  // The pool owns |connecting_socket| and the callback won't be run once it is
+  // gone.
+  int rv = connecting_socket->Connect(
+      absl::bind_front(&ClientSocketPool::OnConnectComplete, this, endpoint,
+                       connecting_socket.get()));
+  if (rv == OK) {
+    *socket = std::move(connecting_socket);
+  } else if (rv == ERR_IO_PENDING) {
+    group->connecting_sockets.push_back(std::move(connecting_socket));
+  } else {
+    --socket_count_;
+  }
+  return rv;
+}
+
+void ClientSocketPool::OnConnectComplete(IPEndPoint endpoint,
+                                         TCPClientSocket* socket, int result) {
+  DCHECK_NE(ERR_IO_PENDING, result);
+
+  Group& group = groups_[endpoint];
+  auto it = std::find_if(
+      group.connecting_sockets.begin(), group.connecting_sockets.end(),
+      [socket](const std::unique_ptr<TCPClientSocket>& connecting_socket) {
+        return connecting_socket.get() == socket;
+      });
+  DCHECK(it != group.connecting_sockets.end());
+  std::unique_ptr<TCPClientSocket> connected_socket = std::move(*it);
+  group.connecting_sockets.erase(it);
+
+  if (result == OK) {
+    HandOutOrAddIdleSocket(&group, std::move(connected_socket));
+    return;
+  }
+
+  connected_socket.reset();
+  --socket_count_;
+  // The first request would have got the socket, so it gets the error.
+  if (!group.pending_requests.empty()) {
+    Request request = std::move(group.pending_requests.front());
+    group.pending_requests.pop_front();
+    std::move(request.callback).Run(result);
+  }
+  // Erases |group| if that was its last socket.
+  ProcessPendingRequests();
+}
+
+void ClientSocketPool::HandOutOrAddIdleSocket(
+    Group* group, std::unique_ptr<TCPClientSocket> socket) {
+  if (!group->pending_requests.empty()) {
+    Request request = std::move(group->pending_requests.front());
+    group->pending_requests.pop_front();
+    *request.socket = std::move(socket);
+    ++group->active_socket_count;
+    std::move(request.callback).Run(OK);
+    return;
+  }
+
+  group->idle_sockets.push_back(IdleSocket{std::move(socket), MonotonicNow()});
+  if (!cleanup_timer_.IsRunning()) {
+    cleanup_timer_.Start(options_.cleanup_interval, this,
+                         &ClientSocketPool::OnCleanupTimerFired);
+  }
+}
+
+void ClientSocketPool::ProcessPendingRequests() {
+  {
+    // The callbacks may call back into the pool.
+    AutoReset<bool> keep_empty_groups(&keep_empty_groups_, true);
+    bool out_of_room = false;
+    for (auto& entry : groups_) {
+      Group& group = entry.second;
+      while (group.pending_requests.size() > group.connecting_sockets.size()) {
+        if (group.socket_count() < options_.max_sockets_per_endpoint &&
+            socket_count_ >= options_.max_sockets && !CloseOldestIdleSocket()) {
+          out_of_room = true;
+          break;
+        }
+        if (!HasRoom(group)) break;
+
+        std::unique_ptr<TCPClientSocket> socket;
+        int rv = ConnectSocket(entry.first, &group, &socket);
+        if (rv == OK) {
+          HandOutOrAddIdleSocket(&group, std::move(socket));
+        } else if (rv != ERR_IO_PENDING) {
+          Request request = std::move(group.pending_requests.front());
+          group.pending_requests.pop_front();
+          std::move(request.callback).Run(rv);
+        }
+      }
+      if (out_of_room) break;
+    }
+  }
+  EraseEmptyGroups();
+}
+
+bool ClientSocketPool::CloseOldestIdleSocket() {
+  auto oldest = groups_.end();
+  for (auto it = groups_.begin(); it != groups_.end(); ++it) {
+    const std::vector<IdleSocket>& idle_sockets = it->second.idle_sockets;
+    if (idle_sockets.empty()) continue;
+    if (oldest == groups_.end() ||
+        idle_sockets.front().idle_since <
+            oldest->second.idle_sockets.front().idle_since) {
+      oldest = it;
+    }
+  }
+  if (oldest == groups_.end()) return false;
+
+  std::vector<IdleSocket>& idle_sockets = oldest->second.idle_sockets;
+  idle_sockets.erase(idle_sockets.begin());
+  --socket_count_;
+  EraseGroupIfEmpty(oldest->first);
+  return true;
+}
+
+void ClientSocketPool::OnCleanupTimerFired() {
+  absl::Duration now = MonotonicNow();
+  bool closed_any = false;
+  for (auto& entry : groups_) {
+    std::vector<IdleSocket>& idle_sockets = entry.second.idle_sockets;
+    auto end = std::remove_if(
+        idle_sockets.begin(), idle_sockets.end(),
+        [this, now](const IdleSocket& idle_socket) {
+          return now - idle_socket.idle_since >= options_.idle_timeout ||
+                 !idle_socket.socket->IsConnectedAndIdle();
+        });
+    if (end != idle_sockets.end()) {
+      socket_count_ -= static_cast<size_t>(idle_sockets.end() - end);
+      idle_sockets.erase(end, idle_sockets.end());
+      closed_any = true;
+    }
+  }
+  EraseEmptyGroups();
+
+  if (IdleSocketCount() == 0) cleanup_timer_.Stop();
+  if (closed_any) ProcessPendingRequests();
+}
+
+void ClientSocketPool::EraseGroupIfEmpty(const IPEndPoint& endpoint) {
+  if (keep_empty_groups_) return;
+  auto it = groups_.find(endpoint);
+  if (it != groups_.end() && it->second.socket_count() == 0 &&
+      it->second.pending_requests.empty()) {
+    groups_.erase(it);
+  }
+}
+
+void ClientSocketPool::EraseEmptyGroups() {
+  if (keep_empty_groups_) return;
+  for (auto it = groups_.begin(); it != groups_.end();) {
+    if (it->second.socket_count() == 0 && it->second.pending_requests.empty())
+      it = groups_.erase(it);
+    else
+      ++it;
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,164 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SOCKET_CLIENT_SOCKET_POOL_H_
+#define BASE_SOCKET_CLIENT_SOCKET_POOL_H_
+
+#include <stddef.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "base/completion_once_callback.h"
+#include "base/export.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/tcp_client_socket.h"
+#include "base/timer/timer.h"
+
+namespace base {
+
+// Keeps connected TCPClientSocket around for reuse, so that requests to the
+// same end point don't each pay for a handshake. Sockets are handed out by
+// RequestSocket(), and must be given back with ReleaseSocket(), even if they
+// are no longer usable, since they count towards the limits until then. An
+// idle socket is only reused or kept while IsConnectedAndIdle(), so that one
+// the peer has closed, or which has unread data, is never handed out.
+//
+// When the limits are reached, requests wait until a socket is released, and
+// are served in order. Must be used on a single thread with an EventLoop.
+class BASE_EXPORT ClientSocketPool {
+ public:
+  struct Options {
+    // The maximum number of sockets per end point, including the idle,
+    // connecting and handed out ones.
+    size_t max_sockets_per_endpoint = 6;
+    // The maximum number of sockets overall.
+    size_t max_sockets = 256;
+    // Idle sockets are closed once they have been idle for this long.
+    absl::Duration idle_timeout = absl::Seconds(60);
+    // How often idle sockets are checked.
+    absl::Duration cleanup_interval = absl::Seconds(10);
+  };
+
+  // Uses the default Options.
+  ClientSocketPool();
+  explicit ClientSocketPool(const Options& options);
+  ClientSocketPool(const ClientSocketPool& other) = delete;
+  ClientSocketPool& operator=(const ClientSocketPool& other) = delete;
+  // Closes the idle sockets and cancels the pending requests.
+  ~ClientSocketPool();
+
+  // Sets |*socket| to a socket connected to |endpoint|, reusing the most
+  // recently used idle one if possible. Returns OK if |*socket| is set right
+  // away. Otherwise returns ERR_IO_PENDING and runs |callback| once |*socket|
+  // is set, or with the error of a connect which failed, or returns that
+  // error right away. |socket| must stay valid until then, or until
+  // CancelRequest().
+  int RequestSocket(const IPEndPoint& endpoint,
+                    std::unique_ptr<TCPClientSocket>* socket,
+                    CompletionOnceCallback callback);
+
+  // Cancels the pending request which would set |*socket|. The connect it may
+  // have started still completes, and leaves an idle socket.
+  void CancelRequest(const IPEndPoint& endpoint,
+                     std::unique_ptr<TCPClientSocket>* socket);
+
+  // Gives back a socket which RequestSocket() handed out for |endpoint|. It is
+  // kept for reuse if IsConnectedAndIdle(), and closed otherwise.
+  void ReleaseSocket(const IPEndPoint& endpoint,
+                     std::unique_ptr<TCPClientSocket> socket);
+
+  // Connects up to |num_sockets| sockets to |endpoint| ahead of time,
+  // counting the ones the pool already has, within the limits.
+  void Preconnect(const IPEndPoint& endpoint, size_t num_sockets);
+
+  // Closes all idle sockets.
+  void CloseIdleSockets();
+
+  // Returns the number of sockets, including the idle, connecting and handed
+  // out ones.
+  size_t socket_count() const { return socket_count_; }
+  // Returns the number of end points with sockets or pending requests.
+  size_t group_count() const { return groups_.size(); }
+  size_t IdleSocketCount() const;
+  size_t IdleSocketCountForEndpoint(const IPEndPoint& endpoint) const;
+
+ private:
+  struct IdleSocket {
+    std::unique_ptr<TCPClientSocket> socket;
+    // On the clock of MonotonicNow().
+    absl::Duration idle_since;
+  };
+
+  struct Request {
+    std::unique_ptr<TCPClientSocket>* socket;
+    CompletionOnceCallback callback;
+  };
+
+  struct Group {
+    Group();
+    ~Group();
+
+    size_t socket_count() const {
+      return idle_sockets.size() + connecting_sockets.size() +
+             active_socket_count;
+    }
+
+    // Most recently used last.
+    std::vector<IdleSocket> idle_sockets;
+    std::vector<std::unique_ptr<TCPClientSocket>> connecting_sockets;
+    // The number of sockets handed out.
+    size_t active_socket_count = 0;
+    std::deque<Request> pending_requests;
+  };
+
+  bool HasRoom(const Group& group) const;
+
+  // Moves a usable idle socket of |group| to |*socket|, closing the unusable
+  // ones on the way. Returns false if there is none.
+  bool TakeIdleSocket(Group* group, std::unique_ptr<TCPClientSocket>* socket);
+
+  // Starts connecting a new socket to |endpoint|, which is moved to |*socket|
+  // if it connects right away.
+  int ConnectSocket(const IPEndPoint& endpoint, Group* group,
+                    std::unique_ptr<TCPClientSocket>* socket);
+  void OnConnectComplete(IPEndPoint endpoint, TCPClientSocket* socket,
+                         int result);
+
+  // Hands |socket| to the first pending request of |group|, or keeps it idle.
+  void HandOutOrAddIdleSocket(Group* group,
+                              std::unique_ptr<TCPClientSocket> socket);
+
+  // Starts connects for the pending requests which are not waiting for one,
+  // within the limits.
+  void ProcessPendingRequests();
+
+  // Closes the least recently used idle socket to make room for a socket to
+  // another end point. Returns false if there is none.
+  bool CloseOldestIdleSocket();
+
+  // Erases the group of |endpoint|, or all groups, if they have neither
+  // sockets nor pending requests, unless |keep_empty_groups_| is set.
+  void EraseGroupIfEmpty(const IPEndPoint& endpoint);
+  void EraseEmptyGroups();
+
+  void OnCleanupTimerFired();
+
+  const Options options_;
+
+  std::map<IPEndPoint, Group> groups_;
+  size_t socket_count_ = 0;
+  // Set while a Group is used across callbacks, which could otherwise erase
+  // it from under the caller.
+  bool keep_empty_groups_ = false;
+
+  RepeatingTimer cleanup_timer_;
+};
+
+}  // namespace base
+
+#endif  // BASE_SOCKET_CLIENT_SOCKET_POOL_H_
@@ -0,0 +1,176 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/client_socket_pool.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include "absl/time/time.h"
+#include "base/event_loop/event_loop.h"
+#include "base/logging.h"
+#include "base/socket/socket_errors.h"
+#include "base/test/socket_test_util.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class ClientSocketPoolTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    listen_fd_ = BindLoopback(16, &endpoint_);
+  }
+
+  void TearDown() override { close(listen_fd_); }
+
+  // Requests a socket to |endpoint| from |pool| and waits for it.
+  std::unique_ptr<TCPClientSocket> RequestSocket(ClientSocketPool* pool,
+                                                 const IPEndPoint& endpoint) {
+    std::unique_ptr<TCPClientSocket> socket;
+    int result = ERR_IO_PENDING;
+    int rv = pool->RequestSocket(endpoint, &socket,
+                                 [&result](int rv) { result = rv; });
+    if (rv == ERR_IO_PENDING)
+      RunEventLoopUntil([&result]() { return result != ERR_IO_PENDING; });
+    else
+      result = rv;
+    EXPECT_EQ(OK, result);
+    return socket;
+  }
+
+  std::unique_ptr<TCPClientSocket> RequestSocket(ClientSocketPool* pool) {
+    return RequestSocket(pool, endpoint_);
+  }
+
+  EventLoop event_loop_;
+  int listen_fd_ = -1;
+  IPEndPoint endpoint_;
+};
+
+}  // namespace
+
+TEST_F(ClientSocketPoolTest, ReusesIdleSocket) {
+  ClientSocketPool pool;
+  std::unique_ptr<TCPClientSocket> socket = RequestSocket(&pool);
+  ASSERT_TRUE(socket);
+  TCPClientSocket* first_socket = socket.get();
+  pool.ReleaseSocket(endpoint_, std::move(socket));
+  EXPECT_EQ(1u, pool.IdleSocketCountForEndpoint(endpoint_));
+
+  ASSERT_EQ(OK, pool.RequestSocket(endpoint_, &socket, [](int rv) {}));
+  EXPECT_EQ(first_socket, socket.get());
+  EXPECT_EQ(0u, pool.IdleSocketCount());
+
+  // The peer closes the connection, so the socket isn't kept.
+  int peer_fd = accept(listen_fd_, nullptr, nullptr);
+  ASSERT_LE(0, peer_fd);
+  close(peer_fd);
+  RunEventLoopUntil([&socket]() { return !socket->IsConnectedAndIdle(); });
+  pool.ReleaseSocket(endpoint_, std::move(socket));
+  EXPECT_EQ(0u, pool.IdleSocketCount());
+  EXPECT_EQ(0u, pool.socket_count());
+  // Nothing is left of the end point.
+  EXPECT_EQ(0u, pool.group_count());
+}
+
+TEST_F(ClientSocketPoolTest, WaitsForRoom) {
+  ClientSocketPool::Options options;
+  options.max_sockets_per_endpoint = 1;
+  ClientSocketPool pool(options);
+  std::unique_ptr<TCPClientSocket> first_socket = RequestSocket(&pool);
+  ASSERT_TRUE(first_socket);
+
+  std::unique_ptr<TCPClientSocket> second_socket;
+  int result = ERR_IO_PENDING;
+  ASSERT_EQ(ERR_IO_PENDING,
+            pool.RequestSocket(endpoint_, &second_socket,
+                               [&result](int rv) { result = rv; }));
+  EXPECT_EQ(1u, pool.socket_count());
+
+  // The released socket goes to the waiting request right away.
+  TCPClientSocket* released_socket = first_socket.get();
+  pool.ReleaseSocket(endpoint_, std::move(first_socket));
+  EXPECT_EQ(OK, result);
+  EXPECT_EQ(released_socket, second_socket.get());
+
+  pool.ReleaseSocket(endpoint_, std::move(second_socket));
+}
+
+TEST_F(ClientSocketPoolTest, CancelRequest) {
+  ClientSocketPool::Options options;
+  options.max_sockets_per_endpoint = 1;
+  ClientSocketPool pool(options);
+  std::unique_ptr<TCPClientSocket> first_socket = RequestSocket(&pool);
+  ASSERT_TRUE(first_socket);
+
+  std::unique_ptr<TCPClientSocket> second_socket;
+  ASSERT_EQ(ERR_IO_PENDING,
+            pool.RequestSocket(endpoint_, &second_socket,
+                               [](int rv) { NOTREACHED(); }));
+  pool.CancelRequest(endpoint_, &second_socket);
+
+  // The released socket is kept instead of going to the canceled request.
+  pool.ReleaseSocket(endpoint_, std::move(first_socket));
+  EXPECT_FALSE(second_socket);
+  EXPECT_EQ(1u, pool.IdleSocketCountForEndpoint(endpoint_));
+}
+
+TEST_F(ClientSocketPoolTest, MaxSocketsAcrossEndpoints) {
+  IPEndPoint other_endpoint;
+  int other_listen_fd = BindLoopback(16, &other_endpoint);
+
+  ClientSocketPool::Options options;
+  options.max_sockets_per_endpoint = 1;
+  options.max_sockets = 1;
+  ClientSocketPool pool(options);
+  std::unique_ptr<TCPClientSocket> first_socket = RequestSocket(&pool);
+  ASSERT_TRUE(first_socket);
+
+  // The other end point waits for room, until it gives up.
+  std::unique_ptr<TCPClientSocket> other_socket;
+  ASSERT_EQ(ERR_IO_PENDING,
+            pool.RequestSocket(other_endpoint, &other_socket,
+                               [](int rv) { NOTREACHED(); }));
+  EXPECT_EQ(1u, pool.socket_count());
+  EXPECT_EQ(2u, pool.group_count());
+  pool.CancelRequest(other_endpoint, &other_socket);
+  EXPECT_EQ(1u, pool.group_count());
+
+  int result = ERR_IO_PENDING;
+  ASSERT_EQ(ERR_IO_PENDING,
+            pool.RequestSocket(other_endpoint, &other_socket,
+                               [&result](int rv) { result = rv; }));
+
+  // The released socket is closed to make room for the other end point.
+  pool.ReleaseSocket(endpoint_, std::move(first_socket));
+  EXPECT_EQ(0u, pool.IdleSocketCount());
+  EXPECT_EQ(1u, pool.group_count());
+  RunEventLoopUntil([&result]() { return result != ERR_IO_PENDING; });
+  EXPECT_EQ(OK, result);
+  ASSERT_TRUE(other_socket);
+  EXPECT_EQ(1u, pool.socket_count());
+
+  pool.ReleaseSocket(other_endpoint, std::move(other_socket));
+  close(other_listen_fd);
+}
+
+TEST_F(ClientSocketPoolTest, PreconnectAndIdleTimeout) {
+  ClientSocketPool::Options options;
+  options.idle_timeout = absl::Milliseconds(20);
+  options.cleanup_interval = absl::Milliseconds(5);
+  ClientSocketPool pool(options);
+
+  pool.Preconnect(endpoint_, 2);
+  EXPECT_EQ(2u, pool.socket_count());
+  RunEventLoopUntil([&pool]() { return pool.IdleSocketCount() == 2; });
+
+  RunEventLoopUntil([&pool]() { return pool.IdleSocketCount() == 0; });
+  EXPECT_EQ(0u, pool.socket_count());
+}
+
+}  // namespace base
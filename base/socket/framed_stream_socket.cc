@@ -0,0 +1,244 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/framed_stream_socket.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/functional/bind_front.h"
+#include "base/data_view.h"
+#include "base/logging.h"
+#include "base/socket/socket_errors.h"
+
+namespace base {
+
+namespace {
+
+// Queued frames are sent right away once they add up to this many bytes.
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+}  // namespace
+
+constexpr size_t FramedStreamSocket::kHeaderSize;
+
+FramedStreamSocket::FramedStreamSocket(
+    std::unique_ptr<TCPClientSocket> transport, size_t max_frame_size)
+    : max_frame_size_(max_frame_size),
+      buffered_socket_(std::move(transport),
+                       std::max(BufferedStreamSocket::kDefaultBufferSize,
+                                kHeaderSize + max_frame_size)),
+      transport_(static_cast<TCPClientSocket*>(buffered_socket_.transport())),
+      write_error_(OK) {
+  DCHECK_LE(max_frame_size_, static_cast<size_t>(INT32_MAX));
+}
+
+FramedStreamSocket::~FramedStreamSocket() = default;
+
+int FramedStreamSocket::ReadFrames(std::vector<absl::Span<const char>>* frames,
+                                   CompletionOnceCallback callback) {
+  DCHECK(frames);
+  DCHECK(read_callback_.is_null());
+
+  frames->clear();
+  read_frames_ = frames;
+  int rv = TakeBufferedFrames();
+  if (rv != OK || !frames->empty()) return rv;
+
+  next_read_state_ = READ_STATE_HEADER;
+  rv = DoReadLoop(OK);
+  if (rv == ERR_IO_PENDING) read_callback_ = std::move(callback);
+  return rv;
+}
+
+int FramedStreamSocket::WriteFrame(std::shared_ptr<IOBuffer> payload,
+                                   int size) {
+  DCHECK_GE(size, 0);
+
+  if (write_error_ != OK) return write_error_;
+  if (static_cast<size_t>(size) > max_frame_size_) return ERR_MSG_TOO_BIG;
+
+  queued_frames_.push_back(IOBufferSlice{std::move(payload), size});
+  queued_bytes_ += kHeaderSize + size;
+  if (writing_frame_count_ > 0) return OK;  // Sent after the pending write.
+
+  if (queued_bytes_ >= kFlushThreshold) {
+    flush_timer_.Stop();
+    int rv = DoFlush();
+    return rv == ERR_IO_PENDING ? OK : rv;
+  }
+  if (!flush_timer_.IsRunning()) {
+    flush_timer_.Start(absl::ZeroDuration(), this,
+                       &FramedStreamSocket::OnFlushTimerFired);
+  }
+  return OK;
+}
+
+int FramedStreamSocket::Flush(CompletionOnceCallback callback) {
+  DCHECK(flush_callback_.is_null());
+
+  if (write_error_ != OK) return write_error_;
+
+  flush_timer_.Stop();
+  int rv = writing_frame_count_ > 0 ? ERR_IO_PENDING : DoFlush();
+  if (rv == ERR_IO_PENDING) flush_callback_ = std::move(callback);
+  return rv;
+}
+
+int FramedStreamSocket::DoReadLoop(int result) {
+  DCHECK_NE(next_read_state_, READ_STATE_NONE);
+
+  int rv = result;
+  do {
+    ReadState state = next_read_state_;
+    next_read_state_ = READ_STATE_NONE;
+    switch (state) {
+      case READ_STATE_HEADER:
+        DCHECK_EQ(OK, rv);
+        rv = DoReadHeader();
+        break;
+      case READ_STATE_HEADER_COMPLETE:
+        rv = DoReadHeaderComplete(rv);
+        break;
+      case READ_STATE_PAYLOAD:
+        DCHECK_EQ(OK, rv);
+        rv = DoReadPayload();
+        break;
+      case READ_STATE_PAYLOAD_COMPLETE:
+        rv = DoReadPayloadComplete(rv);
+        break;
+      default:
+        NOTREACHED() << "bad state " << state;
+        rv = ERR_UNEXPECTED;
+        break;
+    }
+  } while (rv != ERR_IO_PENDING && next_read_state_ != READ_STATE_NONE);
+
+  return rv;
+}
+
+int FramedStreamSocket::DoReadHeader() {
+  next_read_state_ = READ_STATE_HEADER_COMPLETE;
+  return buffered_socket_.ReadExactly(
+      kHeaderSize, &read_view_,
+      absl::bind_front(&FramedStreamSocket::OnReadComplete, this));
+}
+
+int FramedStreamSocket::DoReadHeaderComplete(int result) {
+  if (result != OK) return result;
+
+  ReadBigEndian(read_view_.data(), &read_payload_size_);
+  if (read_payload_size_ > max_frame_size_) return ERR_MSG_TOO_BIG;
+  next_read_state_ = READ_STATE_PAYLOAD;
+  return OK;
+}
+
+int FramedStreamSocket::DoReadPayload() {
+  next_read_state_ = READ_STATE_PAYLOAD_COMPLETE;
+  return buffered_socket_.ReadExactly(
+      read_payload_size_, &read_view_,
+      absl::bind_front(&FramedStreamSocket::OnReadComplete, this));
+}
+
+int FramedStreamSocket::DoReadPayloadComplete(int result) {
+  if (result != OK) return result;
+
+  read_frames_->push_back(
+      absl::MakeConstSpan(read_view_.data(), read_view_.size()));
+  // The frames behind it may have come with the same read. An error is left
+  // for the next ReadFrames().
+  TakeBufferedFrames();
+  return OK;
+}
+
+void FramedStreamSocket::OnReadComplete(int result) {
+  DCHECK(!read_callback_.is_null());
+
+  result = DoReadLoop(result);
+  if (result != ERR_IO_PENDING) std::move(read_callback_).Run(result);
+}
+
+int FramedStreamSocket::TakeBufferedFrames() {
+  absl::string_view buffered = buffered_socket_.Peek();
+  size_t consumed = 0;
+  while (buffered.size() - consumed >= kHeaderSize) {
+    uint32_t size;
+    ReadBigEndian(buffered.data() + consumed, &size);
+    if (size > max_frame_size_) {
+      if (read_frames_->empty()) return ERR_MSG_TOO_BIG;
+      break;
+    }
+    if (buffered.size() - consumed - kHeaderSize < size) break;
+
+    read_frames_->push_back(
+        absl::MakeConstSpan(buffered.data() + consumed + kHeaderSize, size));
+    consumed += kHeaderSize + size;
+  }
+  buffered_socket_.Consume(consumed);
+  return OK;
+}
+
+int FramedStreamSocket::DoFlush() {
+  DCHECK_EQ(0u, writing_frame_count_);
+
+  if (queued_frames_.empty()) return OK;
+
+  // One buffer holds all the headers, so that a frame costs no allocation.
+  auto headers =
+      std::make_shared<IOBuffer>(kHeaderSize * queued_frames_.size());
+  std::vector<IOBufferSlice> slices;
+  slices.reserve(2 * queued_frames_.size());
+  for (size_t i = 0; i < queued_frames_.size(); ++i) {
+    int offset = static_cast<int>(kHeaderSize * i);
+    WriteBigEndian(headers->data() + offset,
+                   static_cast<uint32_t>(queued_frames_[i].len));
+    slices.push_back(
+        IOBufferSlice{headers, static_cast<int>(kHeaderSize), offset});
+    slices.push_back(std::move(queued_frames_[i]));
+  }
+  writing_frame_count_ = queued_frames_.size();
+  queued_frames_.clear();
+  queued_bytes_ = 0;
+
+  // |transport_| is owned by |this| and the callback won't be run once
+  // |transport_| is gone.
+  int rv = transport_->Writev(
+      slices, absl::bind_front(&FramedStreamSocket::OnWriteComplete, this));
+  if (rv == ERR_IO_PENDING) return rv;
+
+  writing_frame_count_ = 0;
+  if (rv < 0) {
+    queued_frames_.clear();
+    write_error_ = rv;
+    return rv;
+  }
+  // Frames can't have been queued meanwhile.
+  return OK;
+}
+
+void FramedStreamSocket::OnWriteComplete(int result) {
+  DCHECK_GT(writing_frame_count_, 0u);
+
+  writing_frame_count_ = 0;
+  if (result < 0) {
+    queued_frames_.clear();
+    queued_bytes_ = 0;
+    write_error_ = result;
+  } else {
+    result = DoFlush();
+    if (result == ERR_IO_PENDING) return;
+  }
+
+  if (!flush_callback_.is_null()) std::move(flush_callback_).Run(result);
+}
+
+void FramedStreamSocket::OnFlushTimerFired() {
+  if (writing_frame_count_ > 0) return;  // Sent after the pending write.
+
+  int rv = DoFlush();
+  if (rv < 0 && rv != ERR_IO_PENDING)
+    DVLOG(1) << "Failed to flush: " << rv;
+}
+
+}  // namespace base
@@ -0,0 +1,123 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SOCKET_FRAMED_STREAM_SOCKET_H_
+#define BASE_SOCKET_FRAMED_STREAM_SOCKET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/completion_once_callback.h"
+#include "base/export.h"
+#include "base/io_buffer.h"
+#include "base/socket/buffered_stream_socket.h"
+#include "base/socket/tcp_client_socket.h"
+#include "base/timer/timer.h"
+
+namespace base {
+
+// Sends and receives frames of a 32-bit big endian length followed by that
+// many bytes of payload over a connected TCPClientSocket.
+//
+// ReadFrames() hands out the payloads as views into the receive buffer, so
+// that no frame is copied or allocated, and all the frames which one read
+// from the socket completes are handed out at once.
+//
+// WriteFrame() queues a frame, and the frames queued in one iteration of the
+// EventLoop are sent with one writev(), headers and payloads alike, without
+// copying the payloads. Flush() sends the queued frames right away.
+//
+// At most one ReadFrames() and one Flush() may be in progress at a time.
+class BASE_EXPORT FramedStreamSocket {
+ public:
+  static constexpr size_t kHeaderSize = sizeof(uint32_t);
+
+  // Frames with more than |max_frame_size| bytes of payload are refused.
+  FramedStreamSocket(std::unique_ptr<TCPClientSocket> transport,
+                     size_t max_frame_size);
+  FramedStreamSocket(const FramedStreamSocket& other) = delete;
+  FramedStreamSocket& operator=(const FramedStreamSocket& other) = delete;
+  ~FramedStreamSocket();
+
+  TCPClientSocket* transport() const { return transport_; }
+
+  // Sets |*frames| to the payloads of the frames which have been received
+  // completely, at least one. Returns OK if |*frames| is set right away,
+  // otherwise ERR_IO_PENDING and runs |callback| once it is. Returns
+  // ERR_MSG_TOO_BIG for a frame over the maximum size, and
+  // ERR_CONNECTION_CLOSED if the peer closes the connection in the middle of
+  // a frame, or before it. The payloads stay valid until the next
+  // ReadFrames().
+  int ReadFrames(std::vector<absl::Span<const char>>* frames,
+                 CompletionOnceCallback callback);
+
+  // Queues a frame with the first |size| bytes of |payload|, which must not
+  // change until the frame is sent. Returns OK, ERR_MSG_TOO_BIG if |size| is
+  // over the maximum frame size, or the error of an earlier write which
+  // failed, after which nothing more is sent.
+  int WriteFrame(std::shared_ptr<IOBuffer> payload, int size);
+
+  // Sends the queued frames. Returns OK if they are all sent right away,
+  // otherwise ERR_IO_PENDING and runs |callback| once they are, or returns the
+  // error.
+  int Flush(CompletionOnceCallback callback);
+
+  // The number of frames queued or being sent.
+  size_t pending_write_frames() const {
+    return queued_frames_.size() + writing_frame_count_;
+  }
+
+ private:
+  enum ReadState {
+    READ_STATE_HEADER,
+    READ_STATE_HEADER_COMPLETE,
+    READ_STATE_PAYLOAD,
+    READ_STATE_PAYLOAD_COMPLETE,
+    READ_STATE_NONE,
+  };
+
+  int DoReadLoop(int result);
+  int DoReadHeader();
+  int DoReadHeaderComplete(int result);
+  int DoReadPayload();
+  int DoReadPayloadComplete(int result);
+  void OnReadComplete(int result);
+
+  // Adds the frames which are received completely to |read_frames_|.
+  // Returns ERR_MSG_TOO_BIG if the first one is over the maximum size.
+  int TakeBufferedFrames();
+
+  // Sends the queued frames, unless a write is in progress.
+  int DoFlush();
+  void OnWriteComplete(int result);
+  void OnFlushTimerFired();
+
+  const size_t max_frame_size_;
+  // Reads the frames, and owns |transport_|.
+  BufferedStreamSocket buffered_socket_;
+  TCPClientSocket* const transport_;
+
+  ReadState next_read_state_ = READ_STATE_NONE;
+  std::vector<absl::Span<const char>>* read_frames_ = nullptr;
+  absl::string_view read_view_;
+  uint32_t read_payload_size_ = 0;
+  CompletionOnceCallback read_callback_;
+
+  std::vector<IOBufferSlice> queued_frames_;
+  size_t queued_bytes_ = 0;
+  // The number of frames of the writev() in progress, if any.
+  size_t writing_frame_count_ = 0;
+  int write_error_;
+  CompletionOnceCallback flush_callback_;
+  OneShotTimer flush_timer_;
+};
+
+}  // namespace base
+
+#endif  // BASE_SOCKET_FRAMED_STREAM_SOCKET_H_
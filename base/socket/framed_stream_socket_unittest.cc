@@ -0,0 +1,122 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/framed_stream_socket.h"
+
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "base/event_loop/event_loop.h"
+#include "base/socket/socket_errors.h"
+#include "base/test/socket_test_util.h"
+#include "base/timer/timer.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Returns |payload| with its header.
+std::string Frame(const std::string& payload) {
+  uint32_t size = htonl(payload.size());
+  return std::string(reinterpret_cast<const char*>(&size), sizeof(size)) +
+         payload;
+}
+
+std::vector<std::string> ToStrings(
+    const std::vector<absl::Span<const char>>& frames) {
+  std::vector<std::string> strings;
+  for (absl::Span<const char> frame : frames)
+    strings.emplace_back(frame.data(), frame.size());
+  return strings;
+}
+
+class FramedStreamSocketTest : public LoopbackPeerTest {
+ protected:
+  // Creates |socket_| with |max_frame_size|, connected to |peer_fd_|.
+  void Connect(size_t max_frame_size) {
+    socket_ = std::make_unique<FramedStreamSocket>(ConnectToPeer(),
+                                                   max_frame_size);
+  }
+
+  // Reads frames into |frames_|, and waits for them if need be.
+  int ReadFrames() {
+    int result = ERR_IO_PENDING;
+    int rv = socket_->ReadFrames(&frames_, [&](int rv) {
+      result = rv;
+      event_loop_.Quit();
+    });
+    if (rv != ERR_IO_PENDING) return rv;
+    event_loop_.Run(&delegate_);
+    return result;
+  }
+
+  std::shared_ptr<IOBuffer> MakeBuffer(const std::string& data) {
+    auto buf = std::make_shared<IOBuffer>(data.size());
+    memcpy(buf->data(), data.data(), data.size());
+    return buf;
+  }
+
+  std::unique_ptr<FramedStreamSocket> socket_;
+  std::vector<absl::Span<const char>> frames_;
+};
+
+}  // namespace
+
+TEST_F(FramedStreamSocketTest, ReadFrames) {
+  Connect(64);
+  SendFromPeer(Frame("one") + Frame("") + Frame("three") +
+               std::string("\0\0", 2));
+
+  // The frames which arrived together are handed out together.
+  ASSERT_EQ(OK, ReadFrames());
+  EXPECT_EQ((std::vector<std::string>{"one", "", "three"}),
+            ToStrings(frames_));
+
+  // The rest of the frame arrives while it is being read.
+  SendFromPeer(std::string("\0\x04", 2) + "fo");
+  OneShotTimer timer;
+  timer.Start(absl::Milliseconds(10), [this]() { SendFromPeer("ur"); });
+  ASSERT_EQ(OK, ReadFrames());
+  EXPECT_EQ(std::vector<std::string>{"four"}, ToStrings(frames_));
+
+  shutdown(peer_fd_, SHUT_WR);
+  EXPECT_EQ(ERR_CONNECTION_CLOSED, ReadFrames());
+}
+
+TEST_F(FramedStreamSocketTest, ReadFrameTooBig) {
+  Connect(4);
+  SendFromPeer(Frame("ok") + Frame("too big"));
+
+  ASSERT_EQ(OK, ReadFrames());
+  EXPECT_EQ(std::vector<std::string>{"ok"}, ToStrings(frames_));
+  EXPECT_EQ(ERR_MSG_TOO_BIG, ReadFrames());
+}
+
+TEST_F(FramedStreamSocketTest, WriteFrames) {
+  Connect(64);
+
+  EXPECT_EQ(OK, socket_->WriteFrame(MakeBuffer("one"), 3));
+  EXPECT_EQ(OK, socket_->WriteFrame(MakeBuffer("two, cut"), 3));
+  EXPECT_EQ(OK, socket_->WriteFrame(nullptr, 0));
+  EXPECT_EQ(ERR_MSG_TOO_BIG, socket_->WriteFrame(MakeBuffer("x"), 65));
+  EXPECT_EQ(3u, socket_->pending_write_frames());
+  EXPECT_EQ("", ReceiveOnPeer());
+
+  // Sent together on the next iteration of the EventLoop.
+  RunUntil([this]() { return socket_->pending_write_frames() == 0; });
+  EXPECT_EQ(Frame("one") + Frame("two") + Frame(""), ReceiveOnPeer());
+
+  EXPECT_EQ(OK, socket_->WriteFrame(MakeBuffer("four"), 4));
+  EXPECT_EQ(OK, socket_->Flush([](int rv) { NOTREACHED(); }));
+  EXPECT_EQ(Frame("four"), ReceiveOnPeer());
+}
+
+}  // namespace base
@@ -0,0 +1,153 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/kernel_tls_socket.h"
+
+#include <utility>
+
+#include "absl/functional/bind_front.h"
+#include "base/io_buffer.h"
+#include "base/logging.h"
+#include "base/socket/socket_errors.h"
+
+namespace base {
+
+KernelTLSSocket::KernelTLSSocket(std::unique_ptr<TCPClientSocket> transport)
+    : transport_(std::move(transport)) {
+  DCHECK(transport_);
+}
+
+KernelTLSSocket::~KernelTLSSocket() = default;
+
+int KernelTLSSocket::InstallKeys(const KernelTLSKeys& tx,
+                                 const KernelTLSKeys& rx) {
+  DCHECK(!keys_installed_);
+  DCHECK(read_callback_.is_null());
+
+  int rv = transport_->EnableKernelTLS(tx, rx);
+  if (rv == OK) keys_installed_ = true;
+  return rv;
+}
+
+void KernelTLSSocket::SetBeforeConnectCallback(
+    const BeforeConnectCallback& before_connect_callback) {
+  transport_->SetBeforeConnectCallback(before_connect_callback);
+}
+
+int KernelTLSSocket::Connect(CompletionOnceCallback callback) {
+  return transport_->Connect(std::move(callback));
+}
+
+void KernelTLSSocket::Disconnect() {
+  // The record layer stays attached to the closed socket, and a new one is
+  // opened on the next Connect().
+  keys_installed_ = false;
+  read_callback_.Reset();
+  transport_->Disconnect();
+}
+
+bool KernelTLSSocket::IsConnected() const { return transport_->IsConnected(); }
+
+bool KernelTLSSocket::IsConnectedAndIdle() const {
+  return transport_->IsConnectedAndIdle();
+}
+
+int KernelTLSSocket::GetPeerAddress(IPEndPoint* address) const {
+  return transport_->GetPeerAddress(address);
+}
+
+int KernelTLSSocket::GetLocalAddress(IPEndPoint* address) const {
+  return transport_->GetLocalAddress(address);
+}
+
+bool KernelTLSSocket::WasEverUsed() const { return transport_->WasEverUsed(); }
+
+int64_t KernelTLSSocket::GetTotalReceivedBytes() const {
+  return transport_->GetTotalReceivedBytes();
+}
+
+int64_t KernelTLSSocket::SendFile(const File& file, int64_t offset,
+                                  int64_t length,
+                                  Int64CompletionOnceCallback callback) {
+  return transport_->SendFile(file, offset, length, std::move(callback));
+}
+
+int KernelTLSSocket::Read(std::shared_ptr<IOBuffer> buf, int buf_len,
+                          CompletionOnceCallback callback) {
+  DCHECK(read_callback_.is_null());
+
+  // |transport_| is owned by |this| and the callback won't be run once
+  // |transport_| is gone.
+  int result = transport_->Read(
+      std::move(buf), buf_len,
+      absl::bind_front(&KernelTLSSocket::DidCompleteRead, this));
+  return HandleReadResult(result, std::move(callback));
+}
+
+int KernelTLSSocket::ReadIfReady(std::shared_ptr<IOBuffer> buf, int buf_len,
+                                 CompletionOnceCallback callback) {
+  DCHECK(read_callback_.is_null());
+
+  int result = transport_->ReadIfReady(
+      std::move(buf), buf_len,
+      absl::bind_front(&KernelTLSSocket::DidCompleteRead, this));
+  return HandleReadResult(result, std::move(callback));
+}
+
+int KernelTLSSocket::CancelReadIfReady() {
+  read_callback_.Reset();
+  return transport_->CancelReadIfReady();
+}
+
+int KernelTLSSocket::Write(std::shared_ptr<IOBuffer> buf, int buf_len,
+                           CompletionOnceCallback callback) {
+  return transport_->Write(std::move(buf), buf_len, std::move(callback));
+}
+
+int KernelTLSSocket::SetReceiveBufferSize(int32_t size) {
+  return transport_->SetReceiveBufferSize(size);
+}
+
+int KernelTLSSocket::SetSendBufferSize(int32_t size) {
+  return transport_->SetSendBufferSize(size);
+}
+
+int KernelTLSSocket::Readv(absl::Span<const IOBufferSlice> slices,
+                           CompletionOnceCallback callback) {
+  DCHECK(read_callback_.is_null());
+
+  int result = transport_->Readv(
+      slices, absl::bind_front(&KernelTLSSocket::DidCompleteRead, this));
+  return HandleReadResult(result, std::move(callback));
+}
+
+int KernelTLSSocket::Writev(absl::Span<const IOBufferSlice> slices,
+                            CompletionOnceCallback callback) {
+  return transport_->Writev(slices, std::move(callback));
+}
+
+int KernelTLSSocket::HandleReadResult(int result,
+                                      CompletionOnceCallback callback) {
+  if (result == ERR_IO_PENDING) {
+    read_callback_ = std::move(callback);
+    return result;
+  }
+  return MapReadError(result);
+}
+
+int KernelTLSSocket::MapReadError(int result) const {
+  // The kernel fails reads with EIO for records which aren't application
+  // data, and with EBADMSG for records which fail to decrypt, both of which
+  // map to ERR_FAILED.
+  if (keys_installed_ && result == ERR_FAILED) return ERR_SSL_PROTOCOL_ERROR;
+  return result;
+}
+
+void KernelTLSSocket::DidCompleteRead(int result) {
+  DCHECK(!read_callback_.is_null());
+
+  std::move(read_callback_).Run(MapReadError(result));
+}
+
+}  // namespace base
@@ -0,0 +1,100 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SOCKET_KERNEL_TLS_SOCKET_H_
+#define BASE_SOCKET_KERNEL_TLS_SOCKET_H_
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "absl/types/span.h"
+#include "base/completion_once_callback.h"
+#include "base/export.h"
+#include "base/socket/socket_options.h"
+#include "base/socket/stream_socket.h"
+#include "base/socket/tcp_client_socket.h"
+
+namespace base {
+
+class IPEndPoint;
+struct IOBufferSlice;
+
+// A StreamSocket which leaves the TLS record layer to the kernel. Until
+// InstallKeys() is called, it passes the data through as is, so that a TLS
+// library can run the handshake over it. Once the library hands over the
+// session keys, Read(), Write(), Readv(), Writev() and SendFile() send and
+// receive plain text, which the kernel encrypts and decrypts. In particular,
+// SendFile() then serves files encrypted without copying them through user
+// space.
+//
+// Only records with application data can be read after InstallKeys(). Others,
+// like alerts or TLS 1.3 post-handshake messages, fail the read with
+// ERR_SSL_PROTOCOL_ERROR, as do records which fail to decrypt.
+class BASE_EXPORT KernelTLSSocket : public StreamSocket {
+ public:
+  explicit KernelTLSSocket(std::unique_ptr<TCPClientSocket> transport);
+  KernelTLSSocket(const KernelTLSSocket& other) = delete;
+  KernelTLSSocket& operator=(const KernelTLSSocket& other) = delete;
+  ~KernelTLSSocket() override;
+
+  // Hands the record layer over to the kernel, which encrypts with |tx| and
+  // decrypts with |rx| from then on. Must be called on a connected socket
+  // with no read or write in progress, and right after the last handshake
+  // record, since the record sequence numbers continue from |tx| and |rx|.
+  // Returns ERR_NOT_IMPLEMENTED if the kernel doesn't support TLS, in which
+  // case the caller has to fall back to a user space record layer. Any other
+  // error may leave the record layer half installed, so the connection is
+  // unusable and must be dropped.
+  int InstallKeys(const KernelTLSKeys& tx, const KernelTLSKeys& rx);
+
+  bool keys_installed() const { return keys_installed_; }
+
+  // StreamSocket implementation.
+  void SetBeforeConnectCallback(
+      const BeforeConnectCallback& before_connect_callback) override;
+  int Connect(CompletionOnceCallback callback) override;
+  void Disconnect() override;
+  bool IsConnected() const override;
+  bool IsConnectedAndIdle() const override;
+  int GetPeerAddress(IPEndPoint* address) const override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+  bool WasEverUsed() const override;
+  int64_t GetTotalReceivedBytes() const override;
+  int64_t SendFile(const File& file, int64_t offset, int64_t length,
+                   Int64CompletionOnceCallback callback) override;
+
+  // Socket implementation.
+  int Read(std::shared_ptr<IOBuffer> buf, int buf_len,
+           CompletionOnceCallback callback) override;
+  int ReadIfReady(std::shared_ptr<IOBuffer> buf, int buf_len,
+                  CompletionOnceCallback callback) override;
+  int CancelReadIfReady() override;
+  int Write(std::shared_ptr<IOBuffer> buf, int buf_len,
+            CompletionOnceCallback callback) override;
+  int SetReceiveBufferSize(int32_t size) override;
+  int SetSendBufferSize(int32_t size) override;
+
+  // See TCPClientSocket::Readv() and TCPClientSocket::Writev().
+  int Readv(absl::Span<const IOBufferSlice> slices,
+            CompletionOnceCallback callback);
+  int Writev(absl::Span<const IOBufferSlice> slices,
+             CompletionOnceCallback callback);
+
+ private:
+  // Keeps |callback| if |result| is ERR_IO_PENDING, and maps the errors of
+  // the kernel's record layer otherwise.
+  int HandleReadResult(int result, CompletionOnceCallback callback);
+  int MapReadError(int result) const;
+  void DidCompleteRead(int result);
+
+  std::unique_ptr<TCPClientSocket> transport_;
+  bool keys_installed_ = false;
+
+  CompletionOnceCallback read_callback_;
+};
+
+}  // namespace base
+
+#endif  // BASE_SOCKET_KERNEL_TLS_SOCKET_H_
@@ -0,0 +1,174 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/kernel_tls_socket.h"
+
+#include <string.h>
+#include <sys/socket.h>
+
+#include <memory>
+#include <string>
+
+#include "base/event_loop/event_loop.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/io_buffer.h"
+#include "base/logging.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/socket_errors.h"
+#include "base/socket/tcp_socket.h"
+#include "base/test/socket_test_util.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+std::unique_ptr<KernelTLSSocket> AdoptKernelTLSSocket(int fd) {
+  auto socket = std::make_unique<TCPSocket>();
+  CHECK_EQ(OK, socket->AdoptConnectedSocket(fd, IPEndPoint()));
+  return std::make_unique<KernelTLSSocket>(
+      std::make_unique<TCPClientSocket>(std::move(socket), IPEndPoint()));
+}
+
+KernelTLSKeys MakeKeys(uint8_t seed) {
+  KernelTLSKeys keys;
+  memset(keys.key, seed, sizeof(keys.key));
+  memset(keys.salt, seed + 1, sizeof(keys.salt));
+  memset(keys.iv, seed + 2, sizeof(keys.iv));
+  return keys;
+}
+
+// Reads |size| bytes from |reader|.
+std::string ReadAll(KernelTLSSocket* reader, size_t size) {
+  EventLoop* event_loop = EventLoop::Current();
+  IdleDelegate delegate;
+
+  std::string read;
+  auto read_buf = std::make_shared<IOBuffer>(size);
+  while (read.size() < size) {
+    int result = ERR_IO_PENDING;
+    int rv = reader->Read(read_buf, size - read.size(), [&](int rv) {
+      result = rv;
+      event_loop->Quit();
+    });
+    if (rv == ERR_IO_PENDING)
+      event_loop->Run(&delegate);
+    else
+      result = rv;
+    EXPECT_LT(0, result);
+    if (result <= 0) break;
+    read.append(read_buf->data(), result);
+  }
+  return read;
+}
+
+// Writes |data| to |writer| and reads it back from |reader|.
+std::string WriteAndRead(KernelTLSSocket* writer, KernelTLSSocket* reader,
+                         const std::string& data) {
+  auto write_buf = std::make_shared<IOBuffer>(data.size());
+  memcpy(write_buf->data(), data.data(), data.size());
+  int rv = writer->Write(write_buf, data.size(), [](int rv) { NOTREACHED(); });
+  EXPECT_EQ(static_cast<int>(data.size()), rv);
+  return ReadAll(reader, data.size());
+}
+
+class KernelTLSSocketTest : public LoopbackPeerTest {
+ protected:
+  void SetUp() override {
+    client_ = std::make_unique<KernelTLSSocket>(ConnectToPeer());
+  }
+
+  // Makes |server_| the other end of |client_|, instead of |peer_fd_|.
+  void AdoptServer() {
+    server_ = AdoptKernelTLSSocket(peer_fd_);
+    peer_fd_ = -1;
+  }
+
+  std::unique_ptr<KernelTLSSocket> client_;
+  std::unique_ptr<KernelTLSSocket> server_;
+};
+
+}  // namespace
+
+TEST_F(KernelTLSSocketTest, InstallKeys) {
+  AdoptServer();
+
+  // The handshake passes through as is.
+  EXPECT_EQ("client hello", WriteAndRead(client_.get(), server_.get(),
+                                         "client hello"));
+
+  int rv = client_->InstallKeys(MakeKeys(0x11), MakeKeys(0x44));
+  if (rv == ERR_NOT_IMPLEMENTED) GTEST_SKIP() << "Kernel TLS unsupported";
+  ASSERT_EQ(OK, rv);
+  ASSERT_EQ(OK, server_->InstallKeys(MakeKeys(0x44), MakeKeys(0x11)));
+  EXPECT_TRUE(client_->keys_installed());
+
+  EXPECT_EQ("request", WriteAndRead(client_.get(), server_.get(), "request"));
+  EXPECT_EQ("response",
+            WriteAndRead(server_.get(), client_.get(), "response"));
+}
+
+TEST_F(KernelTLSSocketTest, SendsRecords) {
+  int rv = client_->InstallKeys(MakeKeys(0x11), MakeKeys(0x44));
+  if (rv == ERR_NOT_IMPLEMENTED) GTEST_SKIP() << "Kernel TLS unsupported";
+  ASSERT_EQ(OK, rv);
+
+  const std::string kPlainText = "request";
+  auto buf = std::make_shared<IOBuffer>(kPlainText.size());
+  memcpy(buf->data(), kPlainText.data(), kPlainText.size());
+  ASSERT_EQ(static_cast<int>(kPlainText.size()),
+            client_->Write(buf, kPlainText.size(),
+                           [](int rv) { NOTREACHED(); }));
+
+  // One TLS 1.3 record: the header, the plain text, its content type and the
+  // 16 byte tag, all but the header encrypted.
+  const size_t kRecordSize = 5 + kPlainText.size() + 1 + 16;
+  std::string record;
+  while (record.size() < kRecordSize) {
+    char chunk[64];
+    ssize_t received = recv(peer_fd_, chunk, sizeof(chunk), 0);
+    ASSERT_LT(0, received);
+    record.append(chunk, received);
+  }
+  ASSERT_EQ(kRecordSize, record.size());
+  // Application data, TLS 1.2 on the wire, then the length.
+  EXPECT_EQ(std::string("\x17\x03\x03\x00\x18", 5), record.substr(0, 5));
+  EXPECT_EQ(std::string::npos, record.find(kPlainText));
+}
+
+TEST_F(KernelTLSSocketTest, SendFile) {
+  constexpr int kFileSize = 256 * 1024;
+
+  AdoptServer();
+  int rv = client_->InstallKeys(MakeKeys(0x11), MakeKeys(0x44));
+  if (rv == ERR_NOT_IMPLEMENTED) GTEST_SKIP() << "Kernel TLS unsupported";
+  ASSERT_EQ(OK, rv);
+  ASSERT_EQ(OK, server_->InstallKeys(MakeKeys(0x44), MakeKeys(0x11)));
+
+  FilePath path;
+  ASSERT_TRUE(CreateTemporaryFile(&path));
+  File file(path, File::FLAG_OPEN | File::FLAG_READ | File::FLAG_WRITE);
+  ASSERT_TRUE(file.IsValid());
+  std::string contents;
+  for (int i = 0; i < kFileSize; ++i) contents += static_cast<char>(i % 251);
+  ASSERT_EQ(kFileSize, file.Write(0, contents.data(), kFileSize));
+
+  // The kernel encrypts the file on its way out, and the server decrypts it.
+  int64_t result = ERR_IO_PENDING;
+  int64_t sent = client_->SendFile(file, 0, kFileSize,
+                                   [&](int64_t rv) { result = rv; });
+  EXPECT_EQ(contents, ReadAll(server_.get(), kFileSize));
+  if (sent == ERR_IO_PENDING) {
+    RunUntil([&result]() { return result != ERR_IO_PENDING; });
+    sent = result;
+  }
+  EXPECT_EQ(kFileSize, sent);
+
+  file.Close();
+  DeleteFile(path);
+}
+
+}  // namespace base
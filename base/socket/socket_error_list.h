@@ -99,6 +99,9 @@ SOCKET_ERROR(NAME_NOT_RESOLVED, -105)
 // The Internet connection has been lost.
 SOCKET_ERROR(INTERNET_DISCONNECTED, -106)
 
+// An SSL protocol error occurred.
+SOCKET_ERROR(SSL_PROTOCOL_ERROR, -107)
+
 // The IP address or port number is invalid (e.g., cannot connect to the IP
 // address 0 or the port 0).
 SOCKET_ERROR(ADDRESS_INVALID, -108)
@@ -22,6 +22,19 @@
 #include <sys/socket.h>
 #endif
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <linux/tls.h>
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(SOL_TLS)
+#define SOL_TLS 282
+#endif
+#if !defined(TCP_ULP)
+#define TCP_ULP 31
+#endif
+#endif
+
 namespace base {
 
 int SetTCPNoDelay(SocketDescriptor fd, bool no_delay) {
@@ -60,6 +73,178 @@ int SetReuseAddr(SocketDescriptor fd, bool reuse) {
   return rv == -1 ? MapSystemError(errno) : OK;
 }
 
+int SetReusePort(SocketDescriptor fd, bool reuse) {
+#if defined(SO_REUSEPORT)
+  int boolean_value = reuse ? 1 : 0;
+  int rv = setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+                      reinterpret_cast<const char*>(&boolean_value),
+                      sizeof(boolean_value));
+  return rv == -1 ? MapSystemError(errno) : OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetBusyPoll(SocketDescriptor fd, absl::Duration duration) {
+#if defined(SO_BUSY_POLL)
+  int microseconds = static_cast<int>(absl::ToInt64Microseconds(duration));
+  int rv = setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &microseconds,
+                      sizeof(microseconds));
+  return rv == -1 ? MapSystemError(errno) : OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetZeroCopy(SocketDescriptor fd, bool zero_copy) {
+#if defined(SO_ZEROCOPY)
+  int boolean_value = zero_copy ? 1 : 0;
+  int rv = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &boolean_value,
+                      sizeof(boolean_value));
+  return rv == -1 ? MapSystemError(errno) : OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetTCPFastOpenConnect(SocketDescriptor fd, bool enable) {
+#if defined(TCP_FASTOPEN_CONNECT)
+  int boolean_value = enable ? 1 : 0;
+  int rv = setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &boolean_value,
+                      sizeof(boolean_value));
+  return rv == -1 ? MapSystemError(errno) : OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SetTCPFastOpen(SocketDescriptor fd, int queue_length) {
+#if defined(TCP_FASTOPEN)
+  int rv = setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &queue_length,
+                      sizeof(queue_length));
+  return rv == -1 ? MapSystemError(errno) : OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+namespace {
+
+int SetKernelTLSKeys(SocketDescriptor fd, int direction,
+                     const KernelTLSKeys& keys) {
+  tls12_crypto_info_aes_gcm_128 crypto_info = {};
+  crypto_info.info.version = keys.tls13 ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+  crypto_info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+  static_assert(sizeof(keys.key) == TLS_CIPHER_AES_GCM_128_KEY_SIZE, "");
+  static_assert(sizeof(keys.salt) == TLS_CIPHER_AES_GCM_128_SALT_SIZE, "");
+  static_assert(sizeof(keys.iv) == TLS_CIPHER_AES_GCM_128_IV_SIZE, "");
+  static_assert(
+      sizeof(keys.record_sequence) == TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE, "");
+  memcpy(crypto_info.key, keys.key, sizeof(keys.key));
+  memcpy(crypto_info.salt, keys.salt, sizeof(keys.salt));
+  memcpy(crypto_info.iv, keys.iv, sizeof(keys.iv));
+  memcpy(crypto_info.rec_seq, keys.record_sequence,
+         sizeof(keys.record_sequence));
+  int rv =
+      setsockopt(fd, SOL_TLS, direction, &crypto_info, sizeof(crypto_info));
+  memset(&crypto_info, 0, sizeof(crypto_info));
+  return rv == -1 ? MapSystemError(errno) : OK;
+}
+
+}  // namespace
+#endif
+
+int SetKernelTLS(SocketDescriptor fd, const KernelTLSKeys& tx,
+                 const KernelTLSKeys& rx) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  static const char kULP[] = "tls";
+  if (setsockopt(fd, IPPROTO_TCP, TCP_ULP, kULP, sizeof(kULP)) == -1) {
+    // ENOENT means that the tls module isn't loaded.
+    return errno == ENOENT ? ERR_NOT_IMPLEMENTED : MapSystemError(errno);
+  }
+
+  // Receiving came after sending (Linux 4.17), so it goes first: a kernel
+  // which only encrypts refuses it with ENOPROTOOPT, which maps to
+  // ERR_NOT_IMPLEMENTED, before anything is installed, and the socket keeps
+  // passing the data through.
+  int rv = SetKernelTLSKeys(fd, TLS_RX, rx);
+  if (rv != OK) return rv;
+  return SetKernelTLSKeys(fd, TLS_TX, tx);
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+namespace {
+
+// The tcp_info of <netinet/tcp.h> stops at |tcpi_total_retrans|, and the one
+// of <linux/tcp.h> can't be included along with it. These are the fields the
+// kernel has appended since, up to |tcpi_delivery_rate| (Linux 4.9).
+struct ExtendedTCPInfo {
+  tcp_info info;
+  uint64_t tcpi_pacing_rate;
+  uint64_t tcpi_max_pacing_rate;
+  uint64_t tcpi_bytes_acked;
+  uint64_t tcpi_bytes_received;
+  uint32_t tcpi_segs_out;
+  uint32_t tcpi_segs_in;
+  uint32_t tcpi_notsent_bytes;
+  uint32_t tcpi_min_rtt;
+  uint32_t tcpi_data_segs_in;
+  uint32_t tcpi_data_segs_out;
+  uint64_t tcpi_delivery_rate;
+};
+static_assert(offsetof(ExtendedTCPInfo, tcpi_pacing_rate) == 104,
+              "tcp_info doesn't match the kernel's");
+
+}  // namespace
+
+// Whether getsockopt() filled in |field|, which older kernels don't know.
+#define HAS_TCP_INFO_FIELD(info_len, field)         \
+  ((info_len) >= offsetof(ExtendedTCPInfo, field) + \
+                     sizeof(ExtendedTCPInfo::field))
+#endif
+
+int GetTCPInfo(SocketDescriptor fd, TCPInfo* info) {
+  DCHECK(info);
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  ExtendedTCPInfo extended = {};
+  socklen_t len = sizeof(extended);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &extended, &len) == -1)
+    return MapSystemError(errno);
+
+  const tcp_info& tcpi = extended.info;
+  *info = TCPInfo();
+  info->rtt = absl::Microseconds(tcpi.tcpi_rtt);
+  info->rtt_variance = absl::Microseconds(tcpi.tcpi_rttvar);
+  info->congestion_window = tcpi.tcpi_snd_cwnd;
+  info->slow_start_threshold = tcpi.tcpi_snd_ssthresh;
+  info->mss = tcpi.tcpi_snd_mss;
+  info->retransmits = tcpi.tcpi_retransmits;
+  info->total_retransmits = tcpi.tcpi_total_retrans;
+  // As the kernel's tcp_packets_in_flight() counts them.
+  int64_t packets_in_flight = int64_t{tcpi.tcpi_unacked} - tcpi.tcpi_sacked -
+                              tcpi.tcpi_lost + tcpi.tcpi_retrans;
+  if (packets_in_flight > 0)
+    info->bytes_in_flight = packets_in_flight * tcpi.tcpi_snd_mss;
+
+  if (HAS_TCP_INFO_FIELD(len, tcpi_pacing_rate))
+    info->pacing_rate = extended.tcpi_pacing_rate;
+  if (HAS_TCP_INFO_FIELD(len, tcpi_notsent_bytes))
+    info->unsent_bytes = extended.tcpi_notsent_bytes;
+  if (HAS_TCP_INFO_FIELD(len, tcpi_min_rtt) && extended.tcpi_min_rtt != ~0u)
+    info->min_rtt = absl::Microseconds(extended.tcpi_min_rtt);
+  if (HAS_TCP_INFO_FIELD(len, tcpi_delivery_rate))
+    info->delivery_rate = extended.tcpi_delivery_rate;
+  return OK;
+#undef HAS_TCP_INFO_FIELD
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
 int SetSocketReceiveBufferSize(SocketDescriptor fd, int32_t size) {
   int rv = setsockopt(fd, SOL_SOCKET, SO_RCVBUF,
                       reinterpret_cast<const char*>(&size), sizeof(size));
@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 
+#include "absl/time/time.h"
 #include "base/export.h"
 #include "base/socket/socket_descriptor.h"
 
@@ -53,6 +54,99 @@ int SetTCPNoDelay(SocketDescriptor fd, bool no_delay);
 // disable it. On error returns a net error code, on success returns OK.
 int SetReuseAddr(SocketDescriptor fd, bool reuse);
 
+// SetReusePort() sets the SO_REUSEPORT socket option. Use |reuse| to enable or
+// disable it. On Linux, the sockets which set it and are bound to the same
+// end point share its incoming connections or datagrams, which the kernel
+// distributes between them. Returns ERR_NOT_IMPLEMENTED on platforms without
+// SO_REUSEPORT. On error returns a net error code, on success returns OK.
+int SetReusePort(SocketDescriptor fd, bool reuse);
+
+// SetBusyPoll() sets the SO_BUSY_POLL socket option, which makes blocking
+// reads and polls with nothing to read busy-poll the device queue for up to
+// |duration|, rounded down to microseconds, instead of waiting for an
+// interrupt. Zero disables it. Returns ERR_NOT_IMPLEMENTED on platforms
+// without SO_BUSY_POLL. On error returns a net error code, on success returns
+// OK.
+int SetBusyPoll(SocketDescriptor fd, absl::Duration duration);
+
+// SetZeroCopy() sets the SO_ZEROCOPY socket option, which allows sends with
+// MSG_ZEROCOPY. Use |zero_copy| to enable or disable it. Returns
+// ERR_NOT_IMPLEMENTED on platforms without SO_ZEROCOPY. On error returns a net
+// error code, on success returns OK.
+int SetZeroCopy(SocketDescriptor fd, bool zero_copy);
+
+// SetTCPFastOpenConnect() sets the TCP_FASTOPEN_CONNECT socket option of a
+// client socket. Use |enable| to enable or disable it. connect() then returns
+// right away, and the first write is sent in the SYN if the peer has handed
+// out a Fast Open cookie before, saving a round trip. Otherwise the write
+// waits for a regular handshake. Returns ERR_NOT_IMPLEMENTED on platforms
+// without TCP_FASTOPEN_CONNECT. On error returns a net error code, on success
+// returns OK.
+int SetTCPFastOpenConnect(SocketDescriptor fd, bool enable);
+
+// SetTCPFastOpen() sets the TCP_FASTOPEN socket option of a server socket,
+// which accepts data in the SYN of up to |queue_length| connections which
+// haven't completed the handshake yet. Zero disables it. Returns
+// ERR_NOT_IMPLEMENTED on platforms without TCP_FASTOPEN. On error returns a net
+// error code, on success returns OK.
+int SetTCPFastOpen(SocketDescriptor fd, int queue_length);
+
+// The key material of one direction of a TLS 1.2 or TLS 1.3 session using
+// AES-128-GCM, as handed out by the TLS library once the handshake is done.
+// See struct tls12_crypto_info_aes_gcm_128 in <linux/tls.h>.
+struct KernelTLSKeys {
+  // TLS 1.2 if false.
+  bool tls13 = true;
+  uint8_t key[16] = {};
+  uint8_t salt[4] = {};
+  uint8_t iv[8] = {};
+  // The sequence number of the next record, in big endian.
+  uint8_t record_sequence[8] = {};
+};
+
+// SetKernelTLS() attaches the kernel's TLS record layer to the connected TCP
+// socket |fd|, which from then on encrypts the records it sends with |tx| and
+// decrypts the records it receives with |rx|. There is no way back. Returns
+// ERR_NOT_IMPLEMENTED on platforms, or kernels, without kernel TLS for both
+// directions, in which case |fd| is left passing the data through. Any other
+// error may leave one direction installed. On error returns a net error code,
+// on success returns OK.
+int SetKernelTLS(SocketDescriptor fd, const KernelTLSKeys& tx,
+                 const KernelTLSKeys& rx);
+
+// The state of a TCP connection, as `ss -ti` shows it. The fields which the
+// kernel doesn't report are left zero.
+struct TCPInfo {
+  // The smoothed RTT and its mean deviation.
+  absl::Duration rtt;
+  absl::Duration rtt_variance;
+  // The lowest RTT seen over the last few minutes.
+  absl::Duration min_rtt;
+  // In segments of |mss| bytes.
+  uint32_t congestion_window = 0;
+  uint32_t slow_start_threshold = 0;
+  uint32_t mss = 0;
+  // The number of retransmission timeouts in a row, which is 0 while the
+  // connection makes progress.
+  uint32_t retransmits = 0;
+  // The number of segments retransmitted over the life of the connection.
+  uint32_t total_retransmits = 0;
+  // Sent and not acknowledged, nor known to be lost.
+  uint64_t bytes_in_flight = 0;
+  // Written by the application and not sent yet.
+  uint32_t unsent_bytes = 0;
+  // In bytes per second. The most recent delivery rate sample, and the rate
+  // at which the kernel paces the segments out, or UINT64_MAX if unpaced.
+  uint64_t delivery_rate = 0;
+  uint64_t pacing_rate = 0;
+};
+
+// GetTCPInfo() sets |*info| to the state of the TCP socket |fd|, from
+// getsockopt(TCP_INFO). This is cheap enough to call every few milliseconds.
+// Returns ERR_NOT_IMPLEMENTED on platforms other than Linux and Android. On
+// error returns a net error code, on success returns OK.
+int GetTCPInfo(SocketDescriptor fd, TCPInfo* info);
+
 // SetSocketReceiveBufferSize() sets the SO_RCVBUF socket option. On error
 // returns a net error code, on success returns OK.
 int SetSocketReceiveBufferSize(SocketDescriptor fd, int32_t size);
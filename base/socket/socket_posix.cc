@@ -9,22 +9,42 @@
 #include "base/socket/socket_posix.h"
 
 #include <errno.h>
+#include <limits.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <utility>
 
 #include "absl/functional/bind_front.h"
+#include "base/files/file.h"
 #include "base/files/file_util.h"
 #include "base/logging.h"
 #include "base/posix/eintr_wrapper.h"
 #include "base/socket/socket_errors.h"
+#include "base/socket/socket_options.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/sendfile.h>
+#endif
 
 #if defined(OS_FUCHSIA)
 #include <poll.h>
 #include <sys/ioctl.h>
 #endif  // OS_FUCHSIA
 
+#if defined(OS_LINUX)
+#include <linux/errqueue.h>
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+#endif  // OS_LINUX
+
 namespace base {
 
 namespace {
@@ -60,6 +80,35 @@ int MapConnectError(int os_error) {
   }
 }
 
+// The most slices passed to a single readv() or sendmsg().
+constexpr size_t kMaxIovecs = std::min(IOV_MAX, 64);
+
+// Maps the error of a write. A socket with TCP_FASTOPEN_CONNECT connects on
+// its first write, which fails with EINPROGRESS if the data couldn't be sent
+// in the SYN. The write then has to wait for the handshake.
+int MapWriteError(int os_error) {
+  if (os_error == EINPROGRESS) return ERR_IO_PENDING;
+  return MapSystemError(os_error);
+}
+
+int SendFlags() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // See SocketPosix::DoWrite().
+  return MSG_NOSIGNAL;
+#else
+  return 0;
+#endif
+}
+
+#if defined(OS_LINUX)
+// How soon the error queue of a closed socket is first checked for the
+// zero-copy writes the kernel isn't done with yet, and at most how seldom as
+// the delay doubles. Nothing watches a closed socket, whose peer may have
+// hung up, which would keep it readable.
+constexpr absl::Duration kZeroCopyLingerMinDelay = absl::Milliseconds(1);
+constexpr absl::Duration kZeroCopyLingerMaxDelay = absl::Seconds(1);
+#endif
+
 }  // namespace
 
 SocketPosix::SocketPosix()
@@ -117,6 +166,8 @@ int SocketPosix::AdoptUnconnectedSocket(SocketDescriptor socket) {
 SocketDescriptor SocketPosix::ReleaseConnectedSocket() {
   // It's not safe to release a socket with a pending write.
   DCHECK(!write_buf_);
+  DCHECK(write_slices_.empty());
+  DCHECK(send_file_callback_.is_null());
 
   StopWatchingAndCleanUp(false /* close_socket */);
   SocketDescriptor socket_fd = socket_fd_;
@@ -171,6 +222,33 @@ int SocketPosix::Accept(std::unique_ptr<SocketPosix>* socket,
   return ERR_IO_PENDING;
 }
 
+int SocketPosix::AcceptMany(size_t max_sockets,
+                            std::vector<std::unique_ptr<SocketPosix>>* sockets,
+                            CompletionOnceCallback callback) {
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK(accept_callback_.is_null());
+  DCHECK_LT(0u, max_sockets);
+  DCHECK(sockets);
+  DCHECK(!callback.is_null());
+
+  accept_sockets_ = sockets;
+  accept_max_sockets_ = max_sockets;
+  int rv = DoAcceptMany();
+  if (rv == ERR_IO_PENDING) {
+    if (EventLoop::Current()->WatchFileDescriptor(
+            socket_fd_, true, EventLoop::WATCH_READ, &accept_socket_watcher_,
+            this)) {
+      accept_callback_ = std::move(callback);
+      return ERR_IO_PENDING;
+    }
+    PLOG(ERROR) << "WatchFileDescriptor failed on accept";
+    rv = MapSystemError(errno);
+  }
+
+  accept_sockets_ = nullptr;
+  return rv;
+}
+
 int SocketPosix::Connect(const SockaddrStorage& address,
                          CompletionOnceCallback callback) {
   DCHECK_NE(kInvalidSocket, socket_fd_);
@@ -240,6 +318,23 @@ bool SocketPosix::IsConnectedAndIdle() const {
 
 int SocketPosix::Read(std::shared_ptr<IOBuffer> buf, int buf_len,
                       CompletionOnceCallback callback) {
+  EventLoop* event_loop = EventLoop::Current();
+  if (event_loop->SupportsCompletionIo()) {
+    DCHECK_NE(kInvalidSocket, socket_fd_);
+    DCHECK(!waiting_connect_);
+    CHECK(read_callback_.is_null());
+    DCHECK(!callback.is_null());
+    DCHECK_LT(0, buf_len);
+
+    // The kernel receives into |buf| as soon as data arrives, so there is no
+    // need to wait for readability and then call read().
+    read_callback_ = std::move(callback);
+    event_loop->SubmitRecv(socket_fd_, std::move(buf), buf_len, 0,
+                           &read_operation_,
+                           absl::bind_front(&SocketPosix::RecvCompleted, this));
+    return ERR_IO_PENDING;
+  }
+
   int rv = ReadIfReady(buf, buf_len,
                        absl::bind_front(&SocketPosix::RetryRead, this));
   if (rv == ERR_IO_PENDING) {
@@ -282,6 +377,62 @@ int SocketPosix::CancelReadIfReady() {
   return OK;
 }
 
+int SocketPosix::Readv(absl::Span<const IOBufferSlice> slices,
+                       CompletionOnceCallback callback) {
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK(!waiting_connect_);
+  CHECK(read_callback_.is_null());
+  CHECK(read_if_ready_callback_.is_null());
+  DCHECK(!callback.is_null());
+  DCHECK(!slices.empty());
+
+  read_slices_.assign(slices.begin(), slices.end());
+  int rv = ReadvIfReady();
+  if (rv == ERR_IO_PENDING) {
+    read_callback_ = std::move(callback);
+  } else {
+    read_slices_.clear();
+  }
+  return rv;
+}
+
+int SocketPosix::Writev(absl::Span<const IOBufferSlice> slices,
+                        CompletionOnceCallback callback) {
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK(!waiting_connect_);
+  CHECK(write_callback_.is_null());
+  // Synchronous operation not supported
+  DCHECK(!callback.is_null());
+
+  // Empty slices are dropped, so that every slice moves the write forward.
+  write_slices_len_ = 0;
+  for (const IOBufferSlice& slice : slices) {
+    DCHECK_LE(0, slice.len);
+    if (slice.len == 0) continue;
+    write_slices_.push_back(slice);
+    write_slices_len_ += slice.len;
+  }
+  DCHECK_LT(0, write_slices_len_);
+  write_slice_index_ = 0;
+  write_slice_offset_ = 0;
+
+  int rv = DoWritev();
+  if (rv == ERR_IO_PENDING) {
+    if (EventLoop::Current()->WatchFileDescriptor(
+            socket_fd_, true, EventLoop::WATCH_WRITE, &write_socket_watcher_,
+            this)) {
+      write_callback_ = std::move(callback);
+      return ERR_IO_PENDING;
+    }
+    PLOG(ERROR) << "WatchFileDescriptor failed on write";
+    rv = MapSystemError(errno);
+  }
+
+  if (rv == OK) rv = write_slices_len_;
+  write_slices_.clear();
+  return rv;
+}
+
 int SocketPosix::Write(std::shared_ptr<IOBuffer> buf, int buf_len,
                        CompletionOnceCallback callback) {
   DCHECK_NE(kInvalidSocket, socket_fd_);
@@ -291,7 +442,16 @@ int SocketPosix::Write(std::shared_ptr<IOBuffer> buf, int buf_len,
   DCHECK(!callback.is_null());
   DCHECK_LT(0, buf_len);
 
-  int rv = DoWrite(buf.get(), buf_len);
+  EventLoop* event_loop = EventLoop::Current();
+  if (event_loop->SupportsCompletionIo() && !fast_open_connect_) {
+    write_callback_ = std::move(callback);
+    event_loop->SubmitSend(socket_fd_, std::move(buf), buf_len, SendFlags(),
+                           &write_operation_,
+                           absl::bind_front(&SocketPosix::SendCompleted, this));
+    return ERR_IO_PENDING;
+  }
+
+  int rv = DoWrite(buf, buf_len);
   if (rv == ERR_IO_PENDING)
     rv = WaitForWrite(buf, buf_len, std::move(callback));
   return rv;
@@ -318,6 +478,75 @@ int SocketPosix::WaitForWrite(std::shared_ptr<IOBuffer> buf, int buf_len,
   return ERR_IO_PENDING;
 }
 
+int64_t SocketPosix::SendFile(const File& file, int64_t offset,
+                              int64_t length,
+                              Int64CompletionOnceCallback callback) {
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK(!waiting_connect_);
+  CHECK(write_callback_.is_null());
+  CHECK(send_file_callback_.is_null());
+  DCHECK(!callback.is_null());
+  DCHECK(file.IsValid());
+  DCHECK_LE(0, offset);
+  DCHECK_LT(0, length);
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  send_file_fd_ = file.GetPlatformFile();
+  send_file_offset_ = offset;
+  send_file_remaining_ = length;
+  send_file_sent_ = 0;
+
+  int rv = DoSendFile();
+  if (rv == ERR_IO_PENDING) {
+    if (EventLoop::Current()->WatchFileDescriptor(
+            socket_fd_, true, EventLoop::WATCH_WRITE, &write_socket_watcher_,
+            this)) {
+      send_file_callback_ = std::move(callback);
+      return ERR_IO_PENDING;
+    }
+    PLOG(ERROR) << "WatchFileDescriptor failed on sendfile";
+    rv = MapSystemError(errno);
+  }
+
+  send_file_fd_ = -1;
+  return rv == OK ? send_file_sent_ : rv;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+int SocketPosix::EnableTCPFastOpenConnect() {
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK(!HasPeerAddress());
+
+  int rv = SetTCPFastOpenConnect(socket_fd_, true);
+  if (rv == OK) fast_open_connect_ = true;
+  return rv;
+}
+
+int SocketPosix::EnableZeroCopy(size_t min_size) {
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK_LT(0u, min_size);
+
+#if defined(OS_LINUX)
+  int rv = SetZeroCopy(socket_fd_, true);
+  if (rv != OK) return rv;
+
+  zero_copy_min_size_ = min_size;
+  return OK;
+#else
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+size_t SocketPosix::pending_zero_copy_writes() const {
+#if defined(OS_LINUX)
+  return zero_copy_writes_.size();
+#else
+  return 0;
+#endif
+}
+
 int SocketPosix::GetLocalAddress(SockaddrStorage* address) const {
   DCHECK(address);
 
@@ -352,7 +581,14 @@ bool SocketPosix::HasPeerAddress() const { return peer_address_ != nullptr; }
 void SocketPosix::Close() { StopWatchingAndCleanUp(true /* close_socket */); }
 
 void SocketPosix::OnFileCanRead(int fd) {
-  if (!accept_callback_.is_null()) {
+#if defined(OS_LINUX)
+  // A pending error queue makes the socket readable and writable.
+  if (!zero_copy_writes_.empty()) ReapZeroCopyCompletions();
+#endif
+
+  if (accept_sockets_) {
+    AcceptManyCompleted();
+  } else if (!accept_callback_.is_null()) {
     AcceptCompleted();
   } else {
     DCHECK(!read_if_ready_callback_.is_null());
@@ -361,9 +597,20 @@ void SocketPosix::OnFileCanRead(int fd) {
 }
 
 void SocketPosix::OnFileCanWrite(int fd) {
+#if defined(OS_LINUX)
+  if (!zero_copy_writes_.empty()) ReapZeroCopyCompletions();
+#endif
+
+  if (!send_file_callback_.is_null()) {
+    SendFileCompleted();
+    return;
+  }
+
   DCHECK(!write_callback_.is_null());
   if (waiting_connect_) {
     ConnectCompleted();
+  } else if (!write_slices_.empty()) {
+    WritevCompleted();
   } else {
     WriteCompleted();
   }
@@ -371,6 +618,18 @@ void SocketPosix::OnFileCanWrite(int fd) {
 
 int SocketPosix::DoAccept(std::unique_ptr<SocketPosix>* socket) {
   SockaddrStorage new_peer_address;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // accept4() makes the socket non-blocking and close-on-exec right away,
+  // which saves the fcntl() calls of AdoptConnectedSocket().
+  int new_socket = HANDLE_EINTR(
+      accept4(socket_fd_, new_peer_address.addr, &new_peer_address.addr_len,
+              SOCK_NONBLOCK | SOCK_CLOEXEC));
+  if (new_socket < 0) return MapAcceptError(errno);
+
+  std::unique_ptr<SocketPosix> accepted_socket(new SocketPosix);
+  accepted_socket->socket_fd_ = new_socket;
+  accepted_socket->SetPeerAddress(new_peer_address);
+#else
   int new_socket = HANDLE_EINTR(
       accept(socket_fd_, new_peer_address.addr, &new_peer_address.addr_len));
   if (new_socket < 0) return MapAcceptError(errno);
@@ -378,6 +637,7 @@ int SocketPosix::DoAccept(std::unique_ptr<SocketPosix>* socket) {
   std::unique_ptr<SocketPosix> accepted_socket(new SocketPosix);
   int rv = accepted_socket->AdoptConnectedSocket(new_socket, new_peer_address);
   if (rv != OK) return rv;
+#endif
 
   *socket = std::move(accepted_socket);
   return OK;
@@ -394,6 +654,37 @@ void SocketPosix::AcceptCompleted() {
   std::move(accept_callback_).Run(rv);
 }
 
+int SocketPosix::DoAcceptMany() {
+  DCHECK(accept_sockets_);
+
+  size_t count = 0;
+  while (count < accept_max_sockets_) {
+    std::unique_ptr<SocketPosix> socket;
+    int rv = DoAccept(&socket);
+    // An aborted connection doesn't mean that the backlog is empty.
+    if (rv == ERR_IO_PENDING && errno == ECONNABORTED) continue;
+    if (rv != OK) {
+      // An error is only reported once it is the first thing to happen. It
+      // will happen again on the next call if it persists.
+      if (count > 0) break;
+      return rv;
+    }
+    accept_sockets_->push_back(std::move(socket));
+    ++count;
+  }
+  return static_cast<int>(count);
+}
+
+void SocketPosix::AcceptManyCompleted() {
+  int rv = DoAcceptMany();
+  if (rv == ERR_IO_PENDING) return;
+
+  bool ok = accept_socket_watcher_.StopWatchingFileDescriptor();
+  DCHECK(ok);
+  accept_sockets_ = nullptr;
+  std::move(accept_callback_).Run(rv);
+}
+
 int SocketPosix::DoConnect() {
   int rv = HANDLE_EINTR(
       connect(socket_fd_, peer_address_->addr, peer_address_->addr_len));
@@ -439,6 +730,44 @@ void SocketPosix::RetryRead(int rv) {
   std::move(read_callback_).Run(rv);
 }
 
+int SocketPosix::DoReadv() {
+  iovec iov[kMaxIovecs];
+  size_t count = std::min(read_slices_.size(), kMaxIovecs);
+  for (size_t i = 0; i < count; ++i) {
+    iov[i].iov_base = read_slices_[i].buf->data() + read_slices_[i].offset;
+    iov[i].iov_len = read_slices_[i].len;
+  }
+  int rv = HANDLE_EINTR(readv(socket_fd_, iov, count));
+  return rv >= 0 ? rv : MapSystemError(errno);
+}
+
+int SocketPosix::ReadvIfReady() {
+  int rv = DoReadv();
+  if (rv != ERR_IO_PENDING) return rv;
+
+  if (!EventLoop::Current()->WatchFileDescriptor(socket_fd_, true,
+                                                 EventLoop::WATCH_READ,
+                                                 &read_socket_watcher_, this)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on read";
+    return MapSystemError(errno);
+  }
+
+  read_if_ready_callback_ = absl::bind_front(&SocketPosix::RetryReadv, this);
+  return ERR_IO_PENDING;
+}
+
+void SocketPosix::RetryReadv(int rv) {
+  DCHECK(read_callback_);
+  DCHECK(!read_slices_.empty());
+
+  if (rv == OK) {
+    rv = ReadvIfReady();
+    if (rv == ERR_IO_PENDING) return;
+  }
+  read_slices_.clear();
+  std::move(read_callback_).Run(rv);
+}
+
 void SocketPosix::ReadCompleted() {
   DCHECK(read_if_ready_callback_);
 
@@ -447,7 +776,39 @@ void SocketPosix::ReadCompleted() {
   std::move(read_if_ready_callback_).Run(OK);
 }
 
-int SocketPosix::DoWrite(IOBuffer* buf, int buf_len) {
+void SocketPosix::RecvCompleted(int rv) {
+  DCHECK(read_callback_);
+
+  if (rv < 0) {
+    errno = -rv;
+    rv = MapSystemError(errno);
+  }
+  std::move(read_callback_).Run(rv);
+}
+
+int SocketPosix::DoWrite(const std::shared_ptr<IOBuffer>& buf, int buf_len) {
+#if defined(OS_LINUX)
+  if (zero_copy_min_size_ > 0 &&
+      static_cast<size_t>(buf_len) >= zero_copy_min_size_) {
+    // Every zero-copy send() uses optmem of the socket until its completion
+    // is read from the error queue.
+    if (!zero_copy_writes_.empty()) ReapZeroCopyCompletions();
+
+    int rv = HANDLE_EINTR(send(socket_fd_, buf->data(), buf_len,
+                               MSG_NOSIGNAL | MSG_ZEROCOPY));
+    if (rv >= 0) {
+      // The kernel numbers the zero-copy sends of a socket, starting at zero,
+      // whether or not it ended up copying the data.
+      zero_copy_writes_.push_back({next_zero_copy_id_++, buf, false});
+      fast_open_connect_ = false;
+      return rv;
+    }
+    // ENOBUFS means the socket is out of optmem to track the pinned pages,
+    // so copy instead.
+    if (errno != ENOBUFS) return MapWriteError(errno);
+  }
+#endif
+
 #if defined(OS_LINUX) || defined(OS_ANDROID)
   // Disable SIGPIPE for this write. Although Chromium globally disables
   // SIGPIPE, the net stack may be used in other consumers which do not do
@@ -457,11 +818,185 @@ int SocketPosix::DoWrite(IOBuffer* buf, int buf_len) {
 #else
   int rv = HANDLE_EINTR(write(socket_fd_, buf->data(), buf_len));
 #endif
-  return rv >= 0 ? rv : MapSystemError(errno);
+  if (rv < 0) return MapWriteError(errno);
+
+  fast_open_connect_ = false;
+  return rv;
+}
+
+#if defined(OS_LINUX)
+// The fd of a closed socket, kept open with the zero-copy writes the kernel may
+// still retransmit from.
+struct SocketPosix::ZeroCopyLinger {
+  ~ZeroCopyLinger() {
+    if (!writes.empty()) {
+      // The kernel still reads their pages, so freeing the IOBuffers could
+      // send whatever reuses the memory instead.
+      LOG(WARNING) << "Leaking " << writes.size()
+                   << " zero-copy writes of a closed socket";
+      for (ZeroCopyWrite& write : writes)
+        new std::shared_ptr<IOBuffer>(std::move(write.buf));
+    }
+    if (IGNORE_EINTR(close(fd)) < 0) DPLOG(ERROR) << "close() failed";
+  }
+
+  SocketDescriptor fd;
+  std::deque<ZeroCopyWrite> writes;
+};
+
+void SocketPosix::ReapZeroCopyCompletions() {
+  bool copied = false;
+  ReapZeroCopyCompletions(socket_fd_, &zero_copy_writes_, &copied);
+  // The pages were pinned for nothing, e.g. on loopback.
+  if (copied) zero_copy_min_size_ = 0;
+}
+
+// static
+void SocketPosix::ReapZeroCopyCompletions(SocketDescriptor fd,
+                                          std::deque<ZeroCopyWrite>* writes,
+                                          bool* copied) {
+  for (;;) {
+    char control[CMSG_SPACE(sizeof(sock_extended_err)) +
+                 CMSG_SPACE(sizeof(sockaddr_in6))];
+    msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    int rv = HANDLE_EINTR(recvmsg(fd, &msg, MSG_ERRQUEUE));
+    if (rv < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        DPLOG(ERROR) << "recvmsg(MSG_ERRQUEUE) failed";
+      break;
+    }
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+          !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+        continue;
+      }
+      const sock_extended_err* err =
+          reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cmsg));
+      if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY || err->ee_errno != 0)
+        continue;
+      if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) *copied = true;
+
+      // The notification covers the ids from |ee_info| to |ee_data|, which
+      // may wrap around.
+      uint32_t lo = err->ee_info;
+      uint32_t hi = err->ee_data;
+      for (ZeroCopyWrite& write : *writes) {
+        if (write.id - lo <= hi - lo) write.completed = true;
+      }
+    }
+  }
+
+  // A write which completes out of order is only released together with the
+  // earlier ones.
+  while (!writes->empty() && writes->front().completed) writes->pop_front();
+}
+
+// static
+void SocketPosix::CloseWhenZeroCopyCompleted(
+    std::shared_ptr<ZeroCopyLinger> linger, absl::Duration delay) {
+  bool copied = false;
+  ReapZeroCopyCompletions(linger->fd, &linger->writes, &copied);
+  if (linger->writes.empty()) return;
+
+  // If the EventLoop is gone, or goes away before the task runs, |linger|
+  // leaks the IOBuffers.
+  EventLoop* event_loop = EventLoop::Current();
+  if (!event_loop) return;
+  absl::Duration next_delay = std::min(delay * 2, kZeroCopyLingerMaxDelay);
+  event_loop->PostDelayedTask(
+      [linger, next_delay]() {
+        CloseWhenZeroCopyCompleted(linger, next_delay);
+      },
+      delay);
+}
+#endif  // OS_LINUX
+
+int SocketPosix::DoWritev() {
+  while (write_slice_index_ < write_slices_.size()) {
+    iovec iov[kMaxIovecs];
+    size_t count =
+        std::min(write_slices_.size() - write_slice_index_, kMaxIovecs);
+    for (size_t i = 0; i < count; ++i) {
+      const IOBufferSlice& slice = write_slices_[write_slice_index_ + i];
+      int offset = i == 0 ? write_slice_offset_ : 0;
+      iov[i].iov_base = slice.buf->data() + slice.offset + offset;
+      iov[i].iov_len = slice.len - offset;
+    }
+    // sendmsg() rather than writev(), so that SendFlags() apply. See
+    // DoWrite().
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    int rv = HANDLE_EINTR(sendmsg(socket_fd_, &msg, SendFlags()));
+    if (rv < 0) return MapWriteError(errno);
+    fast_open_connect_ = false;
+
+    // Skip over the slices which were written completely.
+    while (rv > 0) {
+      int remaining =
+          write_slices_[write_slice_index_].len - write_slice_offset_;
+      if (rv < remaining) {
+        write_slice_offset_ += rv;
+        break;
+      }
+      rv -= remaining;
+      ++write_slice_index_;
+      write_slice_offset_ = 0;
+    }
+  }
+  return OK;
+}
+
+int SocketPosix::DoSendFile() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  while (send_file_remaining_ > 0) {
+    // Linux sends at most 0x7ffff000 bytes per call anyway.
+    size_t count = std::min<int64_t>(send_file_remaining_, 1 << 30);
+    off64_t offset = send_file_offset_;
+    ssize_t rv =
+        HANDLE_EINTR(sendfile64(socket_fd_, send_file_fd_, &offset, count));
+    if (rv < 0) return MapSystemError(errno);
+    // The file is shorter than the caller said.
+    if (rv == 0) break;
+
+    send_file_offset_ += rv;
+    send_file_remaining_ -= rv;
+    send_file_sent_ += rv;
+  }
+  return OK;
+#else
+  NOTREACHED();
+  return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+void SocketPosix::SendFileCompleted() {
+  int rv = DoSendFile();
+  if (rv == ERR_IO_PENDING) return;
+
+  bool ok = write_socket_watcher_.StopWatchingFileDescriptor();
+  DCHECK(ok);
+  send_file_fd_ = -1;
+  std::move(send_file_callback_).Run(rv == OK ? send_file_sent_ : rv);
+}
+
+void SocketPosix::WritevCompleted() {
+  int rv = DoWritev();
+  if (rv == ERR_IO_PENDING) return;
+
+  bool ok = write_socket_watcher_.StopWatchingFileDescriptor();
+  DCHECK(ok);
+  if (rv == OK) rv = write_slices_len_;
+  write_slices_.clear();
+  std::move(write_callback_).Run(rv);
 }
 
 void SocketPosix::WriteCompleted() {
-  int rv = DoWrite(write_buf_.get(), write_buf_len_);
+  int rv = DoWrite(write_buf_, write_buf_len_);
   if (rv == ERR_IO_PENDING) return;
 
   bool ok = write_socket_watcher_.StopWatchingFileDescriptor();
@@ -471,7 +1006,20 @@ void SocketPosix::WriteCompleted() {
   std::move(write_callback_).Run(rv);
 }
 
+void SocketPosix::SendCompleted(int rv) {
+  DCHECK(write_callback_);
+
+  if (rv < 0) {
+    errno = -rv;
+    rv = MapSystemError(errno);
+  }
+  std::move(write_callback_).Run(rv);
+}
+
 void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
+  read_operation_.Cancel();
+  write_operation_.Cancel();
+
   bool ok = accept_socket_watcher_.StopWatchingFileDescriptor();
   DCHECK(ok);
   ok = read_socket_watcher_.StopWatchingFileDescriptor();
@@ -482,6 +1030,23 @@ void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
   // These needs to be done after the StopWatchingFileDescriptor() calls, but
   // before deleting the write buffer.
   if (close_socket) {
+#if defined(OS_LINUX)
+    if (socket_fd_ != kInvalidSocket && !zero_copy_writes_.empty())
+      ReapZeroCopyCompletions();
+    if (socket_fd_ != kInvalidSocket && !zero_copy_writes_.empty()) {
+      // Closing the socket doesn't stop the kernel from retransmitting out of
+      // the pinned pages, so keep them, and the socket to learn when the
+      // kernel is done with them. The peer still sees the end of the stream
+      // right away.
+      if (shutdown(socket_fd_, SHUT_WR) < 0) DPLOG(ERROR) << "shutdown failed";
+      auto linger = std::make_shared<ZeroCopyLinger>();
+      linger->fd = socket_fd_;
+      linger->writes = std::move(zero_copy_writes_);
+      zero_copy_writes_.clear();
+      socket_fd_ = kInvalidSocket;
+      CloseWhenZeroCopyCompleted(std::move(linger), kZeroCopyLingerMinDelay);
+    }
+#endif
     if (socket_fd_ != kInvalidSocket) {
       if (IGNORE_EINTR(close(socket_fd_)) < 0) DPLOG(ERROR) << "close() failed";
       socket_fd_ = kInvalidSocket;
@@ -490,12 +1055,14 @@ void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
 
   if (!accept_callback_.is_null()) {
     accept_socket_ = nullptr;
+    accept_sockets_ = nullptr;
     accept_callback_.Reset();
   }
 
   if (!read_callback_.is_null()) {
     read_buf_.reset();
     read_buf_len_ = 0;
+    read_slices_.clear();
     read_callback_.Reset();
   }
 
@@ -504,10 +1071,22 @@ void SocketPosix::StopWatchingAndCleanUp(bool close_socket) {
   if (!write_callback_.is_null()) {
     write_buf_.reset();
     write_buf_len_ = 0;
+    write_slices_.clear();
     write_callback_.Reset();
   }
 
+  send_file_fd_ = -1;
+  send_file_callback_.Reset();
+
+#if defined(OS_LINUX)
+  if (close_socket) {
+    zero_copy_min_size_ = 0;
+    next_zero_copy_id_ = 0;
+  }
+#endif
+
   waiting_connect_ = false;
+  if (close_socket) fast_open_connect_ = false;
   peer_address_.reset();
 }
 
@@ -9,6 +9,17 @@
 #ifndef BASE_SOCKET_SOCKET_POSIX_H_
 #define BASE_SOCKET_SOCKET_POSIX_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+#include "base/build_config.h"
 #include "base/completion_once_callback.h"
 #include "base/event_loop/event_loop.h"
 #include "base/export.h"
@@ -18,6 +29,8 @@
 
 namespace base {
 
+class File;
+
 class BASE_EXPORT SocketPosix : public EventLoop::FdWatcher {
  public:
   SocketPosix();
@@ -48,6 +61,14 @@ class BASE_EXPORT SocketPosix : public EventLoop::FdWatcher {
   int Listen(int backlog);
   int Accept(std::unique_ptr<SocketPosix>* socket,
              CompletionOnceCallback callback);
+  // Accepts up to |max_sockets| pending connections at once and appends them
+  // to |sockets|. Returns the number of accepted sockets. If there is none,
+  // returns ERR_IO_PENDING and runs |callback| once the connections of the
+  // next readiness notification are accepted, again up to |max_sockets|. Any
+  // connections left over are accepted by the next call.
+  int AcceptMany(size_t max_sockets,
+                 std::vector<std::unique_ptr<SocketPosix>>* sockets,
+                 CompletionOnceCallback callback);
 
   // Connects socket. On non-ERR_IO_PENDING error, sets errno and returns a net
   // error code. On ERR_IO_PENDING, |callback| is called with a net error code,
@@ -62,6 +83,8 @@ class BASE_EXPORT SocketPosix : public EventLoop::FdWatcher {
   // On error which is not ERR_IO_PENDING, sets errno and returns a net error
   // code. On ERR_IO_PENDING, |callback| is called with a net error code, not
   // errno, though errno is set if read or write events happen with error.
+  // If the EventLoop supports completion-based I/O, Read() and Write() are
+  // always submitted to it and return ERR_IO_PENDING.
   // TODO(byungchul): Need more robust way to pass system errno.
   int Read(std::shared_ptr<IOBuffer> buf, int buf_len,
            CompletionOnceCallback callback);
@@ -84,6 +107,58 @@ class BASE_EXPORT SocketPosix : public EventLoop::FdWatcher {
   int WaitForWrite(std::shared_ptr<IOBuffer> buf, int buf_len,
                    CompletionOnceCallback callback);
 
+  // Reads into |slices| in order with a single readv(). Returns the number of
+  // bytes read, which may fill only some of the slices, or 0 at the end of
+  // the stream. Otherwise behaves like Read().
+  int Readv(absl::Span<const IOBufferSlice> slices,
+            CompletionOnceCallback callback);
+
+  // Writes all of |slices| in order, picking up a partial writev() from where
+  // it left off. Unlike Write(), it only completes once every slice has been
+  // written, with the total number of bytes, or with an error, in which case
+  // an unknown part of |slices| may have been sent. The IOBuffers must not be
+  // modified until then.
+  int Writev(absl::Span<const IOBufferSlice> slices,
+             CompletionOnceCallback callback);
+
+  // Sets TCP_FASTOPEN_CONNECT, so that Connect() completes right away and the
+  // first Write() or Writev() carries the data in the SYN. See
+  // SetTCPFastOpenConnect() in socket_options.h. Must be called on a TCP
+  // socket before Connect(). The first write is never submitted to an
+  // EventLoop with completion-based I/O, since it may need to wait for the
+  // handshake.
+  int EnableTCPFastOpenConnect();
+
+  // Sends |length| bytes of |file| from |offset| on with sendfile(). See
+  // StreamSocket::SendFile(). Returns ERR_NOT_IMPLEMENTED on platforms without
+  // a Linux-style sendfile().
+  int64_t SendFile(const File& file, int64_t offset, int64_t length,
+                   Int64CompletionOnceCallback callback);
+
+  // Makes Write() send buffers of at least |min_size| bytes with
+  // MSG_ZEROCOPY, which pins the pages of the IOBuffer instead of copying them
+  // into the kernel. The IOBuffer is kept alive until the kernel reports on
+  // the error queue that it is done with it, which happens once the peer has
+  // acknowledged the data. The write callback still runs as soon as send()
+  // returns, so the caller must not modify the contents of the IOBuffer
+  // afterwards; write a new IOBuffer each time instead. This only pays off for
+  // writes of more than about 10KB. Writes submitted to an EventLoop with
+  // completion-based I/O always copy. Returns ERR_NOT_IMPLEMENTED on platforms
+  // without MSG_ZEROCOPY, which Linux supports since 4.14 for TCP sockets.
+  //
+  // The kernel flags the socket with an error once it is done with a write,
+  // so the IOBuffers are released when a pending read or write is notified,
+  // and before each zero-copy write. Once the kernel reports that it copied
+  // the data anyway, e.g. for a loopback or tunnel device, the socket goes
+  // back to copying writes. Close() shuts down the sending side right away,
+  // but keeps the file descriptor and the IOBuffers until the kernel is done
+  // with them, checking back on the EventLoop. If the EventLoop is destroyed
+  // before then, the IOBuffers are leaked rather than freed.
+  int EnableZeroCopy(size_t min_size);
+
+  // The number of zero-copy writes whose IOBuffer the kernel may still use.
+  size_t pending_zero_copy_writes() const;
+
   int GetLocalAddress(SockaddrStorage* address) const;
   int GetPeerAddress(SockaddrStorage* address) const;
   void SetPeerAddress(const SockaddrStorage& address);
@@ -101,16 +176,56 @@ class BASE_EXPORT SocketPosix : public EventLoop::FdWatcher {
 
   int DoAccept(std::unique_ptr<SocketPosix>* socket);
   void AcceptCompleted();
+  int DoAcceptMany();
+  void AcceptManyCompleted();
 
   int DoConnect();
   void ConnectCompleted();
 
   int DoRead(IOBuffer* buf, int buf_len);
   void RetryRead(int rv);
+  int DoReadv();
+  // Reads into |read_slices_| or waits for the socket to become readable.
+  int ReadvIfReady();
+  void RetryReadv(int rv);
   void ReadCompleted();
+  // Called with the result of a Read() submitted to the EventLoop.
+  void RecvCompleted(int rv);
 
-  int DoWrite(IOBuffer* buf, int buf_len);
+  int DoWrite(const std::shared_ptr<IOBuffer>& buf, int buf_len);
+  // Writes the rest of |write_slices_|. Returns OK once all of it is written.
+  int DoWritev();
   void WriteCompleted();
+  void WritevCompleted();
+  // Sends the rest of the file of a SendFile(). Returns OK once it is sent.
+  int DoSendFile();
+  void SendFileCompleted();
+  // Called with the result of a Write() submitted to the EventLoop.
+  void SendCompleted(int rv);
+
+#if defined(OS_LINUX)
+  struct ZeroCopyWrite {
+    // The id the kernel notifies the completion of the write with.
+    uint32_t id;
+    std::shared_ptr<IOBuffer> buf;
+    bool completed;
+  };
+
+  struct ZeroCopyLinger;
+
+  // Releases the IOBuffers of the zero-copy writes the kernel is done with,
+  // and stops sending with MSG_ZEROCOPY if the kernel copied them.
+  void ReapZeroCopyCompletions();
+  // Removes the writes of |writes| on |fd| which the kernel is done with, in
+  // order. Sets |*copied| if the kernel copied any of them.
+  static void ReapZeroCopyCompletions(SocketDescriptor fd,
+                                      std::deque<ZeroCopyWrite>* writes,
+                                      bool* copied);
+  // Closes the file descriptor of |linger| once the kernel is done with its
+  // writes, checking again after |delay| until then.
+  static void CloseWhenZeroCopyCompleted(
+      std::shared_ptr<ZeroCopyLinger> linger, absl::Duration delay);
+#endif
 
   // |close_socket| indicates whether the socket should also be closed.
   void StopWatchingAndCleanUp(bool close_socket);
@@ -119,6 +234,9 @@ class BASE_EXPORT SocketPosix : public EventLoop::FdWatcher {
 
   EventLoop::FdWatchController accept_socket_watcher_;
   std::unique_ptr<SocketPosix>* accept_socket_;
+  // Non-null when an AcceptMany() is in progress.
+  std::vector<std::unique_ptr<SocketPosix>>* accept_sockets_ = nullptr;
+  size_t accept_max_sockets_ = 0;
   CompletionOnceCallback accept_callback_;
 
   EventLoop::FdWatchController read_socket_watcher_;
@@ -128,20 +246,54 @@ class BASE_EXPORT SocketPosix : public EventLoop::FdWatcher {
   int read_buf_len_;
   CompletionOnceCallback read_callback_;
 
+  // Non-empty when a Readv() is in progress.
+  std::vector<IOBufferSlice> read_slices_;
+
   // Non-null when a ReadIfReady() is in progress.
   CompletionOnceCallback read_if_ready_callback_;
 
+  // Pending when a Read() has been submitted to the EventLoop.
+  EventLoop::IoOperation read_operation_;
+
   EventLoop::FdWatchController write_socket_watcher_;
   std::shared_ptr<IOBuffer> write_buf_;
   int write_buf_len_;
+  // Non-empty when a Writev() is in progress. The next byte to write is at
+  // |write_slice_offset_| of the slice at |write_slice_index_|.
+  std::vector<IOBufferSlice> write_slices_;
+  size_t write_slice_index_ = 0;
+  int write_slice_offset_ = 0;
+  int write_slices_len_ = 0;
   // External callback; called when write or connect is complete.
   CompletionOnceCallback write_callback_;
 
+  // Valid when a SendFile() is in progress, which has |send_file_remaining_|
+  // bytes left to send from |send_file_offset_| of |send_file_fd_| on.
+  int send_file_fd_ = -1;
+  int64_t send_file_offset_ = 0;
+  int64_t send_file_remaining_ = 0;
+  int64_t send_file_sent_ = 0;
+  Int64CompletionOnceCallback send_file_callback_;
+
+  // Pending when a Write() has been submitted to the EventLoop.
+  EventLoop::IoOperation write_operation_;
+
   // A connect operation is pending. In this case, |write_callback_| needs to be
   // called when connect is complete.
   bool waiting_connect_;
 
+  // The connect is deferred to the first write by TCP_FASTOPEN_CONNECT.
+  bool fast_open_connect_ = false;
+
   std::unique_ptr<SockaddrStorage> peer_address_;
+
+#if defined(OS_LINUX)
+  // Zero for writes which always copy.
+  size_t zero_copy_min_size_ = 0;
+  uint32_t next_zero_copy_id_ = 0;
+  // In the order they were sent.
+  std::deque<ZeroCopyWrite> zero_copy_writes_;
+#endif
 };
 
 }  // namespace base
@@ -0,0 +1,369 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/socket_posix.h"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/build_config.h"
+#include "base/event_loop/event_loop.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/io_buffer.h"
+#include "base/logging.h"
+#include "base/socket/socket_errors.h"
+#include "base/test/socket_test_util.h"
+#include "base/timer/timer.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+#if defined(OS_LINUX)
+TEST(SocketPosixTest, ZeroCopyWrite) {
+  constexpr int kSize = 64 * 1024;
+
+  EventLoop event_loop;
+  int fds[2];
+  ConnectLoopback(fds);
+  SocketPosix socket;
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], SockaddrStorage()));
+  int rv = socket.EnableZeroCopy(1);
+  if (rv == ERR_NOT_IMPLEMENTED) return;
+  ASSERT_EQ(OK, rv);
+
+  std::shared_ptr<IOBuffer> buf = std::make_shared<IOBuffer>(kSize);
+  memset(buf->data(), 'a', kSize);
+  int written = 0;
+  while (written < kSize) {
+    rv = socket.Write(buf, kSize - written, [](int rv) { NOTREACHED(); });
+    ASSERT_LT(0, rv);
+    written += rv;
+  }
+  EXPECT_LT(0u, socket.pending_zero_copy_writes());
+  EXPECT_LT(1, buf.use_count());
+
+  std::vector<char> received(kSize);
+  int read = 0;
+  while (read < kSize) {
+    rv = recv(fds[1], received.data() + read, kSize - read, 0);
+    ASSERT_LT(0, rv);
+    read += rv;
+  }
+  EXPECT_EQ(std::vector<char>(kSize, 'a'), received);
+
+  // The completions wake up the pending read.
+  auto read_buf = std::make_shared<IOBuffer>(1);
+  ASSERT_EQ(ERR_IO_PENDING,
+            socket.Read(read_buf, 1, [](int rv) { NOTREACHED(); }));
+  RunEventLoopUntil([&socket]() {
+    return socket.pending_zero_copy_writes() == 0;
+  });
+  EXPECT_EQ(1, buf.use_count());
+
+  // The kernel copies the data on its way over loopback anyway, so the socket
+  // goes back to copying.
+  buf = std::make_shared<IOBuffer>(kSize);
+  ASSERT_LT(0, socket.Write(buf, kSize, [](int rv) { NOTREACHED(); }));
+  EXPECT_EQ(0u, socket.pending_zero_copy_writes());
+  EXPECT_EQ(1, buf.use_count());
+
+  socket.Close();
+  close(fds[1]);
+}
+
+TEST(SocketPosixTest, ZeroCopyWriteOutlivesClose) {
+  constexpr int kSize = 64 * 1024;
+
+  EventLoop event_loop;
+  int fds[2];
+  ConnectLoopback(fds);
+  SocketPosix socket;
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], SockaddrStorage()));
+  int rv = socket.EnableZeroCopy(1);
+  if (rv == ERR_NOT_IMPLEMENTED) return;
+  ASSERT_EQ(OK, rv);
+
+  std::shared_ptr<IOBuffer> buf = std::make_shared<IOBuffer>(kSize);
+  memset(buf->data(), 'a', kSize);
+  int written = socket.Write(buf, kSize, [](int rv) { NOTREACHED(); });
+  ASSERT_LT(0, written);
+  ASSERT_LT(0u, socket.pending_zero_copy_writes());
+
+  // The kernel keeps the pages until the peer has read them.
+  socket.Close();
+  EXPECT_LT(1, buf.use_count());
+
+  // The peer sees the end of the stream right after the data.
+  std::vector<char> received(kSize);
+  int read = 0;
+  while ((rv = recv(fds[1], received.data() + read, kSize - read, 0)) > 0)
+    read += rv;
+  EXPECT_EQ(0, rv);
+  EXPECT_EQ(std::string(written, 'a'), std::string(received.data(), read));
+
+  RunEventLoopUntil([&buf]() { return buf.use_count() == 1; });
+  close(fds[1]);
+}
+#endif  // defined(OS_LINUX)
+
+TEST(SocketPosixTest, ZeroCopyNotSupportedForUnixSockets) {
+  EventLoop event_loop;
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  SocketPosix socket;
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], SockaddrStorage()));
+  EXPECT_NE(OK, socket.EnableZeroCopy(1));
+  socket.Close();
+  close(fds[1]);
+}
+
+TEST(SocketPosixTest, WritevPartialWrites) {
+  EventLoop event_loop;
+  int fds[2];
+  ConnectLoopback(fds);
+  // A small send buffer makes the writes partial and the Writev() wait.
+  int buffer_size = 4096;
+  ASSERT_EQ(0, setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &buffer_size,
+                          sizeof(buffer_size)));
+  ASSERT_EQ(0, fcntl(fds[1], F_SETFL, O_NONBLOCK));
+  SocketPosix socket;
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], SockaddrStorage()));
+
+  std::string expected;
+  std::vector<IOBufferSlice> slices;
+  for (int len : {16, 1024 * 1024, 0, 7}) {
+    std::shared_ptr<IOBuffer> buf = std::make_shared<IOBuffer>(len);
+    for (int i = 0; i < len; ++i) buf->data()[i] = static_cast<char>(i % 251);
+    expected.append(buf->data(), len);
+    slices.push_back({buf, len});
+  }
+
+  int result = ERR_IO_PENDING;
+  int rv = socket.Writev(slices, [&](int rv) { result = rv; });
+  ASSERT_EQ(ERR_IO_PENDING, rv);
+
+  std::string received;
+  RepeatingTimer timer;
+  timer.Start(absl::Milliseconds(1), [&]() {
+    char buf[64 * 1024];
+    int rv;
+    while ((rv = recv(fds[1], buf, sizeof(buf), 0)) > 0)
+      received.append(buf, rv);
+    if (result != ERR_IO_PENDING && received.size() == expected.size())
+      event_loop.Quit();
+  });
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(static_cast<int>(expected.size()), result);
+  EXPECT_EQ(expected, received);
+
+  socket.Close();
+  close(fds[1]);
+}
+
+TEST(SocketPosixTest, Readv) {
+  EventLoop event_loop;
+  int fds[2];
+  ConnectLoopback(fds);
+  SocketPosix socket;
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], SockaddrStorage()));
+
+  std::shared_ptr<IOBuffer> header = std::make_shared<IOBuffer>(6);
+  std::shared_ptr<IOBuffer> body = std::make_shared<IOBuffer>(16);
+  int result = ERR_IO_PENDING;
+  int rv = socket.Readv({{header, 6}, {body, 16}}, [&](int rv) {
+    result = rv;
+    event_loop.Quit();
+  });
+  ASSERT_EQ(ERR_IO_PENDING, rv);
+
+  event_loop.PostTask(
+      [&]() { ASSERT_EQ(10, send(fds[1], "headerbody", 10, 0)); });
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(10, result);
+  EXPECT_EQ("header", std::string(header->data(), 6));
+  EXPECT_EQ("body", std::string(body->data(), 4));
+
+  // Reads complete synchronously when there is data already.
+  ASSERT_EQ(3, send(fds[1], "abc", 3, 0));
+  rv = socket.Readv({{header, 2}, {body, 16}}, [](int rv) { NOTREACHED(); });
+  EXPECT_EQ(3, rv);
+  EXPECT_EQ("ab", std::string(header->data(), 2));
+  EXPECT_EQ("c", std::string(body->data(), 1));
+
+  socket.Close();
+  close(fds[1]);
+}
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+TEST(SocketPosixTest, SendFile) {
+  constexpr int kFileSize = 1024 * 1024;
+  constexpr int kOffset = 100;
+
+  FilePath path;
+  ASSERT_TRUE(CreateTemporaryFile(&path));
+  File file(path, File::FLAG_OPEN | File::FLAG_READ | File::FLAG_WRITE);
+  ASSERT_TRUE(file.IsValid());
+  std::string contents;
+  for (int i = 0; i < kFileSize; ++i) contents += static_cast<char>(i % 251);
+  ASSERT_EQ(kFileSize, file.Write(0, contents.data(), kFileSize));
+
+  EventLoop event_loop;
+  int fds[2];
+  ConnectLoopback(fds);
+  // A small send buffer makes SendFile() wait for the socket.
+  int buffer_size = 4096;
+  ASSERT_EQ(0, setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &buffer_size,
+                          sizeof(buffer_size)));
+  ASSERT_EQ(0, fcntl(fds[1], F_SETFL, O_NONBLOCK));
+  SocketPosix socket;
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], SockaddrStorage()));
+
+  // Asks for more than the file has, which sends up to the end of it.
+  int64_t result = ERR_IO_PENDING;
+  int64_t rv = socket.SendFile(file, kOffset, kFileSize,
+                               [&](int64_t rv) { result = rv; });
+  ASSERT_EQ(ERR_IO_PENDING, rv);
+
+  std::string received;
+  RepeatingTimer timer;
+  timer.Start(absl::Milliseconds(1), [&]() {
+    char buf[64 * 1024];
+    int rv;
+    while ((rv = recv(fds[1], buf, sizeof(buf), 0)) > 0)
+      received.append(buf, rv);
+    if (result != ERR_IO_PENDING &&
+        received.size() == static_cast<size_t>(kFileSize - kOffset)) {
+      event_loop.Quit();
+    }
+  });
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(kFileSize - kOffset, result);
+  EXPECT_EQ(contents.substr(kOffset), received);
+
+  socket.Close();
+  close(fds[1]);
+  file.Close();
+  DeleteFile(path);
+}
+#endif  // defined(OS_LINUX) || defined(OS_ANDROID)
+
+TEST(SocketPosixTest, AcceptMany) {
+  EventLoop event_loop;
+  SocketPosix listener;
+  ASSERT_EQ(OK, listener.Open(AF_INET));
+  SockaddrStorage storage;
+  sockaddr_in* address = reinterpret_cast<sockaddr_in*>(storage.addr);
+  address->sin_family = AF_INET;
+  address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  storage.addr_len = sizeof(*address);
+  ASSERT_EQ(OK, listener.Bind(storage));
+  ASSERT_EQ(OK, listener.Listen(16));
+  ASSERT_EQ(OK, listener.GetLocalAddress(&storage));
+
+  std::vector<int> clients;
+  auto connect_client = [&]() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(0, connect(fd, storage.addr, storage.addr_len));
+    clients.push_back(fd);
+  };
+  for (int i = 0; i < 5; ++i) connect_client();
+
+  // The backlog is drained |max_sockets| at a time.
+  std::vector<std::unique_ptr<SocketPosix>> sockets;
+  EXPECT_EQ(3, listener.AcceptMany(3, &sockets, [](int rv) { NOTREACHED(); }));
+  EXPECT_EQ(2, listener.AcceptMany(3, &sockets, [](int rv) { NOTREACHED(); }));
+  ASSERT_EQ(5u, sockets.size());
+  for (const std::unique_ptr<SocketPosix>& socket : sockets) {
+    EXPECT_TRUE(fcntl(socket->socket_fd(), F_GETFL) & O_NONBLOCK);
+    EXPECT_TRUE(socket->HasPeerAddress());
+  }
+
+  int result = ERR_IO_PENDING;
+  ASSERT_EQ(ERR_IO_PENDING, listener.AcceptMany(3, &sockets, [&](int rv) {
+    result = rv;
+    event_loop.Quit();
+  }));
+  event_loop.PostTask(connect_client);
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+  EXPECT_EQ(1, result);
+  EXPECT_EQ(6u, sockets.size());
+
+  for (int fd : clients) close(fd);
+}
+
+TEST(SocketPosixTest, TCPFastOpenConnect) {
+  EventLoop event_loop;
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_LE(0, listen_fd);
+  SockaddrStorage storage;
+  sockaddr_in* address = reinterpret_cast<sockaddr_in*>(storage.addr);
+  address->sin_family = AF_INET;
+  address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  storage.addr_len = sizeof(*address);
+  ASSERT_EQ(0, bind(listen_fd, storage.addr, storage.addr_len));
+  ASSERT_EQ(0, listen(listen_fd, 1));
+  ASSERT_EQ(0, getsockname(listen_fd, storage.addr, &storage.addr_len));
+
+  SocketPosix socket;
+  ASSERT_EQ(OK, socket.Open(AF_INET));
+  if (socket.EnableTCPFastOpenConnect() != OK) {
+    close(listen_fd);
+    return;
+  }
+  // The connect is only deferred to the first write once the kernel has a
+  // cookie from the server. Either way, the write gets through.
+  IdleDelegate delegate;
+  int result = ERR_IO_PENDING;
+  CompletionOnceCallback callback = [&](int rv) {
+    result = rv;
+    event_loop.Quit();
+  };
+  int rv = socket.Connect(storage, std::move(callback));
+  if (rv == ERR_IO_PENDING) {
+    event_loop.Run(&delegate);
+    rv = result;
+  }
+  ASSERT_EQ(OK, rv);
+
+  std::shared_ptr<IOBuffer> buf = std::make_shared<StringIOBuffer>("hello");
+  result = ERR_IO_PENDING;
+  rv = socket.Write(buf, 5, [&](int rv) {
+    result = rv;
+    event_loop.Quit();
+  });
+  if (rv == ERR_IO_PENDING) {
+    event_loop.Run(&delegate);
+    rv = result;
+  }
+  EXPECT_EQ(5, rv);
+
+  int fd = accept(listen_fd, nullptr, nullptr);
+  ASSERT_LE(0, fd);
+  char received[5];
+  ASSERT_EQ(5, recv(fd, received, sizeof(received), MSG_WAITALL));
+  EXPECT_EQ("hello", std::string(received, sizeof(received)));
+
+  socket.Close();
+  close(fd);
+  close(listen_fd);
+}
+
+}  // namespace base
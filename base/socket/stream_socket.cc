@@ -28,4 +28,10 @@ int StreamSocket::ConfirmHandshake(CompletionOnceCallback callback) {
   return OK;
 }
 
+int64_t StreamSocket::SendFile(const File& file, int64_t offset,
+                               int64_t length,
+                               Int64CompletionOnceCallback callback) {
+  return ERR_NOT_IMPLEMENTED;
+}
+
 }  // namespace base
@@ -17,6 +17,7 @@
 
 namespace base {
 
+class File;
 class IPEndPoint;
 
 class BASE_EXPORT StreamSocket : public Socket {
@@ -126,6 +127,16 @@ class BASE_EXPORT StreamSocket : public Socket {
   // Disconnect() is called.
   virtual int64_t GetTotalReceivedBytes() const = 0;
 
+  // Sends |length| bytes of |file| from |offset| on, without copying them
+  // through user space where the platform supports it. |file| must stay open
+  // until the transfer completes, and no Write() may be in progress meanwhile.
+  // Returns the number of bytes sent, which is less than |length| only if the
+  // file ends early, or a net error. If the socket buffer fills up, returns
+  // ERR_IO_PENDING and continues on the EventLoop, running |callback| with the
+  // result. The default implementation returns ERR_NOT_IMPLEMENTED.
+  virtual int64_t SendFile(const File& file, int64_t offset, int64_t length,
+                           Int64CompletionOnceCallback callback);
+
   // Dumps memory allocation stats into |stats|. |stats| can be assumed as being
   // default initialized upon entry. Implementations should override fields in
   // |stats|. Default implementation does nothing.
@@ -8,6 +8,7 @@
 
 #include "base/socket/tcp_client_socket.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "absl/functional/bind_front.h"
@@ -19,6 +20,31 @@
 
 namespace base {
 
+namespace {
+
+// Returns the indices of |addresses| alternating between the address families,
+// starting with the family of the first address, as in RFC 8305 section 4.
+std::vector<int> InterleaveAddressFamilies(const AddressList& addresses) {
+  std::vector<int> first_family;
+  std::vector<int> other_family;
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    if (addresses[i].GetFamily() == addresses[0].GetFamily())
+      first_family.push_back(static_cast<int>(i));
+    else
+      other_family.push_back(static_cast<int>(i));
+  }
+
+  std::vector<int> order;
+  for (size_t i = 0; i < std::max(first_family.size(), other_family.size());
+       ++i) {
+    if (i < first_family.size()) order.push_back(first_family[i]);
+    if (i < other_family.size()) order.push_back(other_family[i]);
+  }
+  return order;
+}
+
+}  // namespace
+
 TCPClientSocket::TCPClientSocket(const AddressList& addresses)
     : TCPClientSocket(std::make_unique<TCPSocket>(), addresses,
                       -1 /* current_address_index */,
@@ -49,7 +75,8 @@ int TCPClientSocket::Bind(const IPEndPoint& address) {
 
   int result = OK;
   if (!socket_->IsValid()) {
-    result = OpenSocket(address.GetFamily());
+    result = OpenSocket(socket_.get(), address.GetFamily(),
+                        true /* allow_fast_open */);
     if (result != OK) return result;
   }
 
@@ -80,6 +107,12 @@ int TCPClientSocket::Connect(CompletionOnceCallback callback) {
   // If connecting or already connected, then just return OK.
   if (socket_->IsValid() && current_address_index_ >= 0) return OK;
 
+  if (!connect_attempts_.empty() || attempt_delay_timer_.IsRunning()) {
+    // A racing Connect() is in progress, and its callback hasn't run yet.
+    NOTREACHED();
+    return ERR_UNEXPECTED;
+  }
+
   DCHECK(!read_callback_);
   DCHECK(!write_callback_);
 
@@ -88,6 +121,24 @@ int TCPClientSocket::Connect(CompletionOnceCallback callback) {
     was_disconnected_on_suspend_ = false;
   }
 
+  if (connect_attempt_delay_ > absl::ZeroDuration() && !bind_address_ &&
+      addresses_.size() > 1) {
+    if (previously_disconnected_) {
+      was_ever_used_ = false;
+      previously_disconnected_ = false;
+    }
+
+    attempt_order_ = InterleaveAddressFamilies(addresses_);
+    next_attempt_ = 0;
+    last_attempt_error_ = ERR_CONNECTION_FAILED;
+    int rv = DoRacingConnect();
+    if (rv == ERR_IO_PENDING) {
+      connect_callback_ = std::move(callback);
+    }
+
+    return rv;
+  }
+
   // We will try to connect to each address in addresses_. Start with the
   // first one in the list.
   next_connect_state_ = CONNECT_STATE_CONNECT;
@@ -113,6 +164,7 @@ TCPClientSocket::TCPClientSocket(std::unique_ptr<TCPSocket> socket,
       previously_disconnected_(false),
       total_received_bytes_(0),
       was_ever_used_(false),
+      last_attempt_error_(OK),
       was_disconnected_on_suspend_(false) {
   DCHECK(socket_);
   if (socket_->IsValid()) socket_->SetDefaultOptionsForClient();
@@ -186,7 +238,8 @@ int TCPClientSocket::DoConnect() {
   if (socket_->IsValid()) {
     DCHECK(bind_address_);
   } else {
-    int result = OpenSocket(endpoint.GetFamily());
+    int result = OpenSocket(socket_.get(), endpoint.GetFamily(),
+                            true /* allow_fast_open */);
     if (result != OK) return result;
 
     if (bind_address_) {
@@ -234,7 +287,103 @@ int TCPClientSocket::ConnectInternal(const IPEndPoint& endpoint) {
       endpoint, absl::bind_front(&TCPClientSocket::DidCompleteConnect, this));
 }
 
+int TCPClientSocket::DoRacingConnect() {
+  while (next_attempt_ < attempt_order_.size()) {
+    auto attempt = absl::make_unique<ConnectAttempt>();
+    attempt->socket = std::make_unique<TCPSocket>();
+    attempt->address_index = attempt_order_[next_attempt_++];
+    const IPEndPoint& endpoint = addresses_[attempt->address_index];
+
+    int rv = OpenSocket(attempt->socket.get(), endpoint.GetFamily(),
+                        false /* allow_fast_open */);
+    if (rv == OK && before_connect_callback_) {
+      // The callback configures the socket through |this|, so it has to see
+      // the socket of the attempt.
+      std::swap(socket_, attempt->socket);
+      rv = before_connect_callback_.Run();
+      std::swap(socket_, attempt->socket);
+      DCHECK_NE(ERR_IO_PENDING, rv);
+    }
+    if (rv == OK) {
+      // The attempt owns the socket and the callback won't be run once the
+      // attempt is gone.
+      rv = attempt->socket->Connect(
+          endpoint, absl::bind_front(&TCPClientSocket::OnAttemptComplete, this,
+                                     attempt.get()));
+    }
+
+    if (rv == OK) {
+      ConnectAttempt* winner = attempt.get();
+      connect_attempts_.push_back(std::move(attempt));
+      RacingConnectSucceeded(winner);
+      return OK;
+    }
+    if (rv == ERR_IO_PENDING) {
+      connect_attempts_.push_back(std::move(attempt));
+      if (next_attempt_ < attempt_order_.size()) {
+        attempt_delay_timer_.Start(connect_attempt_delay_, this,
+                                   &TCPClientSocket::OnAttemptDelayElapsed);
+      }
+      return ERR_IO_PENDING;
+    }
+
+    // Don't try the next address if entering suspend mode.
+    if (rv == ERR_NETWORK_IO_SUSPENDED && connect_attempts_.empty()) return rv;
+    last_attempt_error_ = rv;
+  }
+
+  return connect_attempts_.empty() ? last_attempt_error_ : ERR_IO_PENDING;
+}
+
+void TCPClientSocket::OnAttemptDelayElapsed() {
+  DCHECK(!connect_callback_.is_null());
+
+  int rv = DoRacingConnect();
+  if (rv != ERR_IO_PENDING) {
+    std::move(connect_callback_).Run(rv);
+  }
+}
+
+void TCPClientSocket::OnAttemptComplete(ConnectAttempt* attempt, int result) {
+  DCHECK_NE(result, ERR_IO_PENDING);
+  DCHECK(!connect_callback_.is_null());
+
+  if (result == OK) {
+    RacingConnectSucceeded(attempt);
+    std::move(connect_callback_).Run(OK);
+    return;
+  }
+
+  last_attempt_error_ = result;
+  connect_attempts_.erase(
+      std::find_if(connect_attempts_.begin(), connect_attempts_.end(),
+                   [attempt](const std::unique_ptr<ConnectAttempt>& other) {
+                     return other.get() == attempt;
+                   }));
+
+  // A failed attempt starts the next one right away.
+  attempt_delay_timer_.Stop();
+  int rv = DoRacingConnect();
+  if (rv != ERR_IO_PENDING) {
+    std::move(connect_callback_).Run(rv);
+  }
+}
+
+void TCPClientSocket::RacingConnectSucceeded(ConnectAttempt* attempt) {
+  socket_ = std::move(attempt->socket);
+  current_address_index_ = attempt->address_index;
+  CancelRacingConnect();
+}
+
+void TCPClientSocket::CancelRacingConnect() {
+  attempt_delay_timer_.Stop();
+  connect_attempts_.clear();
+  attempt_order_.clear();
+  next_attempt_ = 0;
+}
+
 void TCPClientSocket::Disconnect() {
+  CancelRacingConnect();
   DoDisconnect();
   current_address_index_ = -1;
   bind_address_.reset();
@@ -246,6 +395,7 @@ void TCPClientSocket::Disconnect() {
   connect_callback_.Reset();
   read_callback_.Reset();
   write_callback_.Reset();
+  send_file_callback_.Reset();
 }
 
 void TCPClientSocket::DoDisconnect() {
@@ -319,6 +469,83 @@ int TCPClientSocket::Write(std::shared_ptr<IOBuffer> buf, int buf_len,
   return result;
 }
 
+int64_t TCPClientSocket::SendFile(const File& file, int64_t offset,
+                                  int64_t length,
+                                  Int64CompletionOnceCallback callback) {
+  DCHECK(!callback.is_null());
+  DCHECK(send_file_callback_.is_null());
+
+  if (was_disconnected_on_suspend_) return ERR_NETWORK_IO_SUSPENDED;
+
+  // |socket_| is owned by this class and the callback won't be run once
+  // |socket_| is gone.
+  int64_t result = socket_->SendFile(
+      file, offset, length,
+      absl::bind_front(&TCPClientSocket::DidCompleteSendFile, this));
+  if (result == ERR_IO_PENDING) {
+    send_file_callback_ = std::move(callback);
+  } else if (result > 0) {
+    was_ever_used_ = true;
+  }
+
+  return result;
+}
+
+int TCPClientSocket::Readv(absl::Span<const IOBufferSlice> slices,
+                           CompletionOnceCallback callback) {
+  DCHECK(!callback.is_null());
+  DCHECK(read_callback_.is_null());
+
+  if (was_disconnected_on_suspend_) return ERR_NETWORK_IO_SUSPENDED;
+
+  // |socket_| is owned by this class and the callback won't be run once
+  // |socket_| is gone.
+  int result = socket_->Readv(
+      slices, absl::bind_front(&TCPClientSocket::DidCompleteRead, this));
+  if (result == ERR_IO_PENDING) {
+    read_callback_ = std::move(callback);
+  } else if (result > 0) {
+    was_ever_used_ = true;
+    total_received_bytes_ += result;
+  }
+
+  return result;
+}
+
+int TCPClientSocket::Writev(absl::Span<const IOBufferSlice> slices,
+                            CompletionOnceCallback callback) {
+  DCHECK(!callback.is_null());
+  DCHECK(write_callback_.is_null());
+
+  if (was_disconnected_on_suspend_) return ERR_NETWORK_IO_SUSPENDED;
+
+  // |socket_| is owned by this class and the callback won't be run once
+  // |socket_| is gone.
+  int result = socket_->Writev(
+      slices, absl::bind_front(&TCPClientSocket::DidCompleteWrite, this));
+  if (result == ERR_IO_PENDING) {
+    write_callback_ = std::move(callback);
+  } else if (result > 0) {
+    was_ever_used_ = true;
+  }
+
+  return result;
+}
+
+int TCPClientSocket::EnableKernelTLS(const KernelTLSKeys& tx,
+                                     const KernelTLSKeys& rx) {
+  if (!IsConnected()) return ERR_SOCKET_NOT_CONNECTED;
+
+  return socket_->EnableKernelTLS(tx, rx);
+}
+
+void TCPClientSocket::EnableTCPFastOpenIfSupported() { tcp_fast_open_ = true; }
+
+void TCPClientSocket::EnableRacingConnect(absl::Duration attempt_delay) {
+  DCHECK_GT(attempt_delay, absl::ZeroDuration());
+  connect_attempt_delay_ = attempt_delay;
+}
+
 int TCPClientSocket::SetReceiveBufferSize(int32_t size) {
   return socket_->SetReceiveBufferSize(size);
 }
@@ -355,19 +582,33 @@ void TCPClientSocket::DidCompleteWrite(int result) {
   DidCompleteReadWrite(std::move(write_callback_), result);
 }
 
+void TCPClientSocket::DidCompleteSendFile(int64_t result) {
+  DCHECK(!send_file_callback_.is_null());
+
+  if (result > 0) was_ever_used_ = true;
+  std::move(send_file_callback_).Run(result);
+}
+
 void TCPClientSocket::DidCompleteReadWrite(CompletionOnceCallback callback,
                                            int result) {
   if (result > 0) was_ever_used_ = true;
   std::move(callback).Run(result);
 }
 
-int TCPClientSocket::OpenSocket(AddressFamily family) {
-  DCHECK(!socket_->IsValid());
+int TCPClientSocket::OpenSocket(TCPSocket* socket, AddressFamily family,
+                                bool allow_fast_open) {
+  DCHECK(!socket->IsValid());
 
-  int result = socket_->Open(family);
+  int result = socket->Open(family);
   if (result != OK) return result;
 
-  socket_->SetDefaultOptionsForClient();
+  socket->SetDefaultOptionsForClient();
+
+  if (tcp_fast_open_ && allow_fast_open) {
+    // Not fatal, since the first write then waits for the handshake anyway.
+    int rv = socket->EnableTCPFastOpenConnect();
+    if (rv != OK) DVLOG(1) << "Failed to enable TCP Fast Open: " << rv;
+  }
 
   return OK;
 }
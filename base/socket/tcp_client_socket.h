@@ -12,7 +12,10 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "base/build_config.h"
 #include "base/compiler_specific.h"
 #include "base/completion_once_callback.h"
@@ -22,10 +25,13 @@
 #include "base/socket/stream_socket.h"
 #include "base/socket/tcp_socket.h"
 #include "base/socket/transport_client_socket.h"
+#include "base/timer/timer.h"
 
 namespace base {
 
 class IPEndPoint;
+struct IOBufferSlice;
+struct KernelTLSKeys;
 
 // A client socket that uses TCP as the transport layer.
 class BASE_EXPORT TCPClientSocket : public TransportClientSocket {
@@ -55,6 +61,26 @@ class BASE_EXPORT TCPClientSocket : public TransportClientSocket {
   bool SetKeepAlive(bool enable, int delay) override;
   bool SetNoDelay(bool no_delay) override;
 
+  // Makes Connect() complete right away, and the first Write() or Writev()
+  // send its data in the SYN if the server has handed out a TCP Fast Open
+  // cookie on an earlier connection, which saves a round trip. Otherwise the
+  // first write waits for a regular handshake. Only meant for requests which
+  // are safe to replay, since the SYN may be retransmitted. Does nothing where
+  // TCP_FASTOPEN_CONNECT is unsupported, nor for the attempts of a racing
+  // Connect(), whose first attempt would otherwise win right away whether its
+  // address answers or not. Must be called before Connect().
+  void EnableTCPFastOpenIfSupported();
+
+  // Makes Connect() race the addresses instead of trying them one after
+  // another, as in RFC 8305 ("Happy Eyeballs"). The attempts alternate between
+  // IPv6 and IPv4, starting with the family of the first address, and the
+  // next one starts after |attempt_delay|, or as soon as an attempt fails.
+  // The first attempt to connect wins and the others are canceled. RFC 8305
+  // recommends 250ms. Sockets bound with Bind() still connect one address
+  // after another. Must be called before Connect(), and Connect() must not be
+  // called again until it completes.
+  void EnableRacingConnect(absl::Duration attempt_delay);
+
   // StreamSocket implementation.
   void SetBeforeConnectCallback(
       const BeforeConnectCallback& before_connect_callback) override;
@@ -77,9 +103,24 @@ class BASE_EXPORT TCPClientSocket : public TransportClientSocket {
   int CancelReadIfReady() override;
   int Write(std::shared_ptr<IOBuffer> buf, int buf_len,
             CompletionOnceCallback callback) override;
+  int64_t SendFile(const File& file, int64_t offset, int64_t length,
+                   Int64CompletionOnceCallback callback) override;
   int SetReceiveBufferSize(int32_t size) override;
   int SetSendBufferSize(int32_t size) override;
 
+  // Vectored I/O, e.g. to send a header and a body without copying them into
+  // one IOBuffer. Writev() only completes once all of |slices| is written.
+  // See SocketPosix::Readv() and SocketPosix::Writev().
+  int Readv(absl::Span<const IOBufferSlice> slices,
+            CompletionOnceCallback callback);
+  int Writev(absl::Span<const IOBufferSlice> slices,
+             CompletionOnceCallback callback);
+
+  // Hands the TLS record layer over to the kernel once the handshake over this
+  // socket is done. See SetKernelTLS() in socket_options.h and
+  // KernelTLSSocket.
+  int EnableKernelTLS(const KernelTLSKeys& tx, const KernelTLSKeys& rx);
+
  private:
   // State machine for connecting the socket.
   enum ConnectState {
@@ -115,11 +156,31 @@ class BASE_EXPORT TCPClientSocket : public TransportClientSocket {
   void DoDisconnect();
 
   void DidCompleteConnect(int result);
+
+  // An attempt of a racing Connect().
+  struct ConnectAttempt {
+    std::unique_ptr<TCPSocket> socket;
+    int address_index;
+  };
+
+  // Starts the next attempts of a racing Connect() until one is pending, or
+  // there are no more addresses. Returns OK if an attempt connected right away,
+  // ERR_IO_PENDING if attempts are in flight, or the last error otherwise.
+  int DoRacingConnect();
+  void OnAttemptDelayElapsed();
+  void OnAttemptComplete(ConnectAttempt* attempt, int result);
+  // Makes |attempt| the connected socket and cancels the other attempts.
+  void RacingConnectSucceeded(ConnectAttempt* attempt);
+  void CancelRacingConnect();
+
   void DidCompleteRead(int result);
   void DidCompleteWrite(int result);
+  void DidCompleteSendFile(int64_t result);
   void DidCompleteReadWrite(CompletionOnceCallback callback, int result);
 
-  int OpenSocket(AddressFamily family);
+  // Opens |socket| with the client options, and TCP_FASTOPEN_CONNECT if it
+  // is enabled and |allow_fast_open|.
+  int OpenSocket(TCPSocket* socket, AddressFamily family, bool allow_fast_open);
 
   std::unique_ptr<TCPSocket> socket_;
 
@@ -138,6 +199,7 @@ class BASE_EXPORT TCPClientSocket : public TransportClientSocket {
   CompletionOnceCallback connect_callback_;
   CompletionOnceCallback read_callback_;
   CompletionOnceCallback write_callback_;
+  Int64CompletionOnceCallback send_file_callback_;
 
   // The next state for the Connect() state machine.
   ConnectState next_connect_state_;
@@ -152,6 +214,21 @@ class BASE_EXPORT TCPClientSocket : public TransportClientSocket {
 
   bool was_ever_used_;
 
+  // Set TCP_FASTOPEN_CONNECT on every socket that is opened.
+  bool tcp_fast_open_ = false;
+
+  // Zero unless Connect() races the addresses.
+  absl::Duration connect_attempt_delay_;
+  // The indices into |addresses_| in the order they are raced, the next of
+  // which is at |next_attempt_|.
+  std::vector<int> attempt_order_;
+  size_t next_attempt_ = 0;
+  // The attempts in flight.
+  std::vector<std::unique_ptr<ConnectAttempt>> connect_attempts_;
+  // The error of the last attempt which failed.
+  int last_attempt_error_;
+  OneShotTimer attempt_delay_timer_;
+
   // Set to true if the socket was disconnected due to entering suspend mode.
   // Once set, read/write operations return ERR_NETWORK_IO_SUSPENDED, until
   // Connect() or Disconnect() is called.
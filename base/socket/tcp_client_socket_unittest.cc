@@ -0,0 +1,103 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/tcp_client_socket.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "absl/time/time.h"
+#include "base/event_loop/event_loop.h"
+#include "base/socket/address_list.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/socket_errors.h"
+#include "base/test/socket_test_util.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(TCPClientSocketTest, RacingConnectSkipsUnresponsiveAddress) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  // A listener whose backlog is full drops the SYNs of further connections.
+  IPEndPoint unresponsive;
+  int unresponsive_fd = BindLoopback(0, &unresponsive);
+  int filler_fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_LE(0, filler_fd);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(unresponsive.port());
+  ASSERT_EQ(0, connect(filler_fd, reinterpret_cast<sockaddr*>(&address),
+                       sizeof(address)));
+
+  IPEndPoint responsive;
+  int responsive_fd = BindLoopback(1, &responsive);
+
+  TCPClientSocket client(
+      AddressList(std::vector<IPEndPoint>{unresponsive, responsive}));
+  client.EnableRacingConnect(absl::Milliseconds(10));
+  // Racing attempts leave TCP Fast Open out, which would otherwise let the
+  // first one connect right away once the kernel has a cookie.
+  client.EnableTCPFastOpenIfSupported();
+
+  int result = ERR_IO_PENDING;
+  ASSERT_EQ(ERR_IO_PENDING, client.Connect([&](int rv) {
+    result = rv;
+    event_loop.Quit();
+  }));
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(OK, result);
+  EXPECT_TRUE(client.IsConnected());
+  IPEndPoint peer;
+  ASSERT_EQ(OK, client.GetPeerAddress(&peer));
+  EXPECT_EQ(responsive, peer);
+
+  client.Disconnect();
+  close(filler_fd);
+  close(unresponsive_fd);
+  close(responsive_fd);
+}
+
+TEST(TCPClientSocketTest, RacingConnectFallsBackOnError) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  // Nothing listens on a port which is only bound.
+  IPEndPoint refused;
+  int refused_fd = BindLoopback(-1, &refused);
+  IPEndPoint responsive;
+  int responsive_fd = BindLoopback(1, &responsive);
+
+  TCPClientSocket client(
+      AddressList(std::vector<IPEndPoint>{refused, responsive}));
+  // Long enough that only the failure can start the second attempt in time.
+  client.EnableRacingConnect(absl::Seconds(60));
+
+  int result = ERR_IO_PENDING;
+  int rv = client.Connect([&](int rv) {
+    result = rv;
+    event_loop.Quit();
+  });
+  if (rv == ERR_IO_PENDING)
+    event_loop.Run(&delegate);
+  else
+    result = rv;
+
+  EXPECT_EQ(OK, result);
+  IPEndPoint peer;
+  ASSERT_EQ(OK, client.GetPeerAddress(&peer));
+  EXPECT_EQ(responsive, peer);
+
+  client.Disconnect();
+  close(refused_fd);
+  close(responsive_fd);
+}
+
+}  // namespace base
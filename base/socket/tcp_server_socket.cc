@@ -30,6 +30,13 @@ int TCPServerSocket::AdoptSocket(SocketDescriptor socket) {
 
 TCPServerSocket::~TCPServerSocket() = default;
 
+void TCPServerSocket::AllowPortReuse() { allow_port_reuse_ = true; }
+
+void TCPServerSocket::EnableTCPFastOpen(int queue_length) {
+  DCHECK_LT(0, queue_length);
+  tcp_fast_open_queue_length_ = queue_length;
+}
+
 int TCPServerSocket::Listen(const IPEndPoint& address, int backlog) {
   int result = socket_->Open(address.GetFamily());
   if (result != OK) return result;
@@ -40,12 +47,26 @@ int TCPServerSocket::Listen(const IPEndPoint& address, int backlog) {
     return result;
   }
 
+  if (allow_port_reuse_) {
+    result = socket_->AllowPortReuse();
+    if (result != OK) {
+      socket_->Close();
+      return result;
+    }
+  }
+
   result = socket_->Bind(address);
   if (result != OK) {
     socket_->Close();
     return result;
   }
 
+  if (tcp_fast_open_queue_length_ > 0) {
+    // Not fatal, since the clients fall back to a regular handshake.
+    result = socket_->EnableTCPFastOpen(tcp_fast_open_queue_length_);
+    if (result != OK) DVLOG(1) << "Failed to enable TCP Fast Open: " << result;
+  }
+
   result = socket_->Listen(backlog);
   if (result != OK) {
     socket_->Close();
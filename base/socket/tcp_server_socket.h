@@ -39,6 +39,21 @@ class BASE_EXPORT TCPServerSocket : public ServerSocket {
   // to be accepted, but must not be actually connected.
   int AdoptSocket(SocketDescriptor socket);
 
+  // Makes Listen() set SO_REUSEPORT, so that a TCPServerSocket can listen on
+  // the same end point on each EventLoop of an EventLoopGroup. The kernel then
+  // spreads the incoming connections across them, and each accepts on its own
+  // thread without sharing a lock. To listen on an ephemeral port, the first
+  // socket listens on port 0 and the others on its GetLocalAddress(). Must be
+  // called before Listen().
+  void AllowPortReuse();
+
+  // Makes Listen() set TCP_FASTOPEN, so that clients which have a Fast Open
+  // cookie can send their first request in the SYN. Up to |queue_length|
+  // connections may wait for the handshake to complete. Clients without a
+  // cookie, or a kernel without support, fall back to a regular handshake.
+  // Must be called before Listen().
+  void EnableTCPFastOpen(int queue_length);
+
   // net::ServerSocket implementation.
   int Listen(const IPEndPoint& address, int backlog) override;
   int GetLocalAddress(IPEndPoint* address) const override;
@@ -57,6 +72,8 @@ class BASE_EXPORT TCPServerSocket : public ServerSocket {
                          int result);
 
   std::unique_ptr<TCPSocket> socket_;
+  bool allow_port_reuse_ = false;
+  int tcp_fast_open_queue_length_ = 0;
 
   std::unique_ptr<TCPSocket> accepted_socket_;
   IPEndPoint accepted_address_;
@@ -0,0 +1,41 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/tcp_server_socket.h"
+
+#include "base/event_loop/event_loop.h"
+#include "base/socket/ip_address.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/socket_errors.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(TCPServerSocketTest, AllowPortReuse) {
+  EventLoop event_loop;
+  TCPServerSocket first_socket;
+  first_socket.AllowPortReuse();
+  ASSERT_EQ(OK, first_socket.Listen(
+                    IPEndPoint(IPAddress::IPv4Localhost(), 0), 1));
+  IPEndPoint address;
+  ASSERT_EQ(OK, first_socket.GetLocalAddress(&address));
+
+  TCPServerSocket second_socket;
+  second_socket.AllowPortReuse();
+  EXPECT_EQ(OK, second_socket.Listen(address, 1));
+}
+
+TEST(TCPServerSocketTest, ListenOnUsedPort) {
+  EventLoop event_loop;
+  TCPServerSocket first_socket;
+  ASSERT_EQ(OK, first_socket.Listen(
+                    IPEndPoint(IPAddress::IPv4Localhost(), 0), 1));
+  IPEndPoint address;
+  ASSERT_EQ(OK, first_socket.GetLocalAddress(&address));
+
+  TCPServerSocket second_socket;
+  EXPECT_EQ(ERR_ADDRESS_IN_USE, second_socket.Listen(address, 1));
+}
+
+}  // namespace base
@@ -185,6 +185,26 @@ int TCPSocketPosix::Accept(std::unique_ptr<TCPSocketPosix>* tcp_socket,
   return rv;
 }
 
+int TCPSocketPosix::AcceptMany(
+    size_t max_sockets, std::vector<std::unique_ptr<TCPSocketPosix>>* sockets,
+    CompletionOnceCallback callback) {
+  DCHECK(sockets);
+  DCHECK(!callback.is_null());
+  DCHECK(accept_callback_.is_null());
+  DCHECK(socket_);
+  DCHECK(accept_sockets_.empty());
+
+  int rv = socket_->AcceptMany(
+      max_sockets, &accept_sockets_,
+      absl::bind_front(&TCPSocketPosix::AcceptManyCompleted, this, sockets));
+  if (rv == ERR_IO_PENDING) {
+    accept_callback_ = std::move(callback);
+  } else {
+    rv = HandleAcceptManyCompleted(sockets, rv);
+  }
+  return rv;
+}
+
 int TCPSocketPosix::Connect(const IPEndPoint& address,
                             CompletionOnceCallback callback) {
   DCHECK(socket_);
@@ -234,6 +254,31 @@ int TCPSocketPosix::Write(std::shared_ptr<IOBuffer> buf, int buf_len,
   return socket_->Write(buf, buf_len, std::move(callback));
 }
 
+int TCPSocketPosix::Readv(absl::Span<const IOBufferSlice> slices,
+                          CompletionOnceCallback callback) {
+  DCHECK(socket_);
+  DCHECK(!callback.is_null());
+
+  return socket_->Readv(slices, std::move(callback));
+}
+
+int TCPSocketPosix::Writev(absl::Span<const IOBufferSlice> slices,
+                           CompletionOnceCallback callback) {
+  DCHECK(socket_);
+  DCHECK(!callback.is_null());
+
+  return socket_->Writev(slices, std::move(callback));
+}
+
+int64_t TCPSocketPosix::SendFile(const File& file, int64_t offset,
+                                 int64_t length,
+                                 Int64CompletionOnceCallback callback) {
+  DCHECK(socket_);
+  DCHECK(!callback.is_null());
+
+  return socket_->SendFile(file, offset, length, std::move(callback));
+}
+
 int TCPSocketPosix::GetLocalAddress(IPEndPoint* address) const {
   DCHECK(address);
 
@@ -301,6 +346,43 @@ int TCPSocketPosix::AllowAddressReuse() {
   return SetReuseAddr(socket_->socket_fd(), true);
 }
 
+int TCPSocketPosix::AllowPortReuse() {
+  DCHECK(socket_);
+
+  return SetReusePort(socket_->socket_fd(), true);
+}
+
+int TCPSocketPosix::SetBusyPoll(absl::Duration duration) {
+  DCHECK(socket_);
+
+  return base::SetBusyPoll(socket_->socket_fd(), duration);
+}
+
+int TCPSocketPosix::EnableTCPFastOpenConnect() {
+  DCHECK(socket_);
+
+  return socket_->EnableTCPFastOpenConnect();
+}
+
+int TCPSocketPosix::EnableTCPFastOpen(int queue_length) {
+  DCHECK(socket_);
+
+  return SetTCPFastOpen(socket_->socket_fd(), queue_length);
+}
+
+int TCPSocketPosix::EnableZeroCopy(size_t min_size) {
+  DCHECK(socket_);
+
+  return socket_->EnableZeroCopy(min_size);
+}
+
+int TCPSocketPosix::EnableKernelTLS(const KernelTLSKeys& tx,
+                                    const KernelTLSKeys& rx) {
+  DCHECK(socket_);
+
+  return SetKernelTLS(socket_->socket_fd(), tx, rx);
+}
+
 int TCPSocketPosix::SetReceiveBufferSize(int32_t size) {
   DCHECK(socket_);
 
@@ -325,7 +407,10 @@ bool TCPSocketPosix::SetNoDelay(bool no_delay) {
   return SetTCPNoDelay(socket_->socket_fd(), no_delay) == OK;
 }
 
-void TCPSocketPosix::Close() { socket_.reset(); }
+void TCPSocketPosix::Close() {
+  tcp_info_timer_.Stop();
+  socket_.reset();
+}
 
 bool TCPSocketPosix::IsValid() const {
   return socket_ != NULL && socket_->socket_fd() != kInvalidSocket;
@@ -345,6 +430,24 @@ int TCPSocketPosix::HandleAcceptCompleted(
   return rv;
 }
 
+void TCPSocketPosix::AcceptManyCompleted(
+    std::vector<std::unique_ptr<TCPSocketPosix>>* tcp_sockets, int rv) {
+  DCHECK(!accept_callback_.is_null());
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  std::move(accept_callback_).Run(HandleAcceptManyCompleted(tcp_sockets, rv));
+}
+
+int TCPSocketPosix::HandleAcceptManyCompleted(
+    std::vector<std::unique_ptr<TCPSocketPosix>>* tcp_sockets, int rv) {
+  for (std::unique_ptr<SocketPosix>& socket : accept_sockets_) {
+    std::unique_ptr<TCPSocketPosix> tcp_socket(new TCPSocketPosix());
+    tcp_socket->socket_ = std::move(socket);
+    tcp_sockets->push_back(std::move(tcp_socket));
+  }
+  accept_sockets_.clear();
+  return rv;
+}
+
 int TCPSocketPosix::BuildTcpSocketPosix(
     std::unique_ptr<TCPSocketPosix>* tcp_socket, IPEndPoint* address) {
   DCHECK(accept_socket_);
@@ -374,4 +477,42 @@ bool TCPSocketPosix::GetEstimatedRoundTripTime(absl::Duration* out_rtt) const {
   return false;
 }
 
+int TCPSocketPosix::GetTCPInfo(TCPInfo* info) const {
+  if (!socket_) return ERR_SOCKET_NOT_CONNECTED;
+
+  return base::GetTCPInfo(socket_->socket_fd(), info);
+}
+
+void TCPSocketPosix::StartTCPInfoSampling(absl::Duration interval) {
+  DCHECK(socket_);
+  DCHECK_GT(interval, absl::ZeroDuration());
+
+  tcp_info_stats_.reset(new TCPInfoStats());
+  tcp_info_timer_.Start(interval, this, &TCPSocketPosix::SampleTCPInfo);
+}
+
+void TCPSocketPosix::StopTCPInfoSampling() { tcp_info_timer_.Stop(); }
+
+TCPInfoStats TCPSocketPosix::GetTCPInfoStats() const {
+  return tcp_info_stats_ ? *tcp_info_stats_ : TCPInfoStats();
+}
+
+void TCPSocketPosix::SampleTCPInfo() {
+  TCPInfo info;
+  if (GetTCPInfo(&info) != OK) return;
+
+  TCPInfoStats* stats = tcp_info_stats_.get();
+  if (stats->rtt.count() > 0) {
+    stats->retransmits.Add(info.total_retransmits -
+                           stats->last.total_retransmits);
+  }
+  stats->rtt.Add(absl::ToInt64Microseconds(info.rtt));
+  stats->min_rtt.Add(absl::ToInt64Microseconds(info.min_rtt));
+  stats->congestion_window.Add(info.congestion_window);
+  stats->bytes_in_flight.Add(info.bytes_in_flight);
+  stats->delivery_rate.Add(info.delivery_rate);
+  if (info.pacing_rate != UINT64_MAX) stats->pacing_rate.Add(info.pacing_rate);
+  stats->last = info;
+}
+
 }  // namespace base
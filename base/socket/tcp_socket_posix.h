@@ -12,21 +12,47 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/completion_once_callback.h"
+#include "base/event_loop/event_loop_stats.h"
 #include "base/export.h"
 #include "base/socket/address_family.h"
 #include "base/socket/socket_descriptor.h"
+#include "base/socket/socket_options.h"
+#include "base/timer/timer.h"
 
 namespace base {
 
 class AddressList;
+class File;
 class IOBuffer;
 class IPEndPoint;
 class SocketPosix;
+struct IOBufferSlice;
+
+// What TCPSocketPosix::StartTCPInfoSampling() records, one value per sample.
+// The histograms of durations are in microseconds, and those of rates in
+// bytes per second.
+struct BASE_EXPORT TCPInfoStats {
+  Log2Histogram rtt;
+  Log2Histogram min_rtt;
+  // In segments.
+  Log2Histogram congestion_window;
+  Log2Histogram bytes_in_flight;
+  Log2Histogram delivery_rate;
+  // Leaves out the samples where the connection isn't paced.
+  Log2Histogram pacing_rate;
+  // The segments retransmitted since the previous sample.
+  Log2Histogram retransmits;
+
+  // The most recent sample.
+  TCPInfo last;
+};
 
 class BASE_EXPORT TCPSocketPosix {
  public:
@@ -62,6 +88,14 @@ class BASE_EXPORT TCPSocketPosix {
   // Returns a net error code.
   int Accept(std::unique_ptr<TCPSocketPosix>* socket, IPEndPoint* address,
              CompletionOnceCallback callback);
+  // Accepts up to |max_sockets| incoming connections at once and appends them
+  // to |sockets|, which is cheaper than one Accept() each under a burst of
+  // connections. Their peers are available from GetPeerAddress(). Returns
+  // the number of accepted sockets or a net error code. See
+  // SocketPosix::AcceptMany().
+  int AcceptMany(size_t max_sockets,
+                 std::vector<std::unique_ptr<TCPSocketPosix>>* sockets,
+                 CompletionOnceCallback callback);
 
   // Connects this socket to the given |address|.
   // Should be called after Open().
@@ -87,6 +121,16 @@ class BASE_EXPORT TCPSocketPosix {
   int Write(std::shared_ptr<IOBuffer> buf, int buf_len,
             CompletionOnceCallback callback);
 
+  // Vectored I/O. See SocketPosix::Readv() and SocketPosix::Writev().
+  int Readv(absl::Span<const IOBufferSlice> slices,
+            CompletionOnceCallback callback);
+  int Writev(absl::Span<const IOBufferSlice> slices,
+             CompletionOnceCallback callback);
+
+  // Sends a part of |file|. See SocketPosix::SendFile().
+  int64_t SendFile(const File& file, int64_t offset, int64_t length,
+                   Int64CompletionOnceCallback callback);
+
   // Copies the local tcp address into |address| and returns a net error code.
   int GetLocalAddress(IPEndPoint* address) const;
 
@@ -102,16 +146,49 @@ class BASE_EXPORT TCPSocketPosix {
   // - SetKeepAlive(true, 45).
   void SetDefaultOptionsForClient();
   int AllowAddressReuse();
+  // Sets SO_REUSEPORT, so that several sockets can listen on the same end
+  // point. Must be called before Bind().
+  int AllowPortReuse();
   int SetReceiveBufferSize(int32_t size);
   int SetSendBufferSize(int32_t size);
   bool SetKeepAlive(bool enable, int delay);
   bool SetNoDelay(bool no_delay);
+  // Sets SO_BUSY_POLL. See SetBusyPoll() in socket_options.h.
+  int SetBusyPoll(absl::Duration duration);
+  // Sets TCP_FASTOPEN_CONNECT before Connect(). See
+  // SocketPosix::EnableTCPFastOpenConnect().
+  int EnableTCPFastOpenConnect();
+  // Sets TCP_FASTOPEN on a server socket before Listen(). See SetTCPFastOpen()
+  // in socket_options.h.
+  int EnableTCPFastOpen(int queue_length);
+  // Sends writes of at least |min_size| bytes with MSG_ZEROCOPY. See
+  // SocketPosix::EnableZeroCopy().
+  int EnableZeroCopy(size_t min_size);
+  // Hands the TLS record layer of a connected socket over to the kernel. See
+  // SetKernelTLS() in socket_options.h.
+  int EnableKernelTLS(const KernelTLSKeys& tx, const KernelTLSKeys& rx);
 
   // Gets the estimated RTT. Returns false if the RTT is
   // unavailable. May also return false when estimated RTT is 0.
   bool GetEstimatedRoundTripTime(absl::Duration* out_rtt) const
       WARN_UNUSED_RESULT;
 
+  // Sets |*info| to the state of the connection: RTT, congestion window,
+  // retransmits, bytes in flight, delivery and pacing rates. See GetTCPInfo()
+  // in socket_options.h. Returns a net error code.
+  int GetTCPInfo(TCPInfo* info) const;
+
+  // Starts recording TCPInfoStats from scratch, sampling GetTCPInfo() every
+  // |interval| on the current EventLoop until StopTCPInfoSampling() or
+  // Close(). The stats outlive the sampling, so that the history of a
+  // connection whose throughput collapsed can be looked at afterwards.
+  void StartTCPInfoSampling(absl::Duration interval);
+  void StopTCPInfoSampling();
+
+  // Returns a snapshot of the stats, which are empty unless sampling has been
+  // started.
+  TCPInfoStats GetTCPInfoStats() const;
+
   // Closes the socket.
   void Close();
 
@@ -124,10 +201,21 @@ class BASE_EXPORT TCPSocketPosix {
                             IPEndPoint* address, int rv);
   int BuildTcpSocketPosix(std::unique_ptr<TCPSocketPosix>* tcp_socket,
                           IPEndPoint* address);
+  void AcceptManyCompleted(
+      std::vector<std::unique_ptr<TCPSocketPosix>>* tcp_sockets, int rv);
+  // Moves |accept_sockets_| into |tcp_sockets|.
+  int HandleAcceptManyCompleted(
+      std::vector<std::unique_ptr<TCPSocketPosix>>* tcp_sockets, int rv);
+
+  void SampleTCPInfo();
 
   std::unique_ptr<SocketPosix> socket_;
   std::unique_ptr<SocketPosix> accept_socket_;
+  std::vector<std::unique_ptr<SocketPosix>> accept_sockets_;
   CompletionOnceCallback accept_callback_;
+
+  std::unique_ptr<TCPInfoStats> tcp_info_stats_;
+  RepeatingTimer tcp_info_timer_;
 };
 
 }  // namespace base
@@ -0,0 +1,65 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/socket/tcp_socket_posix.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "absl/time/time.h"
+#include "base/event_loop/event_loop.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/socket_errors.h"
+#include "base/test/socket_test_util.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(TCPSocketPosixTest, GetTCPInfo) {
+  TCPSocketPosix socket;
+  TCPInfo info;
+  EXPECT_EQ(ERR_SOCKET_NOT_CONNECTED, socket.GetTCPInfo(&info));
+
+  int fds[2];
+  ConnectLoopback(fds);
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], IPEndPoint()));
+  ASSERT_EQ(1, send(fds[0], "x", 1, 0));
+  char c;
+  ASSERT_EQ(1, recv(fds[1], &c, 1, 0));
+
+  ASSERT_EQ(OK, socket.GetTCPInfo(&info));
+  EXPECT_LT(0u, info.congestion_window);
+  EXPECT_LT(0u, info.mss);
+  EXPECT_EQ(0u, info.retransmits);
+  close(fds[1]);
+}
+
+TEST(TCPSocketPosixTest, TCPInfoSampling) {
+  EventLoop event_loop;
+  int fds[2];
+  ConnectLoopback(fds);
+  TCPSocketPosix socket;
+  ASSERT_EQ(OK, socket.AdoptConnectedSocket(fds[0], IPEndPoint()));
+  EXPECT_EQ(0u, socket.GetTCPInfoStats().rtt.count());
+
+  socket.StartTCPInfoSampling(absl::Milliseconds(1));
+  RunEventLoopUntil(
+      [&socket]() { return socket.GetTCPInfoStats().rtt.count() >= 3; });
+  socket.StopTCPInfoSampling();
+
+  TCPInfoStats stats = socket.GetTCPInfoStats();
+  EXPECT_LE(3u, stats.rtt.count());
+  EXPECT_EQ(stats.rtt.count(), stats.congestion_window.count());
+  EXPECT_EQ(stats.rtt.count(), stats.bytes_in_flight.count());
+  // The first sample has nothing to compare with.
+  EXPECT_EQ(stats.rtt.count() - 1, stats.retransmits.count());
+  EXPECT_EQ(0u, stats.retransmits.sum());
+  EXPECT_LT(0u, stats.last.congestion_window);
+
+  socket.Close();
+  EXPECT_EQ(stats.rtt.count(), socket.GetTCPInfoStats().rtt.count());
+  close(fds[1]);
+}
+
+}  // namespace base
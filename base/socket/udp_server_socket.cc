@@ -18,7 +18,8 @@ UDPServerSocket::UDPServerSocket()
     : socket_(DatagramSocket::DEFAULT_BIND),
       allow_address_reuse_(false),
       allow_broadcast_(false),
-      allow_address_sharing_for_multicast_(false) {}
+      allow_address_sharing_for_multicast_(false),
+      allow_port_reuse_(false) {}
 
 UDPServerSocket::~UDPServerSocket() = default;
 
@@ -50,6 +51,14 @@ int UDPServerSocket::Listen(const IPEndPoint& address) {
     }
   }
 
+  if (allow_port_reuse_) {
+    rv = socket_.AllowPortReuse();
+    if (rv != OK) {
+      socket_.Close();
+      return rv;
+    }
+  }
+
   return socket_.Bind(address);
 }
 
@@ -97,6 +106,8 @@ void UDPServerSocket::AllowAddressSharingForMulticast() {
   allow_address_sharing_for_multicast_ = true;
 }
 
+void UDPServerSocket::AllowPortReuse() { allow_port_reuse_ = true; }
+
 int UDPServerSocket::JoinGroup(const IPAddress& group_address) const {
   return socket_.JoinGroup(group_address);
 }
@@ -47,6 +47,12 @@ class BASE_EXPORT UDPServerSocket : public DatagramServerSocket {
   void AllowAddressReuse() override;
   void AllowBroadcast() override;
   void AllowAddressSharingForMulticast() override;
+
+  // Makes Listen() set SO_REUSEPORT, so that a UDPServerSocket can be bound
+  // to the same end point on each EventLoop of an EventLoopGroup. The kernel
+  // then spreads the incoming datagrams across them by source address. Must
+  // be called before Listen().
+  void AllowPortReuse();
   int JoinGroup(const IPAddress& group_address) const override;
   int LeaveGroup(const IPAddress& group_address) const override;
   int SetMulticastInterface(uint32_t interface_index) override;
@@ -59,6 +65,7 @@ class BASE_EXPORT UDPServerSocket : public DatagramServerSocket {
   bool allow_address_reuse_;
   bool allow_broadcast_;
   bool allow_address_sharing_for_multicast_;
+  bool allow_port_reuse_;
 };
 
 }  // namespace base
@@ -15,6 +15,7 @@
 #include <netinet/in.h>
 #include <sys/ioctl.h>
 
+#include "absl/functional/bind_front.h"
 #include "absl/random/random.h"
 #include "base/build_config.h"
 #include "base/callback.h"
@@ -279,6 +280,8 @@ void UDPSocketPosix::Close() {
   write_callback_.Reset();
   send_to_address_.reset();
 
+  read_operation_.Cancel();
+  write_operation_.Cancel();
   bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
   DCHECK(ok);
   ok = write_socket_watcher_.StopWatchingFileDescriptor();
@@ -297,7 +300,8 @@ void UDPSocketPosix::Close() {
   addr_family_ = 0;
   is_connected_ = false;
 
-  // write_async_timer_.Stop();
+  write_async_timer_.Stop();
+  write_async_timer_running_ = false;
 }
 
 int UDPSocketPosix::GetPeerAddress(IPEndPoint* address) const {
@@ -350,6 +354,18 @@ int UDPSocketPosix::RecvFrom(std::shared_ptr<IOBuffer> buf, int buf_len,
   DCHECK(!callback.is_null());  // Synchronous operation not supported
   DCHECK_GT(buf_len, 0);
 
+  EventLoop* event_loop = EventLoop::Current();
+  if (event_loop->SupportsCompletionIo()) {
+    read_buf_ = buf;
+    read_buf_len_ = buf_len;
+    recv_from_address_ = address;
+    read_callback_ = std::move(callback);
+    event_loop->SubmitRecvMsg(
+        socket_, std::move(buf), buf_len, 0, &read_operation_,
+        absl::bind_front(&UDPSocketPosix::DidCompleteRecvMsg, this));
+    return ERR_IO_PENDING;
+  }
+
   int nread = InternalRecvFrom(buf.get(), buf_len, address);
   if (nread != ERR_IO_PENDING) return nread;
 
@@ -386,6 +402,28 @@ int UDPSocketPosix::SendToOrWrite(std::shared_ptr<IOBuffer> buf, int buf_len,
   DCHECK(!callback.is_null());  // Synchronous operation not supported
   DCHECK_GT(buf_len, 0);
 
+  EventLoop* event_loop = EventLoop::Current();
+  if (event_loop->SupportsCompletionIo()) {
+    SockaddrStorage storage;
+    struct sockaddr* addr = nullptr;
+    socklen_t addr_len = 0;
+    if (address) {
+      if (!address->ToSockAddr(storage.addr, &storage.addr_len)) {
+        return ERR_ADDRESS_INVALID;
+      }
+      addr = storage.addr;
+      addr_len = storage.addr_len;
+    }
+    write_buf_ = buf;
+    write_buf_len_ = buf_len;
+    write_callback_ = std::move(callback);
+    event_loop->SubmitSendMsg(
+        socket_, std::move(buf), buf_len, addr, addr_len,
+        sendto_flags_, &write_operation_,
+        absl::bind_front(&UDPSocketPosix::DidCompleteSendMsg, this));
+    return ERR_IO_PENDING;
+  }
+
   int result = InternalSendTo(buf, buf_len, address);
   if (result != ERR_IO_PENDING) return result;
 
@@ -515,6 +553,17 @@ int UDPSocketPosix::AllowAddressReuse() {
   return SetReuseAddr(socket_, true);
 }
 
+int UDPSocketPosix::SetBusyPoll(absl::Duration duration) {
+  DCHECK_NE(socket_, kInvalidSocket);
+  return base::SetBusyPoll(socket_, duration);
+}
+
+int UDPSocketPosix::AllowPortReuse() {
+  DCHECK_NE(socket_, kInvalidSocket);
+  DCHECK(!is_connected());
+  return SetReusePort(socket_, true);
+}
+
 int UDPSocketPosix::SetBroadcast(bool broadcast) {
   DCHECK_NE(socket_, kInvalidSocket);
   int value = broadcast ? 1 : 0;
@@ -607,6 +656,35 @@ void UDPSocketPosix::DidCompleteWrite() {
   }
 }
 
+void UDPSocketPosix::DidCompleteRecvMsg(int rv) {
+  int result;
+  if (rv < 0) {
+    result = MapSystemError(-rv);
+  } else if (read_operation_.msg_flags() & MSG_TRUNC) {
+    result = ERR_MSG_TOO_BIG;
+  } else {
+    result = rv;
+    const sockaddr* addr =
+        reinterpret_cast<const sockaddr*>(&read_operation_.address());
+    if (recv_from_address_ &&
+        !recv_from_address_->FromSockAddr(addr,
+                                          read_operation_.address_len())) {
+      result = ERR_ADDRESS_INVALID;
+    }
+  }
+
+  read_buf_.reset();
+  read_buf_len_ = 0;
+  recv_from_address_ = nullptr;
+  DoReadCallback(result);
+}
+
+void UDPSocketPosix::DidCompleteSendMsg(int rv) {
+  write_buf_.reset();
+  write_buf_len_ = 0;
+  DoWriteCallback(rv < 0 ? MapSystemError(-rv) : rv);
+}
+
 int UDPSocketPosix::InternalRecvFrom(IOBuffer* buf, int buf_len,
                                      IPEndPoint* address) {
   // If the socket is connected and the remote address is known
@@ -940,8 +1018,8 @@ int UDPSocketPosix::InternalWriteAsync(CompletionOnceCallback callback) {
 
   if (!write_async_timer_running_) {
     write_async_timer_running_ = true;
-    // write_async_timer_.Start(FROM_HERE, kWriteAsyncMsThreshold, this,
-    //                          &UDPSocketPosix::OnWriteAsyncTimerFired);
+    write_async_timer_.Start(kWriteAsyncMsThreshold, this,
+                             &UDPSocketPosix::OnWriteAsyncTimerFired);
   }
 
   int blocking_threshold =
@@ -967,7 +1045,7 @@ void UDPSocketPosix::FlushPending() {
 
   if (pending_writes_.empty()) return;
 
-  // if (write_async_timer_running_) write_async_timer_.Reset();
+  if (write_async_timer_running_) write_async_timer_.Reset();
 
   LocalSendBuffers();
 }
@@ -975,7 +1053,7 @@ void UDPSocketPosix::FlushPending() {
 void UDPSocketPosix::OnWriteAsyncTimerFired() {
   DVLOG(2) << __func__ << " pending writes " << pending_writes_.size();
   if (pending_writes_.empty()) {
-    // write_async_timer_.Stop();
+    write_async_timer_.Stop();
     write_async_timer_running_ = false;
     return;
   }
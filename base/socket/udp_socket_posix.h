@@ -27,6 +27,7 @@
 #include "base/socket/diff_serv_code_point.h"
 #include "base/socket/ip_endpoint.h"
 #include "base/socket/socket_descriptor.h"
+#include "base/timer/timer.h"
 
 #if defined(__ANDROID__) && defined(__aarch64__)
 #define HAVE_SENDMMSG 1
@@ -195,6 +196,16 @@ class BASE_EXPORT UDPSocketPosix {
   // Returns a net error code.
   int AllowAddressReuse();
 
+  // Sets SO_BUSY_POLL on the underlying socket. See SetBusyPoll() in
+  // socket_options.h. Returns a net error code.
+  int SetBusyPoll(absl::Duration duration);
+
+  // Call this to enable SO_REUSEPORT on the underlying socket, so that several
+  // sockets can bind to the same end point.
+  // Should be called between Open() and Bind().
+  // Returns a net error code.
+  int AllowPortReuse();
+
   // Call this to allow or disallow sending and receiving packets to and from
   // broadcast addresses.
   // Returns a net error code.
@@ -375,6 +386,10 @@ class BASE_EXPORT UDPSocketPosix {
   void DoWriteCallback(int rv);
   void DidCompleteRead();
   void DidCompleteWrite();
+  // Called with the results of operations submitted to an EventLoop which
+  // supports completion-based I/O.
+  void DidCompleteRecvMsg(int rv);
+  void DidCompleteSendMsg(int rv);
 
   // Same as SendTo(), except that address is passed by pointer
   // instead of by reference. It is called from Write() with |address|
@@ -460,6 +475,11 @@ class BASE_EXPORT UDPSocketPosix {
   ReadWatcher read_watcher_;
   WriteWatcher write_watcher_;
 
+  // Used instead of the watchers when the EventLoop supports completion-based
+  // I/O.
+  EventLoop::IoOperation read_operation_;
+  EventLoop::IoOperation write_operation_;
+
   // Various bits to support |WriteAsync()|.
   bool write_async_enabled_ = false;
   bool write_batching_active_ = false;
@@ -467,7 +487,7 @@ class BASE_EXPORT UDPSocketPosix {
   int written_bytes_ = 0;
 
   int last_async_result_;
-  // RepeatingTimer write_async_timer_;
+  RepeatingTimer write_async_timer_;
   bool write_async_timer_running_;
   // Total writes in flights
   int write_async_outstanding_;
@@ -0,0 +1,105 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/socket_test_util.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "absl/time/time.h"
+#include "base/socket/ip_address.h"
+#include "base/socket/socket_errors.h"
+#include "base/socket/tcp_socket.h"
+#include "base/timer/timer.h"
+
+namespace base {
+
+void ConnectLoopback(int fds[2]) {
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_LE(0, listen_fd);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t address_len = sizeof(address);
+  ASSERT_EQ(0, bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+                    address_len));
+  ASSERT_EQ(0, listen(listen_fd, 1));
+  ASSERT_EQ(0, getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address),
+                           &address_len));
+
+  fds[0] = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_LE(0, fds[0]);
+  ASSERT_EQ(0, connect(fds[0], reinterpret_cast<sockaddr*>(&address),
+                       address_len));
+  fds[1] = accept(listen_fd, nullptr, nullptr);
+  ASSERT_LE(0, fds[1]);
+  close(listen_fd);
+}
+
+int BindLoopback(int backlog, IPEndPoint* endpoint) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_LE(0, fd);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t address_len = sizeof(address);
+  EXPECT_EQ(0, bind(fd, reinterpret_cast<sockaddr*>(&address), address_len));
+  EXPECT_EQ(0, getsockname(fd, reinterpret_cast<sockaddr*>(&address),
+                           &address_len));
+  if (backlog >= 0) {
+    EXPECT_EQ(0, listen(fd, backlog));
+  }
+  *endpoint = IPEndPoint(IPAddress::IPv4Localhost(), ntohs(address.sin_port));
+  return fd;
+}
+
+bool IdleDelegate::DoIdleWork() { return false; }
+
+void RunEventLoopUntil(std::function<bool()> condition) {
+  EventLoop* event_loop = EventLoop::Current();
+  IdleDelegate delegate;
+  RepeatingTimer timer;
+  timer.Start(absl::Milliseconds(1), [&]() {
+    if (condition()) event_loop->Quit();
+  });
+  event_loop->Run(&delegate);
+}
+
+LoopbackPeerTest::LoopbackPeerTest() = default;
+
+LoopbackPeerTest::~LoopbackPeerTest() {
+  if (peer_fd_ >= 0) close(peer_fd_);
+}
+
+std::unique_ptr<TCPClientSocket> LoopbackPeerTest::ConnectToPeer() {
+  int fds[2];
+  ConnectLoopback(fds);
+  if (HasFatalFailure()) return nullptr;
+  auto tcp_socket = std::make_unique<TCPSocket>();
+  EXPECT_EQ(OK, tcp_socket->AdoptConnectedSocket(fds[0], IPEndPoint()));
+  if (peer_fd_ >= 0) close(peer_fd_);
+  peer_fd_ = fds[1];
+  return std::make_unique<TCPClientSocket>(std::move(tcp_socket),
+                                           IPEndPoint());
+}
+
+void LoopbackPeerTest::SendFromPeer(const std::string& data) {
+  ASSERT_EQ(static_cast<ssize_t>(data.size()),
+            send(peer_fd_, data.data(), data.size(), 0));
+}
+
+std::string LoopbackPeerTest::ReceiveOnPeer() {
+  char buf[256];
+  ssize_t rv = recv(peer_fd_, buf, sizeof(buf), MSG_DONTWAIT);
+  return rv > 0 ? std::string(buf, rv) : std::string();
+}
+
+void LoopbackPeerTest::RunUntil(std::function<bool()> condition) {
+  RunEventLoopUntil(std::move(condition));
+}
+
+}  // namespace base
@@ -0,0 +1,65 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TEST_SOCKET_TEST_UTIL_H_
+#define BASE_TEST_SOCKET_TEST_UTIL_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "base/event_loop/event_loop.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/tcp_client_socket.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+// Connects |fds| with each other over TCP on the loopback address. Fails the
+// current test on error.
+void ConnectLoopback(int fds[2]);
+
+// Opens a TCP socket bound to an ephemeral port of the loopback address,
+// listening with |backlog| unless it is negative, sets |*endpoint| to its
+// address and returns its file descriptor. Fails the current test on error.
+int BindLoopback(int backlog, IPEndPoint* endpoint);
+
+// An EventLoop::Delegate without idle work, for tests which run an EventLoop
+// until a callback quits it.
+class IdleDelegate : public EventLoop::Delegate {
+ public:
+  bool DoIdleWork() override;
+};
+
+// Runs the current EventLoop until |condition| holds, checking it every
+// millisecond.
+void RunEventLoopUntil(std::function<bool()> condition);
+
+// A fixture for tests of a stream socket, which runs on a loopback connection
+// whose other end, |peer_fd_|, the test drives with plain system calls.
+class LoopbackPeerTest : public testing::Test {
+ protected:
+  LoopbackPeerTest();
+  // Closes |peer_fd_|, after the members of the derived fixture are gone.
+  ~LoopbackPeerTest() override;
+
+  // Returns a socket connected to a new |peer_fd_|, or null on error.
+  std::unique_ptr<TCPClientSocket> ConnectToPeer();
+
+  void SendFromPeer(const std::string& data);
+  // Returns what the peer can receive without waiting.
+  std::string ReceiveOnPeer();
+
+  // Runs |event_loop_| until |condition| holds.
+  void RunUntil(std::function<bool()> condition);
+
+  EventLoop event_loop_;
+  IdleDelegate delegate_;
+  // The other end of the socket ConnectToPeer() returned, if any.
+  int peer_fd_ = -1;
+};
+
+}  // namespace base
+
+#endif  // BASE_TEST_SOCKET_TEST_UTIL_H_
@@ -0,0 +1,230 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/thread/thread_pool.h"
+
+#include <algorithm>
+
+#include "base/containers/work_stealing_deque.h"
+#include "base/no_destructor.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace base {
+
+class ThreadPool::Worker {
+ public:
+  Worker(ThreadPool* pool, size_t index)
+      : pool_(pool), index_(index), random_state_(index * 2654435761u + 1) {}
+  Worker(const Worker& other) = delete;
+  Worker& operator=(const Worker& other) = delete;
+
+  ThreadPool* pool() const { return pool_; }
+  size_t index() const { return index_; }
+  WorkStealingDeque<Task*>& deque() { return deque_; }
+
+  // Returns a pseudo-random number, to pick the first victim to steal from.
+  uint32_t NextRandom() {
+    // xorshift32
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 17;
+    random_state_ ^= random_state_ << 5;
+    return random_state_;
+  }
+
+ private:
+  ThreadPool* const pool_;
+  const size_t index_;
+  uint32_t random_state_;
+  WorkStealingDeque<Task*> deque_;
+};
+
+namespace {
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+void FutexWait(std::atomic<uint32_t>* address, uint32_t value) {
+  int rv = syscall(SYS_futex, reinterpret_cast<uint32_t*>(address),
+                   FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+  if (rv != 0 && errno != EAGAIN && errno != EINTR)
+    DPLOG(ERROR) << "futex(FUTEX_WAIT)";
+}
+
+void FutexWake(std::atomic<uint32_t>* address, int count) {
+  int rv = syscall(SYS_futex, reinterpret_cast<uint32_t*>(address),
+                   FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+  if (rv < 0) DPLOG(ERROR) << "futex(FUTEX_WAKE)";
+}
+#endif
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : injection_size_(0), epoch_(0), num_parked_(0), shutting_down_(false) {
+  if (num_threads == 0)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  // Every worker exists before any thread starts stealing from them.
+  for (size_t i = 0; i < num_threads; ++i)
+    workers_.emplace_back(new Worker(this, i));
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    Worker* worker = workers_[i].get();
+    threads_.emplace_back([this, worker]() { WorkerMain(worker); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  DCHECK(!IsWorkerThread());
+  shutting_down_.store(true, std::memory_order_seq_cst);
+  Unpark(true);
+  for (std::thread& thread : threads_) thread.join();
+  DCHECK(injection_queue_.empty());
+}
+
+// static
+ThreadLocalPointer<ThreadPool::Worker>& ThreadPool::CurrentWorker() {
+  static NoDestructor<ThreadLocalPointer<Worker>> current_worker;
+  return *current_worker;
+}
+
+void ThreadPool::PostTask(OnceClosure task) {
+  DCHECK(!task.is_null());
+  Task* pending = new Task(std::move(task));
+
+  Worker* worker = CurrentWorker().Get();
+  if (worker && worker->pool() == this) {
+    worker->deque().Push(pending);
+  } else {
+    std::lock_guard<std::mutex> guard(injection_lock_);
+    injection_queue_.push_back(pending);
+    injection_size_.fetch_add(1, std::memory_order_relaxed);
+  }
+  Unpark(false);
+}
+
+void ThreadPool::PostTaskAndReply(OnceClosure task, OnceClosure reply) {
+  PostTaskAndReply(std::move(task), std::move(reply), EventLoop::Current());
+}
+
+void ThreadPool::PostTaskAndReply(OnceClosure task, OnceClosure reply,
+                                  EventLoop* event_loop) {
+  DCHECK(!task.is_null());
+  DCHECK(!reply.is_null());
+  DCHECK(event_loop);
+  struct State {
+    OnceClosure task;
+    OnceClosure reply;
+  };
+  auto state = std::make_shared<State>();
+  state->task = std::move(task);
+  state->reply = std::move(reply);
+  PostTask([state, event_loop]() {
+    std::move(state->task).Run();
+    event_loop->PostTask([state]() { std::move(state->reply).Run(); });
+  });
+}
+
+bool ThreadPool::IsWorkerThread() const {
+  Worker* worker = CurrentWorker().Get();
+  return worker && worker->pool() == this;
+}
+
+void ThreadPool::WorkerMain(Worker* worker) {
+  CurrentWorker().Set(worker);
+
+  for (;;) {
+    Task* task = FindTask(worker);
+    if (!task) {
+      // Announce the intent to park before looking for work one last time,
+      // so that a concurrent PostTask() either is seen here or sees this
+      // worker parked and bumps |epoch_| past the value it waits on.
+      num_parked_.fetch_add(1, std::memory_order_seq_cst);
+      uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+      task = FindTask(worker);
+      if (!task) {
+        if (shutting_down_.load(std::memory_order_seq_cst)) {
+          num_parked_.fetch_sub(1, std::memory_order_relaxed);
+          break;
+        }
+        Park(epoch);
+      }
+      num_parked_.fetch_sub(1, std::memory_order_relaxed);
+      if (!task) continue;
+    }
+
+    std::move(task->closure).Run();
+    delete task;
+  }
+
+  CurrentWorker().Set(nullptr);
+}
+
+ThreadPool::Task* ThreadPool::FindTask(Worker* worker) {
+  Task* task;
+  if (worker->deque().Pop(&task)) return task;
+
+  if (injection_size_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> guard(injection_lock_);
+    if (!injection_queue_.empty()) {
+      task = injection_queue_.front();
+      injection_queue_.pop_front();
+      injection_size_.fetch_sub(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+
+  // A failed Steal() may have lost a race for a task, so keep sweeping the
+  // victims while any of them looks non-empty.
+  size_t num_workers = workers_.size();
+  bool retry = true;
+  while (retry) {
+    retry = false;
+    size_t start = worker->NextRandom() % num_workers;
+    for (size_t i = 0; i < num_workers; ++i) {
+      Worker* victim = workers_[(start + i) % num_workers].get();
+      if (victim == worker) continue;
+      if (victim->deque().Steal(&task)) return task;
+      if (!victim->deque().empty()) retry = true;
+    }
+  }
+  return nullptr;
+}
+
+void ThreadPool::Park(uint32_t epoch) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  FutexWait(&epoch_, epoch);
+#else
+  std::unique_lock<std::mutex> guard(park_lock_);
+  park_cv_.wait(guard, [this, epoch]() {
+    return epoch_.load(std::memory_order_seq_cst) != epoch;
+  });
+#endif
+}
+
+void ThreadPool::Unpark(bool all) {
+  // A worker which is about to park has either read the new |epoch_|, and
+  // then sees the work when it looks once more, or it is counted in
+  // |num_parked_| and gets woken up.
+  epoch_.fetch_add(1, std::memory_order_seq_cst);
+  if (num_parked_.load(std::memory_order_seq_cst) == 0) return;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  FutexWake(&epoch_, all ? INT32_MAX : 1);
+#else
+  {
+    std::lock_guard<std::mutex> guard(park_lock_);
+  }
+  if (all) {
+    park_cv_.notify_all();
+  } else {
+    park_cv_.notify_one();
+  }
+#endif
+}
+
+}  // namespace base
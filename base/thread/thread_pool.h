@@ -0,0 +1,158 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_THREAD_THREAD_POOL_H_
+#define BASE_THREAD_THREAD_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "base/build_config.h"
+#include "base/callback.h"
+#include "base/event_loop/event_loop.h"
+#include "base/export.h"
+#include "base/logging.h"
+#include "base/thread/thread_local.h"
+
+#if !defined(OS_LINUX) && !defined(OS_ANDROID)
+#include <condition_variable>
+#endif
+
+namespace base {
+
+// A pool of worker threads which run OnceClosures, meant for CPU-heavy work,
+// such as parsing or compression, which would otherwise stall the EventLoop
+// that received the request.
+//
+// Each worker has its own WorkStealingDeque. A task posted from a worker goes
+// to the bottom of that worker's deque, where it is likely to run next on a
+// warm cache, and a task posted from any other thread goes to a shared queue.
+// A worker which runs out of work takes from the shared queue, then steals
+// from the top of the other workers' deques, and parks once there is nothing
+// left anywhere, on a futex on Linux and Android. Tasks may run in any order.
+//
+// PostTaskAndReply() returns the result to an EventLoop with
+// EventLoop::PostTask(), so that the event loop never blocks on the pool:
+//
+//   pool->PostTaskAndReplyWithResult<Response>(
+//       [request]() { return Parse(request); },
+//       [this](Response response) { Send(std::move(response)); });
+class BASE_EXPORT ThreadPool {
+ public:
+  // Starts |num_threads| workers, or one per CPU if it is 0.
+  explicit ThreadPool(size_t num_threads = 0);
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+  // Runs the tasks which have been posted, and joins the workers. Tasks
+  // posted by those tasks run as well.
+  ~ThreadPool();
+
+  size_t size() const { return workers_.size(); }
+
+  // Thread-safe.
+  void PostTask(OnceClosure task);
+
+  // Runs |task| on the pool, then |reply| on |event_loop|, which must outlive
+  // the call to |task|. Must be called on |event_loop|'s thread, unless
+  // |event_loop| is given explicitly.
+  void PostTaskAndReply(OnceClosure task, OnceClosure reply);
+  void PostTaskAndReply(OnceClosure task, OnceClosure reply,
+                        EventLoop* event_loop);
+
+  // Like PostTaskAndReply(), but passes the result of |task| to |reply|. |R|
+  // must be default constructible and movable.
+  template <typename R>
+  void PostTaskAndReplyWithResult(OnceCallback<R()> task,
+                                  OnceCallback<void(R)> reply) {
+    PostTaskAndReplyWithResult(std::move(task), std::move(reply),
+                               EventLoop::Current());
+  }
+  template <typename R>
+  void PostTaskAndReplyWithResult(OnceCallback<R()> task,
+                                  OnceCallback<void(R)> reply,
+                                  EventLoop* event_loop);
+
+  // Returns true if the calling thread is one of this pool's workers.
+  bool IsWorkerThread() const;
+
+ private:
+  class Worker;
+
+  struct Task {
+    explicit Task(OnceClosure closure) : closure(std::move(closure)) {}
+
+    OnceClosure closure;
+  };
+
+  // The worker the calling thread runs, if any.
+  static ThreadLocalPointer<Worker>& CurrentWorker();
+
+  // Runs on the thread of |worker|.
+  void WorkerMain(Worker* worker);
+
+  // Returns the next task for |worker| or null if none could be found.
+  Task* FindTask(Worker* worker);
+
+  // Parks the calling worker until work may be available, unless |epoch|
+  // is stale.
+  void Park(uint32_t epoch);
+
+  // Unparks a worker if any is parked, or every worker if |all| is true.
+  void Unpark(bool all);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // Tasks posted from other threads.
+  std::mutex injection_lock_;
+  std::deque<Task*> injection_queue_;
+  std::atomic<size_t> injection_size_;
+
+  // Incremented whenever work is added. Parked workers wait for it to change.
+  std::atomic<uint32_t> epoch_;
+  std::atomic<size_t> num_parked_;
+  std::atomic<bool> shutting_down_;
+
+#if !defined(OS_LINUX) && !defined(OS_ANDROID)
+  std::mutex park_lock_;
+  std::condition_variable park_cv_;
+#endif
+};
+
+template <typename R>
+void ThreadPool::PostTaskAndReplyWithResult(OnceCallback<R()> task,
+                                            OnceCallback<void(R)> reply,
+                                            EventLoop* event_loop) {
+  DCHECK(!task.is_null());
+  DCHECK(!reply.is_null());
+  DCHECK(event_loop);
+  // OnceCallback can't be captured by the copyable closures, so the state of
+  // the exchange is shared instead.
+  struct State {
+    OnceCallback<R()> task;
+    OnceCallback<void(R)> reply;
+    R result;
+  };
+  auto state = std::make_shared<State>();
+  state->task = std::move(task);
+  state->reply = std::move(reply);
+  PostTask([state, event_loop]() {
+    state->result = std::move(state->task).Run();
+    event_loop->PostTask([state]() {
+      std::move(state->reply).Run(std::move(state->result));
+    });
+  });
+}
+
+}  // namespace base
+
+#endif  // BASE_THREAD_THREAD_POOL_H_
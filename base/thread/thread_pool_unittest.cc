@@ -0,0 +1,84 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/thread/thread_pool.h"
+
+#include <atomic>
+#include <functional>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class IdleDelegate : public EventLoop::Delegate {
+ public:
+  bool DoIdleWork() override { return false; }
+};
+
+}  // namespace
+
+TEST(ThreadPoolTest, RunsEveryTask) {
+  constexpr int kNumTasks = 10000;
+  std::atomic<int> count(0);
+  {
+    ThreadPool pool(4);
+    EXPECT_EQ(4u, pool.size());
+    for (int i = 0; i < kNumTasks; ++i) {
+      pool.PostTask([&count]() { count.fetch_add(1); });
+    }
+  }
+  EXPECT_EQ(kNumTasks, count.load());
+}
+
+TEST(ThreadPoolTest, TasksPostedFromWorkersAreStolen) {
+  // A single task fans out from one worker, whose deque the others steal
+  // from.
+  constexpr int kDepth = 12;
+  std::atomic<int> count(0);
+  // Outlives |pool|, whose destructor runs the remaining tasks.
+  std::function<void(int)> fan_out;
+  {
+    ThreadPool pool(4);
+    fan_out = [&](int depth) {
+      EXPECT_TRUE(pool.IsWorkerThread());
+      count.fetch_add(1);
+      if (depth == 0) return;
+      pool.PostTask([&fan_out, depth]() { fan_out(depth - 1); });
+      pool.PostTask([&fan_out, depth]() { fan_out(depth - 1); });
+    };
+    pool.PostTask([&fan_out]() { fan_out(kDepth); });
+  }
+  EXPECT_EQ((1 << (kDepth + 1)) - 1, count.load());
+}
+
+TEST(ThreadPoolTest, PostTaskAndReplyWithResult) {
+  EventLoop event_loop;
+  ThreadPool pool(2);
+  EXPECT_FALSE(pool.IsWorkerThread());
+
+  constexpr int kNumTasks = 100;
+  int num_replies = 0;
+  int sum = 0;
+  for (int i = 0; i < kNumTasks; ++i) {
+    pool.PostTaskAndReplyWithResult<int>(
+        [&pool, i]() {
+          EXPECT_TRUE(pool.IsWorkerThread());
+          return i * i;
+        },
+        [&](int result) {
+          EXPECT_EQ(&event_loop, EventLoop::Current());
+          sum += result;
+          if (++num_replies == kNumTasks) event_loop.Quit();
+        });
+  }
+  IdleDelegate delegate;
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(kNumTasks, num_replies);
+  EXPECT_EQ((kNumTasks - 1) * kNumTasks * (2 * kNumTasks - 1) / 6, sum);
+}
+
+}  // namespace base
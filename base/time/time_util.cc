@@ -11,6 +11,8 @@
 
 #include "base/time/time_util.h"
 
+#include <chrono>
+
 #include "absl/base/casts.h"
 #include "base/logging.h"
 #include "base/numerics/checked_math.h"
@@ -79,6 +81,10 @@ void MicrosecondsToFileTime(int64_t us, FILETIME* ft) {
 
 }  // namespace
 
+absl::Duration MonotonicNow() {
+  return absl::FromChrono(std::chrono::steady_clock::now().time_since_epoch());
+}
+
 #if defined(OS_MACOSX) && !defined(OS_IOS)
 absl::Time FromMachAbsoluteTime(uint64_t mach_absolute_time) {
   return absl::time_internal::FromUnixDuration(
@@ -15,6 +15,11 @@
 
 namespace base {
 
+// Returns the time elapsed since an unspecified, fixed point in the past on a
+// clock that never goes backwards. Only differences between two values are
+// meaningful, which makes it suitable for scheduling deadlines.
+BASE_EXPORT absl::Duration MonotonicNow();
+
 #if defined(OS_MACOSX) && !defined(OS_IOS)
 BASE_EXPORT absl::Time FromMachAbsoluteTime(uint64_t mach_absolute_time);
 #endif
@@ -0,0 +1,95 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/timer/timer.h"
+
+#include <utility>
+
+#include "base/event_loop/event_loop.h"
+#include "base/logging.h"
+
+namespace base {
+namespace internal {
+
+TimerBase::TimerBase() = default;
+
+TimerBase::~TimerBase() = default;
+
+bool TimerBase::IsRunning() const { return IsScheduled(); }
+
+void TimerBase::Stop() {
+  Cancel();
+  OnStop();
+}
+
+void TimerBase::Reset() {
+  DCHECK(HasUserTask());
+  StartInternal(delay_);
+}
+
+void TimerBase::StartInternal(absl::Duration delay) {
+  EventLoop* event_loop = EventLoop::Current();
+  DCHECK(event_loop) << "Timers need an EventLoop on the current thread";
+  delay_ = delay;
+  event_loop->ScheduleTimer(this, delay);
+}
+
+void TimerBase::OnExpired() { RunUserTask(); }
+
+}  // namespace internal
+
+OneShotTimer::OneShotTimer() = default;
+
+OneShotTimer::~OneShotTimer() = default;
+
+void OneShotTimer::Start(absl::Duration delay, OnceClosure user_task) {
+  DCHECK(!user_task.is_null());
+  user_task_ = std::move(user_task);
+  StartInternal(delay);
+}
+
+void OneShotTimer::FireNow() {
+  DCHECK(IsRunning());
+  OnceClosure task = std::move(user_task_);
+  Stop();
+  std::move(task).Run();
+}
+
+bool OneShotTimer::HasUserTask() const { return !user_task_.is_null(); }
+
+void OneShotTimer::OnStop() { user_task_.Reset(); }
+
+void OneShotTimer::RunUserTask() {
+  // The task may destroy |this|, so it must be taken out first.
+  OnceClosure task = std::move(user_task_);
+  std::move(task).Run();
+}
+
+RepeatingTimer::RepeatingTimer() = default;
+
+RepeatingTimer::~RepeatingTimer() = default;
+
+void RepeatingTimer::Start(absl::Duration delay, RepeatingClosure user_task) {
+  DCHECK(!user_task.is_null());
+  user_task_ = std::move(user_task);
+  StartInternal(delay);
+}
+
+bool RepeatingTimer::HasUserTask() const { return !user_task_.is_null(); }
+
+void RepeatingTimer::OnStop() {}
+
+void RepeatingTimer::RunUserTask() {
+  // Schedule the next run before running the task, which may stop or destroy
+  // |this|.
+  Reset();
+  RepeatingClosure task = user_task_;
+  std::move(task).Run();
+}
+
+}  // namespace base
@@ -0,0 +1,160 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// OneShotTimer and RepeatingTimer provide a simple timer API. As the names
+// suggest, OneShotTimer calls you back once after a time delay expires.
+// RepeatingTimer on the other hand calls you back periodically with the
+// prescribed time interval.
+//
+// OneShotTimer and RepeatingTimer both cancel the timer when they go out of
+// scope, which makes it easy to ensure that you do not get called when your
+// object has gone out of scope. Just instantiate a OneShotTimer or
+// RepeatingTimer as a member variable of the class for which you wish to
+// receive timer events.
+//
+// Sample RepeatingTimer usage:
+//
+//   class MyClass {
+//    public:
+//     void StartDoingStuff() {
+//       timer_.Start(absl::Seconds(1), this, &MyClass::DoStuff);
+//     }
+//     void StopDoingStuff() { timer_.Stop(); }
+//
+//    private:
+//     void DoStuff() {
+//       // This method is called every second to do stuff.
+//       ...
+//     }
+//     base::RepeatingTimer timer_;
+//   };
+//
+// Timers run on the EventLoop of the thread which started them and are kept
+// in its TimingWheel, so starting, resetting and stopping a timer never
+// allocate.
+
+#ifndef BASE_TIMER_TIMER_H_
+#define BASE_TIMER_TIMER_H_
+
+#include "absl/functional/bind_front.h"
+#include "absl/time/time.h"
+#include "base/callback.h"
+#include "base/event_loop/timing_wheel.h"
+#include "base/export.h"
+
+namespace base {
+
+class EventLoop;
+
+namespace internal {
+
+class BASE_EXPORT TimerBase : private TimingWheel::Entry {
+ public:
+  TimerBase();
+  TimerBase(const TimerBase& other) = delete;
+  TimerBase& operator=(const TimerBase& other) = delete;
+  ~TimerBase() override;
+
+  // Returns true if the timer is running (i.e., not stopped).
+  bool IsRunning() const;
+
+  // Returns the current delay for this timer.
+  absl::Duration GetCurrentDelay() const { return delay_; }
+
+  // Call this method to stop and cancel the timer. It is a no-op if the timer
+  // is not running.
+  void Stop();
+
+  // Call this method to reset the timer delay. The user task must be set. If
+  // the timer is not running, this will start it.
+  void Reset();
+
+ protected:
+  // Schedules the timer on the current EventLoop with |delay|.
+  void StartInternal(absl::Duration delay);
+
+  virtual bool HasUserTask() const = 0;
+  virtual void OnStop() = 0;
+  virtual void RunUserTask() = 0;
+
+ private:
+  // TimingWheel::Entry methods
+  void OnExpired() override;
+
+  absl::Duration delay_;
+};
+
+}  // namespace internal
+
+// A simple, one-shot timer. See usage notes at the top of the file.
+class BASE_EXPORT OneShotTimer : public internal::TimerBase {
+ public:
+  OneShotTimer();
+  OneShotTimer(const OneShotTimer& other) = delete;
+  OneShotTimer& operator=(const OneShotTimer& other) = delete;
+  ~OneShotTimer() override;
+
+  // Start the timer to run at the given |delay| from now. If the timer is
+  // already running, it will be replaced to call the given |user_task|.
+  void Start(absl::Duration delay, OnceClosure user_task);
+
+  // Start the timer to run at the given |delay| from now. If the timer is
+  // already running, it will be replaced to call a task formed from
+  // |receiver->*method|.
+  template <typename Receiver>
+  void Start(absl::Duration delay, Receiver* receiver,
+             void (Receiver::*method)()) {
+    Start(delay, OnceClosure(absl::bind_front(method, receiver)));
+  }
+
+  // Run the scheduled task immediately, and stop the timer. The timer needs to
+  // be running.
+  void FireNow();
+
+ private:
+  // internal::TimerBase methods
+  bool HasUserTask() const override;
+  void OnStop() override;
+  void RunUserTask() override;
+
+  OnceClosure user_task_;
+};
+
+// A simple, repeating timer. See usage notes at the top of the file.
+class BASE_EXPORT RepeatingTimer : public internal::TimerBase {
+ public:
+  RepeatingTimer();
+  RepeatingTimer(const RepeatingTimer& other) = delete;
+  RepeatingTimer& operator=(const RepeatingTimer& other) = delete;
+  ~RepeatingTimer() override;
+
+  // Start the timer to run every |delay| from now. If the timer is already
+  // running, it will be replaced to call the given |user_task|.
+  void Start(absl::Duration delay, RepeatingClosure user_task);
+
+  // Start the timer to run every |delay| from now. If the timer is already
+  // running, it will be replaced to call a task formed from
+  // |receiver->*method|.
+  template <typename Receiver>
+  void Start(absl::Duration delay, Receiver* receiver,
+             void (Receiver::*method)()) {
+    Start(delay, RepeatingClosure(absl::bind_front(method, receiver)));
+  }
+
+ private:
+  // internal::TimerBase methods
+  bool HasUserTask() const override;
+  void OnStop() override;
+  void RunUserTask() override;
+
+  RepeatingClosure user_task_;
+};
+
+}  // namespace base
+
+#endif  // BASE_TIMER_TIMER_H_
@@ -0,0 +1,114 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/timer/timer.h"
+
+#include "base/event_loop/event_loop.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class IdleDelegate : public EventLoop::Delegate {
+ public:
+  bool DoIdleWork() override { return false; }
+};
+
+class Receiver {
+ public:
+  void OnTimerFired() { ++count_; }
+
+  int count() const { return count_; }
+
+ private:
+  int count_ = 0;
+};
+
+}  // namespace
+
+TEST(TimerTest, OneShotTimer) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  Receiver receiver;
+  OneShotTimer timer;
+  timer.Start(absl::Milliseconds(5), &receiver, &Receiver::OnTimerFired);
+  EXPECT_TRUE(timer.IsRunning());
+  EXPECT_EQ(absl::Milliseconds(5), timer.GetCurrentDelay());
+
+  event_loop.PostDelayedTask([&event_loop]() { event_loop.Quit(); },
+                             absl::Milliseconds(20));
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(1, receiver.count());
+  EXPECT_FALSE(timer.IsRunning());
+}
+
+TEST(TimerTest, OneShotTimerStop) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  bool fired = false;
+  OneShotTimer timer;
+  timer.Start(absl::Milliseconds(5), [&fired]() { fired = true; });
+  timer.Stop();
+  EXPECT_FALSE(timer.IsRunning());
+
+  event_loop.PostDelayedTask([&event_loop]() { event_loop.Quit(); },
+                             absl::Milliseconds(20));
+  event_loop.Run(&delegate);
+
+  EXPECT_FALSE(fired);
+}
+
+TEST(TimerTest, OneShotTimerFireNow) {
+  EventLoop event_loop;
+
+  bool fired = false;
+  OneShotTimer timer;
+  timer.Start(absl::Seconds(10), [&fired]() { fired = true; });
+  timer.FireNow();
+  EXPECT_TRUE(fired);
+  EXPECT_FALSE(timer.IsRunning());
+}
+
+TEST(TimerTest, RepeatingTimer) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  int count = 0;
+  RepeatingTimer timer;
+  timer.Start(absl::Milliseconds(2), [&]() {
+    if (++count == 5) {
+      timer.Stop();
+      event_loop.Quit();
+    }
+  });
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(5, count);
+  EXPECT_FALSE(timer.IsRunning());
+}
+
+TEST(TimerTest, RepeatingTimerReset) {
+  EventLoop event_loop;
+  IdleDelegate delegate;
+
+  Receiver receiver;
+  RepeatingTimer timer;
+  timer.Start(absl::Milliseconds(20), &receiver, &Receiver::OnTimerFired);
+  // Keep postponing the timer so that it never gets a chance to fire.
+  RepeatingTimer postponer;
+  postponer.Start(absl::Milliseconds(5), [&timer]() { timer.Reset(); });
+
+  event_loop.PostDelayedTask([&event_loop]() { event_loop.Quit(); },
+                             absl::Milliseconds(50));
+  event_loop.Run(&delegate);
+
+  EXPECT_EQ(0, receiver.count());
+  EXPECT_TRUE(timer.IsRunning());
+}
+
+}  // namespace base
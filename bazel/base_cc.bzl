@@ -1,4 +1,4 @@
-load("@com_chokobole_bazel_utils//:conditions.bzl", "if_windows")
+load("@com_chokobole_bazel_utils//:conditions.bzl", "if_posix", "if_windows")
 load("@com_chokobole_bazel_utils//:cxxopts.bzl", "cxx14")
 load("@com_chokobole_bazel_utils//:dsym.bzl", "dsym")
 load("@com_chokobole_bazel_utils//:local_defines_win.bzl", "lean_and_mean")
@@ -9,6 +9,12 @@ def base_copts():
 def base_cxxopts():
     return base_copts() + cxx14()
 
+# For the targets which need C++20, e.g. for coroutines. Tag them with "cxx20",
+# so that toolchains without C++20 can skip them with
+# --build_tag_filters=-cxx20 --test_tag_filters=-cxx20.
+def base_cxx20opts():
+    return base_copts() + if_posix(["-std=c++20"]) + if_windows(["/std:c++20"])
+
 def base_local_defines():
     return if_windows(lean_and_mean())
 
@@ -62,6 +68,23 @@ def base_cc_binary(
 
     dsym(name = name)
 
+def base_cc_benchmark(
+        name,
+        copts = base_cxxopts(),
+        local_defines = base_local_defines(),
+        deps = [],
+        tags = [],
+        **kwargs):
+    native.cc_binary(
+        name = name,
+        copts = copts,
+        local_defines = local_defines,
+        deps = deps + ["@com_github_google_benchmark//:benchmark_main"],
+        tags = tags + ["benchmark"],
+        testonly = 1,
+        **kwargs
+    )
+
 def base_cc_test(
         name,
         copts = base_cxxopts(),
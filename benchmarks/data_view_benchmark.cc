@@ -0,0 +1,82 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/data_view.h"
+#include "benchmark/benchmark.h"
+
+namespace base {
+
+namespace {
+
+constexpr size_t kBufferSize = 4096;
+
+// Reads a buffer as consecutive values of |T|, in little endian if
+// |range(0)| is 1 and in big endian otherwise.
+template <typename T>
+void BM_ConstDataViewRead(benchmark::State& state) {
+  bool little_endian = state.range(0) != 0;
+  std::vector<char> buffer(kBufferSize);
+  for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = static_cast<char>(i);
+  ConstDataView view(buffer.data(), buffer.size());
+
+  for (auto _ : state) {
+    T sum = 0;
+    for (size_t offset = 0; offset + sizeof(T) <= kBufferSize;
+         offset += sizeof(T)) {
+      T value = 0;
+      view.Read(offset, &value, little_endian);
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * kBufferSize);
+}
+BENCHMARK_TEMPLATE(BM_ConstDataViewRead, uint16_t)
+    ->ArgName("little_endian")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_TEMPLATE(BM_ConstDataViewRead, uint32_t)
+    ->ArgName("little_endian")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_TEMPLATE(BM_ConstDataViewRead, uint64_t)
+    ->ArgName("little_endian")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_TEMPLATE(BM_ConstDataViewRead, double)
+    ->ArgName("little_endian")
+    ->Arg(0)
+    ->Arg(1);
+
+template <typename T>
+void BM_DataViewWrite(benchmark::State& state) {
+  bool little_endian = state.range(0) != 0;
+  std::vector<char> buffer(kBufferSize);
+  DataView view(buffer.data(), buffer.size());
+
+  for (auto _ : state) {
+    for (size_t offset = 0; offset + sizeof(T) <= kBufferSize;
+         offset += sizeof(T)) {
+      view.Write(offset, static_cast<T>(offset), little_endian);
+    }
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kBufferSize);
+}
+BENCHMARK_TEMPLATE(BM_DataViewWrite, uint32_t)
+    ->ArgName("little_endian")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_TEMPLATE(BM_DataViewWrite, uint64_t)
+    ->ArgName("little_endian")
+    ->Arg(0)
+    ->Arg(1);
+
+}  // namespace
+
+}  // namespace base
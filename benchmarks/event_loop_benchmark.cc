@@ -0,0 +1,140 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base/event_loop/event_loop.h"
+#include "base/event_loop/event_loop_group.h"
+#include "base/logging.h"
+#include "benchmark/benchmark.h"
+
+namespace base {
+
+namespace {
+
+class IdleDelegate : public EventLoop::Delegate {
+ public:
+  bool DoIdleWork() override { return false; }
+};
+
+// Runs a benchmark once per backend, passing it as the first argument.
+void ForEachBackend(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("backend");
+  benchmark->Arg(static_cast<int>(EventLoop::Backend::kLibevent));
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  benchmark->Arg(static_cast<int>(EventLoop::Backend::kEpoll));
+#endif
+#if defined(OS_LINUX)
+  benchmark->Arg(static_cast<int>(EventLoop::Backend::kIoUring));
+#endif
+}
+
+EventLoop::Backend GetBackend(const benchmark::State& state) {
+  return static_cast<EventLoop::Backend>(state.range(0));
+}
+
+// A round trip of tasks between two event loops on different threads, which
+// is two wakeups of a blocked event loop.
+void BM_CrossThreadWakeup(benchmark::State& state) {
+  EventLoopGroup::Options options;
+  options.size = 1;
+  options.backend = GetBackend(state);
+  options.pin_threads = false;
+  EventLoopGroup group(options);
+  EventLoop* remote = group.event_loop(0);
+
+  EventLoop event_loop(GetBackend(state));
+  IdleDelegate delegate;
+  for (auto _ : state) {
+    remote->PostTask([&event_loop]() {
+      event_loop.PostTask([&event_loop]() { event_loop.Quit(); });
+    });
+    event_loop.Run(&delegate);
+  }
+  group.Stop();
+}
+BENCHMARK(BM_CrossThreadWakeup)->Apply(ForEachBackend)->UseRealTime();
+
+// Posting to the event loop of the current thread, which never wakes it up.
+void BM_PostTaskSameThread(benchmark::State& state) {
+  constexpr int kBatchSize = 1000;
+
+  EventLoop event_loop(GetBackend(state));
+  IdleDelegate delegate;
+  for (auto _ : state) {
+    int count = 0;
+    for (int i = 0; i < kBatchSize; ++i) {
+      event_loop.PostTask([&]() {
+        if (++count == kBatchSize) event_loop.Quit();
+      });
+    }
+    event_loop.Run(&delegate);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_PostTaskSameThread)->Apply(ForEachBackend);
+
+// Watching a readable file descriptor again from its own callback, which is
+// what a socket does after every read.
+void BM_WatchFileDescriptorRearm(benchmark::State& state) {
+  constexpr int kBatchSize = 1000;
+
+  int fds[2];
+  CHECK_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds));
+  // The byte is never read, so the file descriptor stays readable.
+  char c = 0;
+  CHECK_EQ(1, send(fds[1], &c, 1, 0));
+
+  class RearmWatcher : public EventLoop::FdWatcher {
+   public:
+    RearmWatcher(EventLoop* event_loop, int fd)
+        : event_loop_(event_loop), fd_(fd) {}
+
+    void Start() {
+      remaining_ = kBatchSize;
+      Watch();
+    }
+
+    // EventLoop::FdWatcher methods
+    void OnFileCanRead(int fd) override {
+      if (--remaining_ == 0) {
+        event_loop_->Quit();
+        return;
+      }
+      Watch();
+    }
+    void OnFileCanWrite(int fd) override {}
+
+   private:
+    void Watch() {
+      CHECK(event_loop_->WatchFileDescriptor(fd_, false, EventLoop::WATCH_READ,
+                                             &controller_, this));
+    }
+
+    EventLoop* const event_loop_;
+    const int fd_;
+    int remaining_ = 0;
+    EventLoop::FdWatchController controller_;
+  };
+
+  {
+    EventLoop event_loop(GetBackend(state));
+    IdleDelegate delegate;
+    RearmWatcher watcher(&event_loop, fds[0]);
+    for (auto _ : state) {
+      watcher.Start();
+      event_loop.Run(&delegate);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+BENCHMARK(BM_WatchFileDescriptorRearm)->Apply(ForEachBackend);
+
+}  // namespace
+
+}  // namespace base
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "benchmark/benchmark.h"
+
+namespace base {
+
+namespace {
+
+// The same shuffled keys on every run, so that the results are comparable.
+std::vector<int> MakeKeys(int size) {
+  std::vector<int> keys(size);
+  for (int i = 0; i < size; ++i) keys[i] = i * 2;
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  return keys;
+}
+
+template <typename Map>
+void BM_Insert(benchmark::State& state) {
+  std::vector<int> keys = MakeKeys(state.range(0));
+  for (auto _ : state) {
+    Map map;
+    for (int key : keys) map[key] = key;
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_Insert, flat_map<int, int>)->RangeMultiplier(4)->Range(
+    16, 4096);
+BENCHMARK_TEMPLATE(BM_Insert, std::map<int, int>)->RangeMultiplier(4)->Range(
+    16, 4096);
+
+// Looks up every key, and as many keys which are missing.
+template <typename Map>
+void BM_Find(benchmark::State& state) {
+  std::vector<int> keys = MakeKeys(state.range(0));
+  Map map;
+  for (int key : keys) map[key] = key;
+  for (auto _ : state) {
+    for (int key : keys) {
+      benchmark::DoNotOptimize(map.find(key));
+      benchmark::DoNotOptimize(map.find(key + 1));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size() * 2);
+}
+BENCHMARK_TEMPLATE(BM_Find, flat_map<int, int>)->RangeMultiplier(4)->Range(
+    16, 4096);
+BENCHMARK_TEMPLATE(BM_Find, std::map<int, int>)->RangeMultiplier(4)->Range(
+    16, 4096);
+
+template <typename Map>
+void BM_Iterate(benchmark::State& state) {
+  std::vector<int> keys = MakeKeys(state.range(0));
+  Map map;
+  for (int key : keys) map[key] = key;
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& item : map) sum += item.second;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_Iterate, flat_map<int, int>)->RangeMultiplier(4)->Range(
+    16, 4096);
+BENCHMARK_TEMPLATE(BM_Iterate, std::map<int, int>)->RangeMultiplier(4)->Range(
+    16, 4096);
+
+}  // namespace
+
+}  // namespace base
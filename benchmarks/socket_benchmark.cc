@@ -0,0 +1,98 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include "base/event_loop/event_loop.h"
+#include "base/io_buffer.h"
+#include "base/logging.h"
+#include "base/socket/sockaddr_storage.h"
+#include "base/socket/socket_errors.h"
+#include "base/socket/socket_posix.h"
+#include "benchmark/benchmark.h"
+
+namespace base {
+
+namespace {
+
+enum class Transport {
+  kSocketPair,
+  kLoopback,
+};
+
+// Connects |fds| with each other over |transport|.
+void Connect(Transport transport, int fds[2]) {
+  if (transport == Transport::kSocketPair) {
+    CHECK_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    return;
+  }
+
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(listen_fd >= 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t address_len = sizeof(address);
+  PCHECK(bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+              address_len) == 0);
+  PCHECK(listen(listen_fd, 1) == 0);
+  PCHECK(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address),
+                     &address_len) == 0);
+
+  fds[0] = socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(fds[0] >= 0);
+  PCHECK(connect(fds[0], reinterpret_cast<sockaddr*>(&address),
+                 address_len) == 0);
+  fds[1] = accept(listen_fd, nullptr, nullptr);
+  PCHECK(fds[1] >= 0);
+  close(listen_fd);
+}
+
+// Writes and then reads back |range(1)| bytes through a pair of connected
+// SocketPosix, neither of which ever has to wait.
+void BM_SocketPosixWriteRead(benchmark::State& state) {
+  Transport transport = static_cast<Transport>(state.range(0));
+  int size = static_cast<int>(state.range(1));
+
+  EventLoop event_loop;
+  int fds[2];
+  Connect(transport, fds);
+  SocketPosix writer;
+  SocketPosix reader;
+  CHECK_EQ(OK, writer.AdoptConnectedSocket(fds[0], SockaddrStorage()));
+  CHECK_EQ(OK, reader.AdoptConnectedSocket(fds[1], SockaddrStorage()));
+
+  std::shared_ptr<IOBuffer> write_buf = std::make_shared<IOBuffer>(size);
+  memset(write_buf->data(), 'a', size);
+  std::shared_ptr<IOBuffer> read_buf = std::make_shared<IOBuffer>(size);
+  for (auto _ : state) {
+    int rv = writer.Write(write_buf, size, [](int rv) { NOTREACHED(); });
+    CHECK_EQ(size, rv);
+    int read = 0;
+    while (read < size) {
+      rv = reader.Read(read_buf, size - read, [](int rv) { NOTREACHED(); });
+      CHECK_GT(rv, 0);
+      read += rv;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_SocketPosixWriteRead)
+    ->ArgNames({"transport", "size"})
+    ->Apply([](benchmark::internal::Benchmark* benchmark) {
+      for (Transport transport :
+           {Transport::kSocketPair, Transport::kLoopback}) {
+        for (int size : {64, 1024, 16 * 1024})
+          benchmark->Args({static_cast<int>(transport), size});
+      }
+    });
+
+}  // namespace
+
+}  // namespace base
@@ -0,0 +1,106 @@
+// Copyright (c) 2020 The Base Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "base/event_loop/event_loop.h"
+#include "base/logging.h"
+#include "base/socket/ip_address.h"
+#include "base/socket/ip_endpoint.h"
+#include "base/socket/socket_errors.h"
+#include "base/socket/udp_socket_posix.h"
+#include "benchmark/benchmark.h"
+
+namespace base {
+
+namespace {
+
+class IdleDelegate : public EventLoop::Delegate {
+ public:
+  bool DoIdleWork() override { return false; }
+};
+
+// Opens a UDP socket bound to an ephemeral port of the loopback address and
+// returns its file descriptor.
+int BindReceiver(uint16_t* port) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  PCHECK(fd >= 0);
+  int buffer_size = 4 * 1024 * 1024;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t address_len = sizeof(address);
+  PCHECK(bind(fd, reinterpret_cast<sockaddr*>(&address), address_len) == 0);
+  PCHECK(getsockname(fd, reinterpret_cast<sockaddr*>(&address),
+                     &address_len) == 0);
+  *port = ntohs(address.sin_port);
+  return fd;
+}
+
+// Batched UDPSocketPosix::WriteAsync() of |range(1)| byte datagrams, sent with
+// sendmmsg() if |range(0)| is 1 and with one send() each otherwise.
+void BM_UDPSocketPosixWriteAsync(benchmark::State& state) {
+  constexpr int kBatchSize = 64;
+  bool sendmmsg_enabled = state.range(0) != 0;
+  size_t size = static_cast<size_t>(state.range(1));
+
+  EventLoop event_loop;
+  IdleDelegate delegate;
+  uint16_t port;
+  int receiver = BindReceiver(&port);
+
+  UDPSocketPosix sender(DatagramSocket::DEFAULT_BIND);
+  CHECK_EQ(OK, sender.Open(ADDRESS_FAMILY_IPV4));
+  CHECK_EQ(OK, sender.Connect(IPEndPoint(IPAddress::IPv4Localhost(), port)));
+  sender.SetMaxPacketSize(size);
+  sender.SetWriteBatchingActive(true);
+  sender.SetSendmmsgEnabled(sendmmsg_enabled);
+
+  std::vector<char> datagram(size, 'a');
+  std::vector<char> read_buf(size);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      int rv = sender.WriteAsync(datagram.data(), size, [&](int rv) {
+        CHECK_GE(rv, 0);
+        event_loop.Quit();
+      });
+      if (rv == ERR_IO_PENDING) {
+        event_loop.Run(&delegate);
+      } else {
+        CHECK_GE(rv, 0);
+      }
+    }
+
+    state.PauseTiming();
+    while (recv(receiver, read_buf.data(), read_buf.size(), 0) > 0) {
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  state.SetBytesProcessed(state.iterations() * kBatchSize * size);
+
+  sender.Close();
+  close(receiver);
+}
+BENCHMARK(BM_UDPSocketPosixWriteAsync)
+    ->ArgNames({"sendmmsg", "size"})
+    ->Apply([](benchmark::internal::Benchmark* benchmark) {
+#if HAVE_SENDMMSG
+      std::vector<int> sendmmsg_enabled = {0, 1};
+#else
+      std::vector<int> sendmmsg_enabled = {0};
+#endif
+      for (int enabled : sendmmsg_enabled) {
+        for (int size : {64, 1200}) benchmark->Args({enabled, size});
+      }
+    });
+
+}  // namespace
+
+}  // namespace base